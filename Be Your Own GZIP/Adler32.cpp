@@ -0,0 +1,53 @@
+#include "Adler32.h"
+
+ADLER32::ADLER32() : m_A{ 1 }, m_B{ 0 }, m_PendingBytes{ 0 } {}
+
+void ADLER32::AddByte(const unsigned char Byte)
+{
+	m_A += Byte;
+	m_B += m_A;
+
+	if (++m_PendingBytes == m_MaximumPendingBytes)
+	{
+		m_A %= m_Modulus;
+		m_B %= m_Modulus;
+		m_PendingBytes = 0;
+	}
+}
+
+void ADLER32::AddBytes(const unsigned char* Data, size_t Length)
+{
+	while (Length > 0)
+	{
+		// Add as many bytes as can be before the sums have to be reduced, in one go.
+		const auto Count{ (Length < m_MaximumPendingBytes - m_PendingBytes) ? static_cast<unsigned int>(Length) : (m_MaximumPendingBytes - m_PendingBytes) };
+		for (unsigned int i{ 0 }; i < Count; ++i)
+		{
+			m_A += Data[i];
+			m_B += m_A;
+		}
+
+		Data += Count;
+		Length -= Count;
+
+		m_PendingBytes += Count;
+		if (m_PendingBytes == m_MaximumPendingBytes)
+		{
+			m_A %= m_Modulus;
+			m_B %= m_Modulus;
+			m_PendingBytes = 0;
+		}
+	}
+}
+
+unsigned long long ADLER32::GetChecksum() const
+{
+	return (static_cast<unsigned long long>(m_B % m_Modulus) << 16) | (m_A % m_Modulus);
+}
+
+void ADLER32::Reset()
+{
+	m_A = 1;
+	m_B = 0;
+	m_PendingBytes = 0;
+}
\ No newline at end of file
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+
+class ADLER32
+{
+	static constexpr unsigned int m_Modulus{ 65521 };
+	// The largest number of bytes that can be added before the sums have to be reduced, without the sums overflowing 32 bits.
+	static constexpr unsigned int m_MaximumPendingBytes{ 5552 };
+
+	unsigned int m_A;
+	unsigned int m_B;
+	unsigned int m_PendingBytes;
+
+public:
+	ADLER32();
+
+	void AddByte(const unsigned char Byte);
+	void AddBytes(const unsigned char* Data, size_t Length);
+	unsigned long long GetChecksum() const;
+	void Reset();
+};
\ No newline at end of file
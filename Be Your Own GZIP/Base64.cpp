@@ -0,0 +1,241 @@
+#include "Base64.h"
+
+#include <algorithm>
+#include <array>
+
+#ifdef CPU_DISPATCH_X86
+#include <immintrin.h>
+#endif
+
+constexpr unsigned char InvalidCharacter{ 0xFF };
+
+static constexpr std::array<unsigned char, 256> GenerateDecodingTable()
+{
+	std::array<unsigned char, 256> Table{};
+	Table.fill(InvalidCharacter);
+
+	constexpr char Alphabet[]{ "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/" };
+	for (unsigned char Value{ 0 }; Value < 64; ++Value)
+		Table[static_cast<unsigned char>(Alphabet[Value])] = Value;
+
+	return Table;
+}
+
+// The value of each character of the alphabet, and InvalidCharacter for every other character; generated at compile time.
+static constexpr std::array<unsigned char, 256> DecodingTable{ GenerateDecodingTable() };
+
+static size_t DecodeBase64_Generic(const unsigned char* const Text, const size_t Length, unsigned char* Output)
+{
+	size_t Position{ 0 };
+	for (; Position + 4 <= Length; Position += 4, Output += 3)
+	{
+		const unsigned int a{ DecodingTable[Text[Position]] };
+		const unsigned int b{ DecodingTable[Text[Position + 1]] };
+		const unsigned int c{ DecodingTable[Text[Position + 2]] };
+		const unsigned int d{ DecodingTable[Text[Position + 3]] };
+		// Only InvalidCharacter has its high bit set.
+		if (((a | b | c | d) & 0x80) != 0)
+			break;
+
+		const unsigned int Group{ (a << 18) | (b << 12) | (c << 6) | d };
+		Output[0] = static_cast<unsigned char>(Group >> 16);
+		Output[1] = static_cast<unsigned char>(Group >> 8);
+		Output[2] = static_cast<unsigned char>(Group);
+	}
+
+	return Position;
+}
+
+#ifdef CPU_DISPATCH_X86
+// Decodes 16 characters at a time, as described by Wojciech Mula in "Base64 encoding and decoding at almost the speed of a memory copy": the high and the low nibble of each character are looked up in two tables, whose entries have no bit in common only for the characters of the alphabet; the high nibble then gives the offset from the character to its value.
+// The four values of each group are then merged into 3 bytes with two multiply-adds. A block holding any other character, such as padding or a line break, is left to the generic code, which stops there.
+static size_t DecodeBase64_SSE42(const unsigned char* const Text, const size_t Length, unsigned char* const Output)
+{
+	const __m128i LowNibbleTable{ _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A) };
+	const __m128i HighNibbleTable{ _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10) };
+	const __m128i OffsetTable{ _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0) };
+	const __m128i Slash{ _mm_set1_epi8(0x2F) };
+	const __m128i PackBytes{ _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1) };
+
+	size_t Position{ 0 }, Written{ 0 };
+	for (; Position + 16 <= Length; Position += 16, Written += 12)
+	{
+		const __m128i Characters{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(Text + Position)) };
+
+		// Only the low 4 bits of the indexes matter to the lookups.
+		const __m128i HighNibbles{ _mm_and_si128(_mm_srli_epi32(Characters, 4), Slash) };
+		const __m128i LowNibbles{ _mm_and_si128(Characters, Slash) };
+		const __m128i Invalid{ _mm_and_si128(_mm_shuffle_epi8(LowNibbleTable, LowNibbles), _mm_shuffle_epi8(HighNibbleTable, HighNibbles)) };
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(Invalid, _mm_setzero_si128())) != 0xFFFF)
+			break;
+
+		// '/' shares its high nibble with '+', but not its offset.
+		const __m128i Values{ _mm_add_epi8(Characters, _mm_shuffle_epi8(OffsetTable, _mm_add_epi8(_mm_cmpeq_epi8(Characters, Slash), HighNibbles))) };
+
+		const __m128i Pairs{ _mm_maddubs_epi16(Values, _mm_set1_epi32(0x01400140)) };
+		const __m128i Groups{ _mm_madd_epi16(Pairs, _mm_set1_epi32(0x00011000)) };
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(Output + Written), _mm_shuffle_epi8(Groups, PackBytes));
+	}
+
+	return Position + DecodeBase64_Generic(Text + Position, Length - Position, Output + Written);
+}
+
+// The same as DecodeBase64_SSE42, 32 characters at a time; the 12 bytes of each half are then moved together.
+static size_t DecodeBase64_AVX2(const unsigned char* const Text, const size_t Length, unsigned char* const Output)
+{
+	const __m256i LowNibbleTable{ _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A, 0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A) };
+	const __m256i HighNibbleTable{ _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10) };
+	const __m256i OffsetTable{ _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0, 0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0) };
+	const __m256i Slash{ _mm256_set1_epi8(0x2F) };
+	const __m256i PackBytes{ _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1, 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1) };
+	const __m256i PackHalves{ _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7) };
+
+	size_t Position{ 0 }, Written{ 0 };
+	for (; Position + 32 <= Length; Position += 32, Written += 24)
+	{
+		const __m256i Characters{ _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Text + Position)) };
+
+		const __m256i HighNibbles{ _mm256_and_si256(_mm256_srli_epi32(Characters, 4), Slash) };
+		const __m256i LowNibbles{ _mm256_and_si256(Characters, Slash) };
+		if (_mm256_testz_si256(_mm256_shuffle_epi8(LowNibbleTable, LowNibbles), _mm256_shuffle_epi8(HighNibbleTable, HighNibbles)) == 0)
+			break;
+
+		const __m256i Values{ _mm256_add_epi8(Characters, _mm256_shuffle_epi8(OffsetTable, _mm256_add_epi8(_mm256_cmpeq_epi8(Characters, Slash), HighNibbles))) };
+
+		const __m256i Pairs{ _mm256_maddubs_epi16(Values, _mm256_set1_epi32(0x01400140)) };
+		const __m256i Groups{ _mm256_madd_epi16(Pairs, _mm256_set1_epi32(0x00011000)) };
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(Output + Written), _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(Groups, PackBytes), PackHalves));
+	}
+
+	return Position + DecodeBase64_Generic(Text + Position, Length - Position, Output + Written);
+}
+#endif
+
+static constexpr KERNEL_VARIANT<BASE64_DECODE_KERNEL> Base64DecodeVariants[]
+{
+	{ INSTRUCTION_SET::GENERIC, &DecodeBase64_Generic, L"generic" },
+#ifdef CPU_DISPATCH_X86
+	{ INSTRUCTION_SET::SSE42, &DecodeBase64_SSE42, L"sse4.2" },
+	{ INSTRUCTION_SET::AVX2, &DecodeBase64_AVX2, L"avx2" }
+#endif
+};
+
+std::span<const KERNEL_VARIANT<BASE64_DECODE_KERNEL>> GetBase64DecodeVariants()
+{
+	return Base64DecodeVariants;
+}
+
+BASE64_DECODER::BASE64_DECODER() : m_Text(m_TextChunkSize), m_DataLength{ 0 }, m_Group{ 0 }, m_GroupLength{ 0 }
+{
+}
+
+void BASE64_DECODER::AddGroupCharacter(const unsigned char Value)
+{
+	m_Group = (m_Group << 6) | Value;
+	if (++m_GroupLength < 4)
+		return;
+
+	if (m_Data.size() < m_DataLength + 3)
+		m_Data.resize(std::max(m_DataLength + 3, m_Data.size() * 2));
+
+	m_Data[m_DataLength++] = static_cast<unsigned char>(m_Group >> 16);
+	m_Data[m_DataLength++] = static_cast<unsigned char>(m_Group >> 8);
+	m_Data[m_DataLength++] = static_cast<unsigned char>(m_Group);
+
+	m_Group = 0;
+	m_GroupLength = 0;
+}
+
+// Whole groups are left to the kernel; a group split by a line break is put together one character at a time.
+size_t BASE64_DECODER::Decode(const unsigned char* const Text, const size_t Length, bool& out_Ended)
+{
+	static const auto Kernel{ PickKernelVariant(Base64DecodeVariants, GetInstructionSet()).Function };
+
+	size_t Position{ 0 };
+	while (Position < Length)
+	{
+		if (m_GroupLength == 0)
+		{
+			const size_t Needed{ m_DataLength + ((Length - Position) / 4) * 3 + Base64DecodeOverrun };
+			if (m_Data.size() < Needed)
+				m_Data.resize(std::max(Needed, m_Data.size() * 2));
+
+			const auto Decoded{ Kernel(Text + Position, Length - Position, m_Data.data() + m_DataLength) };
+			Position += Decoded;
+			m_DataLength += (Decoded / 4) * 3;
+
+			if (Position == Length)
+				break;
+		}
+
+		const auto Character{ Text[Position] };
+		const auto Value{ DecodingTable[Character] };
+		if (Value != InvalidCharacter)
+			AddGroupCharacter(Value);
+		else if ((Character != '\r') && (Character != '\n'))
+		{
+			// The padding ends the run, and is part of it.
+			while ((Position < Length) && (Text[Position] == '='))
+				++Position;
+
+			out_Ended = true;
+
+			return Position;
+		}
+
+		++Position;
+	}
+
+	return Position;
+}
+
+unsigned long long BASE64_DECODER::DecodeRun(std::istream& TextStream, const size_t MaximumDataLength, bool& out_Ended)
+{
+	m_DataLength = 0;
+	m_Group = 0;
+	m_GroupLength = 0;
+	out_Ended = false;
+
+	unsigned long long RunLength{ 0 };
+	while ((out_Ended == false) && (m_DataLength < MaximumDataLength))
+	{
+		TextStream.read(reinterpret_cast<char*>(m_Text.data()), m_TextChunkSize);
+		const auto TextLength{ static_cast<size_t>(TextStream.gcount()) };
+
+		RunLength += Decode(m_Text.data(), TextLength, out_Ended);
+
+		if (TextLength < m_TextChunkSize)
+			break;
+	}
+
+	// Past the limit, the rest of the run is not wanted; it ends there.
+	if (m_DataLength >= MaximumDataLength)
+		out_Ended = true;
+
+	// A last group of 2 or 3 characters, without padding, still holds 1 or 2 whole bytes.
+	if (m_GroupLength >= 2)
+	{
+		const int Bytes{ m_GroupLength - 1 };
+		const unsigned int Group{ m_Group << (6 * (4 - m_GroupLength)) };
+		if (m_Data.size() < m_DataLength + 2)
+			m_Data.resize(m_DataLength + 2);
+
+		m_Data[m_DataLength++] = static_cast<unsigned char>(Group >> 16);
+		if (Bytes == 2)
+			m_Data[m_DataLength++] = static_cast<unsigned char>(Group >> 8);
+	}
+	m_Group = 0;
+	m_GroupLength = 0;
+
+	return RunLength;
+}
+
+const unsigned char* BASE64_DECODER::GetData() const
+{
+	return m_Data.data();
+}
+
+size_t BASE64_DECODER::GetDataLength() const
+{
+	return m_DataLength;
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "CPUDispatch.h"
+
+#include <istream>
+#include <span>
+#include <vector>
+
+// Decodes the longest run of whole groups of four characters of the base64 alphabet at the start of Text, without padding, and returns the number of characters decoded, a multiple of 4.
+// Writes the 3 bytes of each group to Output, and may write up to Base64DecodeOverrun bytes past them.
+using BASE64_DECODE_KERNEL = size_t (*)(const unsigned char* Text, size_t Length, unsigned char* Output);
+
+constexpr size_t Base64DecodeOverrun{ 32 };
+
+// Every variant of the base64 decoding kernel, from the generic one up, whether the processor supports it or not; for comparing them.
+std::span<const KERNEL_VARIANT<BASE64_DECODE_KERNEL>> GetBase64DecodeVariants();
+
+// Decodes a run of base64 text, as found in logs, JSON and e-mails, into a buffer that is kept from one run to the next, so that it is only allocated again for a larger run.
+// The run goes on across line breaks, as text wrapped to a line length has them, up to its padding, or up to the first character that is neither in the alphabet nor a line break; a last group left incomplete without padding is decoded as far as it goes.
+class BASE64_DECODER
+{
+	// Runs are read from the text this many characters at a time.
+	static constexpr size_t m_TextChunkSize{ 1 << 16 };
+
+	std::vector<unsigned char> m_Text;
+	std::vector<unsigned char> m_Data;
+	size_t m_DataLength;
+
+	// The characters of a group not yet complete, 6 bits each.
+	unsigned int m_Group;
+	int m_GroupLength;
+
+	void AddGroupCharacter(unsigned char Value);
+	size_t Decode(const unsigned char* Text, size_t Length, bool& out_Ended);
+
+public:
+	BASE64_DECODER();
+
+	// Decodes the run of base64 text starting at the current position of the stream, up to MaximumDataLength bytes of decoded data, and returns the length of the run, line breaks included.
+	// out_Ended is set if the run ended before the end of the stream; the stream is left somewhere past the end of the run.
+	unsigned long long DecodeRun(std::istream& TextStream, size_t MaximumDataLength, bool& out_Ended);
+
+	// The data decoded from the last run.
+	const unsigned char* GetData() const;
+	size_t GetDataLength() const;
+};
\ No newline at end of file
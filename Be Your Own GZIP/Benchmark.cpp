@@ -0,0 +1,229 @@
+#include "Benchmark.h"
+
+#include "Base64.h"
+#include "CPUDispatch.h"
+#include "CRC.h"
+#include "OutputData.h"
+#include "Signatures.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+// Each variant is run this many times, and only its fastest run counts, so that a run slowed down by something else does not.
+static constexpr int BenchmarkRuns{ 5 };
+
+// The sizes of the data, in bytes.
+static constexpr size_t ScanDataSize{ 32 << 20 };
+static constexpr size_t MatchCount{ 1 << 18 };
+
+// Returns the highest throughput of Kernel over the runs, in MB/s.
+template <typename KERNEL>
+static double TimeKernel(const unsigned long long ProcessedBytes, KERNEL&& Kernel)
+{
+	double FastestRun{ 0.0 };
+	for (int Run{ 0 }; Run < BenchmarkRuns; ++Run)
+	{
+		const auto Start{ std::chrono::steady_clock::now() };
+		Kernel();
+		const std::chrono::duration<double> Duration{ std::chrono::steady_clock::now() - Start };
+
+		if ((Run == 0) || (Duration.count() < FastestRun))
+			FastestRun = Duration.count();
+	}
+
+	return static_cast<double>(ProcessedBytes) / 1e6 / std::max(FastestRun, 1e-9);
+}
+
+static void WriteVariantLine(std::wostream& Console, const wchar_t* const Name, const double Throughput, const bool Used, const bool Matches)
+{
+	std::wstring Line{ L"   " };
+	Line += Name;
+	Line.resize(std::max<size_t>(Line.size() + 1, 20), L' ');
+
+	const auto ThroughputText{ std::to_wstring(static_cast<unsigned long long>(Throughput)) };
+	Line.append((ThroughputText.size() < 8) ? (8 - ThroughputText.size()) : 0, L' ');
+	Line += ThroughputText + L" MB/s";
+	if (Used)
+		Line += L"   (used)";
+	if (Matches == false)
+		Line += L"   RESULT DIFFERS FROM THE GENERIC VARIANT";
+
+	Console << Line << L"\n";
+}
+
+// Random bytes, as compressed data looks, in which the first two bytes of a signature turn up as often as they would there.
+static void BenchmarkSignatureScan(std::wostream& Console, const std::vector<unsigned char>& Data)
+{
+	Console << L"Signature scan:\n";
+
+	const auto Variants{ GetFindSignaturesVariants() };
+	const auto Used{ &PickKernelVariant(Variants, GetInstructionSet()) };
+	const unsigned int FormatMask{ ALL_SIGNATURE_FORMATS };
+
+	std::vector<SIGNATURE_CANDIDATE> ExpectedCandidates;
+	for (const auto& Variant : Variants)
+	{
+		if (Variant.InstructionSet > GetSupportedInstructionSet())
+			continue;
+
+		std::vector<SIGNATURE_CANDIDATE> Candidates;
+		const auto Throughput{ TimeKernel(Data.size(), [&]() { Candidates.clear(); Variant.Function(Data.data(), Data.size(), Data.size(), FormatMask, Candidates); }) };
+
+		if (&Variant == &Variants.front())
+			ExpectedCandidates = Candidates;
+
+		const bool Matches{ (Candidates.size() == ExpectedCandidates.size()) && std::equal(Candidates.begin(), Candidates.end(), ExpectedCandidates.begin(), [](const auto& a, const auto& b) { return (a.Position == b.Position) && (a.Format == b.Format); }) };
+		WriteVariantLine(Console, Variant.Name, Throughput, &Variant == Used, Matches);
+	}
+}
+
+static void BenchmarkCRC32(std::wostream& Console, const std::vector<unsigned char>& Data)
+{
+	Console << L"CRC32:\n";
+
+	const auto Variants{ GetCRC32Variants() };
+	const auto Used{ &PickKernelVariant(Variants, GetInstructionSet()) };
+
+	// The data is also run through in pieces of the sizes DEFLATE blocks and stored blocks come in, so that the short runs left to the table count too.
+	unsigned int ExpectedRegister{ 0 };
+	for (const auto& Variant : Variants)
+	{
+		if (Variant.InstructionSet > GetSupportedInstructionSet())
+			continue;
+
+		unsigned int Register{ 0 };
+		const auto Throughput{ TimeKernel(Data.size(), [&]()
+		{
+			Register = 0xFFFFFFFF;
+			for (size_t Position{ 0 }, Piece{ 1 }; Position < Data.size(); Position += Piece, Piece = (Piece * 7 + 3) % 70000)
+				Register = Variant.Function(Register, Data.data() + Position, std::min(Piece, Data.size() - Position));
+		}) };
+
+		if (&Variant == &Variants.front())
+			ExpectedRegister = Register;
+
+		WriteVariantLine(Console, Variant.Name, Throughput, &Variant == Used, Register == ExpectedRegister);
+	}
+}
+
+// Back-references as DEFLATE makes them: mostly short distances, many of them shorter than the match, as in runs and repeated patterns.
+static void BenchmarkMatchCopy(std::wostream& Console)
+{
+	Console << L"Match copy:\n";
+
+	constexpr size_t MaximumLength{ 258 };
+	constexpr size_t MaximumDistance{ 300 };
+
+	std::mt19937 Generator{ 1 };
+	std::vector<std::pair<unsigned short, unsigned short>> Matches(MatchCount);
+	unsigned long long CopiedBytes{ 0 };
+	for (auto& Match : Matches)
+	{
+		Match.first = static_cast<unsigned short>(1 + (((Generator() & 3) == 0) ? (Generator() % MaximumDistance) : (Generator() % 16)));
+		Match.second = static_cast<unsigned short>(3 + (Generator() % 64) * (((Generator() & 7) == 0) ? 4 : 1));
+		CopiedBytes += Match.second;
+	}
+
+	const auto Variants{ GetMatchCopyVariants() };
+	const auto Used{ &PickKernelVariant(Variants, GetInstructionSet()) };
+
+	unsigned int ExpectedChecksum{ 0 };
+	for (const auto& Variant : Variants)
+	{
+		if (Variant.InstructionSet > GetSupportedInstructionSet())
+			continue;
+
+		// Every match starts from the same pattern, and the bytes it produces are summed up as it goes, so that the results of the variants can be compared.
+		unsigned char Buffer[MaximumDistance + MaximumLength + MatchCopyOverrun];
+		unsigned int Checksum{ 0 };
+		const auto Throughput{ TimeKernel(CopiedBytes, [&]()
+		{
+			Checksum = 0;
+			for (size_t i{ 0 }; i < sizeof(Buffer); ++i)
+				Buffer[i] = static_cast<unsigned char>(i * 31);
+
+			for (const auto& [Distance, Length] : Matches)
+			{
+				Variant.Function(Buffer + Distance, Buffer, Length);
+				Checksum = Checksum * 33 + Buffer[Distance + Length - 1];
+			}
+		}) };
+
+		if (&Variant == &Variants.front())
+			ExpectedChecksum = Checksum;
+
+		WriteVariantLine(Console, Variant.Name, Throughput, &Variant == Used, Checksum == ExpectedChecksum);
+	}
+}
+
+// Base64 text encoding the same random bytes, wrapped at 76 characters as in e-mails: the kernel is run over each line, as the decoder does.
+static void BenchmarkBase64Decode(std::wostream& Console, const std::vector<unsigned char>& Data)
+{
+	Console << L"Base64 decoding:\n";
+
+	constexpr char Alphabet[]{ "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/" };
+	constexpr size_t LineLength{ 76 };
+
+	std::vector<unsigned char> Text;
+	Text.reserve((Data.size() / 3) * 4 + Data.size() / 57 * 2);
+	for (size_t Position{ 0 }; Position + 3 <= Data.size(); Position += 3)
+	{
+		const unsigned int Group{ (static_cast<unsigned int>(Data[Position]) << 16) | (static_cast<unsigned int>(Data[Position + 1]) << 8) | Data[Position + 2] };
+		for (int Shift{ 18 }; Shift >= 0; Shift -= 6)
+			Text.push_back(static_cast<unsigned char>(Alphabet[(Group >> Shift) & 0x3F]));
+		if ((Text.size() + 2) % (LineLength + 2) == 0)
+		{
+			Text.push_back('\r');
+			Text.push_back('\n');
+		}
+	}
+
+	const auto Variants{ GetBase64DecodeVariants() };
+	const auto Used{ &PickKernelVariant(Variants, GetInstructionSet()) };
+
+	std::vector<unsigned char> Decoded(Data.size() + Base64DecodeOverrun);
+	for (const auto& Variant : Variants)
+	{
+		if (Variant.InstructionSet > GetSupportedInstructionSet())
+			continue;
+
+		size_t DecodedLength{ 0 };
+		const auto Throughput{ TimeKernel(Text.size(), [&]()
+		{
+			DecodedLength = 0;
+			for (size_t Position{ 0 }; Position < Text.size(); )
+			{
+				const auto DecodedCharacters{ Variant.Function(Text.data() + Position, Text.size() - Position, Decoded.data() + DecodedLength) };
+				DecodedLength += (DecodedCharacters / 4) * 3;
+				Position += DecodedCharacters + 2;
+			}
+		}) };
+
+		const bool Matches{ (DecodedLength == Data.size() - Data.size() % 3) && std::equal(Data.begin(), Data.begin() + DecodedLength, Decoded.begin()) };
+		WriteVariantLine(Console, Variant.Name, Throughput, &Variant == Used, Matches);
+	}
+}
+
+void RunBenchmark(std::wostream& Console)
+{
+	Console << L"Instruction set supported: " << GetInstructionSetName(GetSupportedInstructionSet()) << L"; kernels picked for: " << GetInstructionSetName(GetInstructionSet()) << L"\n\n";
+
+	std::vector<unsigned char> Data(ScanDataSize);
+	std::mt19937 Generator{ 0 };
+	for (auto& Byte : Data)
+		Byte = static_cast<unsigned char>(Generator());
+
+	BenchmarkSignatureScan(Console, Data);
+	Console << L"\n";
+	BenchmarkCRC32(Console, Data);
+	Console << L"\n";
+	BenchmarkMatchCopy(Console);
+	Console << L"\n";
+	BenchmarkBase64Decode(Console, Data);
+	Console << std::endl;
+}
\ No newline at end of file
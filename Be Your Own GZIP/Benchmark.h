@@ -0,0 +1,6 @@
+#pragma once
+
+#include <ostream>
+
+// Times every variant of the signature scan, CRC32, match copy and base64 decoding kernels that the processor supports, on the same synthetic data, and writes their throughput to the Console, along with the variant each kernel uses. A variant whose result differs from the generic one's is flagged as such.
+void RunBenchmark(std::wostream& Console);
\ No newline at end of file
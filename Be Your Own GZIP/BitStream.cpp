@@ -1,37 +1,47 @@
 #include "BitStream.h"
 
-BIT_STREAM::BIT_STREAM(std::istream& par_ByteStream) : m_ByteStream{ par_ByteStream }, m_BytesFetched{ 0 }, m_StreamEnded{ false }, m_CurrentByte{ 0x0 }, m_RemainingBits{ 0 }
+#include <algorithm>
+
+BIT_STREAM::BIT_STREAM(std::istream& par_ByteStream) : m_ByteStream{ par_ByteStream }, m_ptr_ByteBuffer{ par_ByteStream.rdbuf() }, m_BytesFetched{ 0 }, m_StreamEnded{ false }, m_CurrentByte{ 0x0 }, m_RemainingBits{ 0 }
 {
 	if (m_ByteStream.peek() == std::char_traits<char>::eof())
 		m_StreamEnded = true;
 }
 
+// The end of the data is flagged on the stream as istream::get() would, as the stream is read from again after the DEFLATE data.
+void BIT_STREAM::FetchByte()
+{
+	const auto FetchedByte{ m_ptr_ByteBuffer->sbumpc() };
+	if (FetchedByte == std::char_traits<char>::eof())
+	{
+		m_StreamEnded = true;
+		m_ByteStream.setstate(std::ios::eofbit | std::ios::failbit);
+
+		throw BIT_STREAM_EXCEPTION("0");
+	}
+	++m_BytesFetched;
+
+	m_CurrentByte = static_cast<unsigned char>(FetchedByte & 0xFF);
+	m_RemainingBits = 8;
+}
+
+// As many bits as are left of the current byte are taken at once.
 int BIT_STREAM::FetchBits(const int BitCount)
 {
 	if (m_StreamEnded)
 		throw BIT_STREAM_EXCEPTION("0");
 
 	int BitsToFetch{ 0 };
-	for (int i{ 0 }; i < BitCount; ++i)
+	for (int Fetched{ 0 }; Fetched < BitCount;)
 	{
 		if (m_RemainingBits == 0)
-		{
-			auto FetchedByte{ m_ByteStream.get() };
-			if (FetchedByte == std::char_traits<char>::eof())
-			{
-				m_StreamEnded = true;
-
-				throw BIT_STREAM_EXCEPTION("0");
-			}
-			++m_BytesFetched;
-
-			m_CurrentByte = static_cast<unsigned char>(FetchedByte & 0xFF);
-			m_RemainingBits = 8;
-		}
-
-		BitsToFetch |= ((m_CurrentByte & 0b00000001) << i);
-		m_CurrentByte >>= 1;
-		--m_RemainingBits;
+			FetchByte();
+
+		const int Taken{ std::min(BitCount - Fetched, static_cast<int>(m_RemainingBits)) };
+		BitsToFetch |= (m_CurrentByte & ((1 << Taken) - 1)) << Fetched;
+		m_CurrentByte = static_cast<unsigned char>(m_CurrentByte >> Taken);
+		m_RemainingBits -= static_cast<unsigned char>(Taken);
+		Fetched += Taken;
 	}
 
 	return BitsToFetch;
@@ -39,7 +49,34 @@ int BIT_STREAM::FetchBits(const int BitCount)
 
 int BIT_STREAM::FetchBit()
 {
-	return FetchBits(1);
+	if (m_RemainingBits == 0)
+		return FetchBits(1);
+
+	const int Bit{ m_CurrentByte & 0b00000001 };
+	m_CurrentByte >>= 1;
+	--m_RemainingBits;
+
+	return Bit;
+}
+
+void BIT_STREAM::FetchBytes(unsigned char* const Data, const size_t Count)
+{
+	if (Count == 0)
+		return;
+
+	if (m_StreamEnded)
+		throw BIT_STREAM_EXCEPTION("0");
+
+	m_ByteStream.read(reinterpret_cast<char*>(Data), Count);
+	const auto Length{ static_cast<size_t>(m_ByteStream.gcount()) };
+	m_BytesFetched += Length;
+
+	if (Length != Count)
+	{
+		m_StreamEnded = true;
+
+		throw BIT_STREAM_EXCEPTION("0");
+	}
 }
 
 void BIT_STREAM::MoveToByteBoundary()
@@ -47,9 +84,14 @@ void BIT_STREAM::MoveToByteBoundary()
 	m_RemainingBits = 0;
 }
 
-size_t BIT_STREAM::BytesFetched() const
+unsigned long long BIT_STREAM::BytesFetched() const
 {
 	return m_BytesFetched;
 }
 
+unsigned long long BIT_STREAM::BitsFetched() const
+{
+	return (m_BytesFetched * 8) - m_RemainingBits;
+}
+
 BIT_STREAM_EXCEPTION::BIT_STREAM_EXCEPTION(const char* ExceptionMessage) : std::runtime_error(ExceptionMessage) {}
\ No newline at end of file
@@ -5,21 +5,30 @@
 class BIT_STREAM
 {
 	std::istream& m_ByteStream;
-	size_t m_BytesFetched;
+	// Bytes are taken straight from the buffer of the stream, without the checks istream::get() makes for every one.
+	std::streambuf* const m_ptr_ByteBuffer;
+	// Counted in 64 bits, as a stream may run past 4 GiB even where size_t does not.
+	unsigned long long m_BytesFetched;
 
 	bool m_StreamEnded;
 
 	unsigned char m_CurrentByte;
 	unsigned char m_RemainingBits;
 
+	void FetchByte();
+
 public:
 	BIT_STREAM() = delete;
 	explicit BIT_STREAM(std::istream& ByteStream);
 
 	int FetchBits(int BitCount);
 	int FetchBit();
+	// Reads whole bytes at once, straight from the byte stream; only to be called at a byte boundary.
+	void FetchBytes(unsigned char* Data, size_t Count);
 	void MoveToByteBoundary();
-	size_t BytesFetched() const;
+	unsigned long long BytesFetched() const;
+	// The number of bits consumed so far, counting the bits skipped by MoveToByteBoundary().
+	unsigned long long BitsFetched() const;
 };
 
 class BIT_STREAM_EXCEPTION : public std::runtime_error
@@ -0,0 +1,113 @@
+#include "CPUDispatch.h"
+
+#include <atomic>
+
+#ifdef CPU_DISPATCH_X86
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+const wchar_t* GetInstructionSetName(const INSTRUCTION_SET InstructionSet)
+{
+	switch (InstructionSet)
+	{
+		case INSTRUCTION_SET::SSE2:
+			return L"sse2";
+		case INSTRUCTION_SET::SSE42:
+			return L"sse4.2";
+		case INSTRUCTION_SET::AVX2:
+			return L"avx2";
+		case INSTRUCTION_SET::AVX512:
+			return L"avx512";
+		case INSTRUCTION_SET::GENERIC:
+		default:
+			return L"generic";
+	}
+}
+
+bool ParseInstructionSetName(const std::wstring_view Name, INSTRUCTION_SET& out_InstructionSet)
+{
+	for (int i{ 0 }; i < INSTRUCTION_SET_COUNT; ++i)
+		if (Name == GetInstructionSetName(static_cast<INSTRUCTION_SET>(i)))
+		{
+			out_InstructionSet = static_cast<INSTRUCTION_SET>(i);
+
+			return true;
+		}
+
+	return false;
+}
+
+// The AVX and AVX-512 registers can only be used if the operating system saves them on context switches, which it tells through XCR0.
+static INSTRUCTION_SET DetectInstructionSet()
+{
+#ifdef CPU_DISPATCH_X86
+	int Registers[4];
+
+	__cpuid(Registers, 0);
+	const int HighestLeaf{ Registers[0] };
+	if (HighestLeaf < 1)
+		return INSTRUCTION_SET::GENERIC;
+
+	__cpuid(Registers, 1);
+	const bool SSE2{ (Registers[3] & (1 << 26)) != 0 };
+	const bool PCLMULQDQ{ (Registers[2] & (1 << 1)) != 0 };
+	const bool SSSE3{ (Registers[2] & (1 << 9)) != 0 };
+	const bool SSE41{ (Registers[2] & (1 << 19)) != 0 };
+	const bool SSE42{ (Registers[2] & (1 << 20)) != 0 };
+	const bool OSXSAVE{ (Registers[2] & (1 << 27)) != 0 };
+	const bool AVX{ (Registers[2] & (1 << 28)) != 0 };
+
+	if (SSE2 == false)
+		return INSTRUCTION_SET::GENERIC;
+	if ((SSSE3 && SSE41 && SSE42 && PCLMULQDQ) == false)
+		return INSTRUCTION_SET::SSE2;
+	if (((OSXSAVE && AVX) == false) || (HighestLeaf < 7))
+		return INSTRUCTION_SET::SSE42;
+
+	const auto XCR0{ _xgetbv(0) };
+	if ((XCR0 & 0x06) != 0x06)
+		return INSTRUCTION_SET::SSE42;
+
+	__cpuidex(Registers, 7, 0);
+	const bool AVX2{ (Registers[1] & (1 << 5)) != 0 };
+	const bool AVX512F{ (Registers[1] & (1 << 16)) != 0 };
+	const bool AVX512BW{ (Registers[1] & (1 << 30)) != 0 };
+
+	if (AVX2 == false)
+		return INSTRUCTION_SET::SSE42;
+	if (((AVX512F && AVX512BW) == false) || ((XCR0 & 0xE6) != 0xE6))
+		return INSTRUCTION_SET::AVX2;
+
+	return INSTRUCTION_SET::AVX512;
+#else
+	return INSTRUCTION_SET::GENERIC;
+#endif
+}
+
+INSTRUCTION_SET GetSupportedInstructionSet()
+{
+	static const INSTRUCTION_SET Supported{ DetectInstructionSet() };
+
+	return Supported;
+}
+
+// -1 until an instruction set is forced.
+static std::atomic<int> ForcedInstructionSet{ -1 };
+
+INSTRUCTION_SET GetInstructionSet()
+{
+	const auto Forced{ ForcedInstructionSet.load(std::memory_order_relaxed) };
+
+	return (Forced >= 0) ? static_cast<INSTRUCTION_SET>(Forced) : GetSupportedInstructionSet();
+}
+
+bool ForceInstructionSet(const INSTRUCTION_SET InstructionSet)
+{
+	if (InstructionSet > GetSupportedInstructionSet())
+		return false;
+
+	ForcedInstructionSet.store(static_cast<int>(InstructionSet), std::memory_order_relaxed);
+
+	return true;
+}
\ No newline at end of file
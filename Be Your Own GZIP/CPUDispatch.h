@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <string_view>
+
+// The kernels have variants for several instruction sets only on x86 and x64; elsewhere, only their generic variants are built.
+#if defined(_M_X64) || defined(_M_IX86)
+#define CPU_DISPATCH_X86
+#endif
+
+// The instruction sets the kernels have variants for, each of which includes the ones before it.
+// SSE42 stands for SSE4.2 along with SSSE3 and PCLMULQDQ, and AVX512 for AVX-512 F and BW, as that is what the kernels need of them.
+enum class INSTRUCTION_SET
+{
+	GENERIC,
+	SSE2,
+	SSE42,
+	AVX2,
+	AVX512
+};
+
+constexpr int INSTRUCTION_SET_COUNT{ 5 };
+
+// The name of the instruction set, as used in options and reports, such as L"avx2".
+const wchar_t* GetInstructionSetName(INSTRUCTION_SET InstructionSet);
+// Reads a name as written by GetInstructionSetName. Returns false if the name is not one of them.
+bool ParseInstructionSetName(std::wstring_view Name, INSTRUCTION_SET& out_InstructionSet);
+
+// The best instruction set that both the processor and the operating system support; detected the first time it is asked for.
+INSTRUCTION_SET GetSupportedInstructionSet();
+// The instruction set the kernels are picked for: the supported one, unless a lower one was forced.
+INSTRUCTION_SET GetInstructionSet();
+// Has the kernels picked for InstructionSet rather than for the best one supported, such as to compare them, or to rule out a faulty one. Only to be called before any kernel is used, as each of them is picked the first time it is called.
+// Returns false, and changes nothing, if InstructionSet is not supported.
+bool ForceInstructionSet(INSTRUCTION_SET InstructionSet);
+
+// A variant of a kernel, and the instruction set it needs.
+template <typename FUNCTION>
+struct KERNEL_VARIANT
+{
+	INSTRUCTION_SET InstructionSet;
+	FUNCTION Function;
+	const wchar_t* Name;
+};
+
+// Picks the variant for the highest instruction set that InstructionSet includes. The variants are listed from the generic one up.
+template <typename FUNCTION>
+constexpr const KERNEL_VARIANT<FUNCTION>& PickKernelVariant(const std::span<const KERNEL_VARIANT<FUNCTION>> Variants, const INSTRUCTION_SET InstructionSet)
+{
+	size_t Picked{ 0 };
+	for (size_t i{ 1 }; i < Variants.size(); ++i)
+		if (Variants[i].InstructionSet <= InstructionSet)
+			Picked = i;
+
+	return Variants[Picked];
+}
+
+template <typename FUNCTION, size_t COUNT>
+constexpr const KERNEL_VARIANT<FUNCTION>& PickKernelVariant(const KERNEL_VARIANT<FUNCTION> (&Variants)[COUNT], const INSTRUCTION_SET InstructionSet)
+{
+	return PickKernelVariant(std::span<const KERNEL_VARIANT<FUNCTION>>{ Variants }, InstructionSet);
+}
\ No newline at end of file
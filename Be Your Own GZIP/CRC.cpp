@@ -1,13 +1,17 @@
 #include "CRC.h"
 
-std::unique_ptr<std::array<unsigned int, 256>> CRC32::m_ptr_Table{ nullptr };
+#include <array>
 
-void CRC32::GenerateTable()
+#ifdef CPU_DISPATCH_X86
+#include <immintrin.h>
+#endif
+
+static constexpr std::array<unsigned int, 256> GenerateTable()
 {
-	m_ptr_Table = std::make_unique<std::array<unsigned int, 256>>();
+	std::array<unsigned int, 256> Table{};
 
 	const unsigned int Polynomial{ 0xEDB88320 };
-	for (unsigned int i{ 0 }; i < m_ptr_Table->size(); i++)
+	for (unsigned int i{ 0 }; i < Table.size(); i++)
 	{
 		unsigned int x{ i };
 		for (int j{ 0 }; j < 8; j++)
@@ -19,24 +23,110 @@ void CRC32::GenerateTable()
 				x >>= 1;
 			}
 		}
-		(*m_ptr_Table)[i] = x;
+		Table[i] = x;
 	}
+
+	return Table;
 }
 
+// Generated at compile time, so there is nothing to initialize when the first CRC32 is created, possibly by several threads at once.
+static constexpr std::array<unsigned int, 256> Table{ GenerateTable() };
+
 CRC32::CRC32() : m_CRC{ 0 }
 {
-	if (m_ptr_Table == nullptr)
-		GenerateTable();
 }
 
 void CRC32::AddByte(const unsigned char Byte)
 {
 	unsigned long long x{ m_CRC ^ 0xFFFFFFFF };
-	x = (*m_ptr_Table)[(x ^ Byte) & 0xFF] ^ (x >> 8);
+	x = Table[(x ^ Byte) & 0xFF] ^ (x >> 8);
 	m_CRC = x ^ 0xFFFFFFFF;
 }
 
-unsigned long long CRC32::GetCRC() const
+// The register is kept in a local for the whole run, rather than loaded and stored for every byte.
+static unsigned int AddBytes_Generic(unsigned int x, const unsigned char* const Data, const size_t Length)
+{
+	for (size_t i{ 0 }; i < Length; ++i)
+		x = Table[(x ^ Data[i]) & 0xFF] ^ (x >> 8);
+
+	return x;
+}
+
+#ifdef CPU_DISPATCH_X86
+// Folds the data 64 bytes at a time with carry-less multiplications, as described in Intel's "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction", and then reduces the 128 bits left to the 32 bits of the register.
+// The constants are powers of x modulo the bit-reflected polynomial, from the end of that paper. Runs of less than 64 bytes, and the last few bytes of a run, are left to the table.
+static unsigned int AddBytes_SSE42(unsigned int x, const unsigned char* Data, size_t Length)
+{
+	if (Length < 64)
+		return AddBytes_Generic(x, Data, Length);
+
+	const size_t Remainder{ Length % 16 };
+	Length -= Remainder;
+
+	const __m128i K1K2{ _mm_set_epi64x(0x01C6E41596, 0x0154442BD4) };
+	const __m128i K3K4{ _mm_set_epi64x(0x00CCAA009E, 0x01751997D0) };
+	const __m128i K5K0{ _mm_set_epi64x(0, 0x0163CD6124) };
+	const __m128i Polynomial{ _mm_set_epi64x(0x01F7011641, 0x01DB710641) };
+	const __m128i Low32Mask{ _mm_setr_epi32(~0, 0, ~0, 0) };
+
+	__m128i x1{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(Data + 0x00)) };
+	__m128i x2{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(Data + 0x10)) };
+	__m128i x3{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(Data + 0x20)) };
+	__m128i x4{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(Data + 0x30)) };
+	x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(x)));
+	Data += 64;
+	Length -= 64;
+
+	// Four lanes, folded in parallel.
+	for (; Length >= 64; Data += 64, Length -= 64)
+	{
+		const __m128i x5{ _mm_clmulepi64_si128(x1, K1K2, 0x00) };
+		const __m128i x6{ _mm_clmulepi64_si128(x2, K1K2, 0x00) };
+		const __m128i x7{ _mm_clmulepi64_si128(x3, K1K2, 0x00) };
+		const __m128i x8{ _mm_clmulepi64_si128(x4, K1K2, 0x00) };
+
+		x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, K1K2, 0x11), x5), _mm_loadu_si128(reinterpret_cast<const __m128i*>(Data + 0x00)));
+		x2 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x2, K1K2, 0x11), x6), _mm_loadu_si128(reinterpret_cast<const __m128i*>(Data + 0x10)));
+		x3 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x3, K1K2, 0x11), x7), _mm_loadu_si128(reinterpret_cast<const __m128i*>(Data + 0x20)));
+		x4 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x4, K1K2, 0x11), x8), _mm_loadu_si128(reinterpret_cast<const __m128i*>(Data + 0x30)));
+	}
+
+	// The lanes folded into one, and then the rest of the data, 16 bytes at a time.
+	x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, K3K4, 0x11), _mm_clmulepi64_si128(x1, K3K4, 0x00)), x2);
+	x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, K3K4, 0x11), _mm_clmulepi64_si128(x1, K3K4, 0x00)), x3);
+	x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, K3K4, 0x11), _mm_clmulepi64_si128(x1, K3K4, 0x00)), x4);
+	for (; Length >= 16; Data += 16, Length -= 16)
+		x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, K3K4, 0x11), _mm_clmulepi64_si128(x1, K3K4, 0x00)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(Data)));
+
+	// 128 bits folded to 64.
+	x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), _mm_clmulepi64_si128(x1, K3K4, 0x10));
+	x1 = _mm_xor_si128(_mm_clmulepi64_si128(_mm_and_si128(x1, Low32Mask), K5K0, 0x00), _mm_srli_si128(x1, 4));
+
+	// Barrett reduction to 32 bits.
+	__m128i Quotient{ _mm_clmulepi64_si128(_mm_and_si128(x1, Low32Mask), Polynomial, 0x10) };
+	Quotient = _mm_clmulepi64_si128(_mm_and_si128(Quotient, Low32Mask), Polynomial, 0x00);
+	x = static_cast<unsigned int>(_mm_extract_epi32(_mm_xor_si128(x1, Quotient), 1));
+
+	return AddBytes_Generic(x, Data, Remainder);
+}
+#endif
+
+static constexpr KERNEL_VARIANT<CRC32_KERNEL> AddBytesVariants[]
+{
+	{ INSTRUCTION_SET::GENERIC, &AddBytes_Generic, L"generic" },
+#ifdef CPU_DISPATCH_X86
+	{ INSTRUCTION_SET::SSE42, &AddBytes_SSE42, L"sse4.2+pclmul" }
+#endif
+};
+
+void CRC32::AddBytes(const unsigned char* const Data, const size_t Length)
+{
+	static const auto Kernel{ PickKernelVariant(AddBytesVariants, GetInstructionSet()).Function };
+
+	m_CRC = Kernel(static_cast<unsigned int>(m_CRC ^ 0xFFFFFFFF), Data, Length) ^ 0xFFFFFFFF;
+}
+
+unsigned long long CRC32::GetChecksum() const
 {
 	return m_CRC;
 }
@@ -44,4 +134,65 @@ unsigned long long CRC32::GetCRC() const
 void CRC32::Reset()
 {
 	m_CRC = 0;
+}
+
+// Appending a zero byte to the data is a linear operation on the CRC register, so it can be expressed as a 32x32 matrix over GF(2); squaring that matrix gives the operator for twice as many zero bytes.
+// Appending SecondLength zero bytes to the first piece, and XOR-ing in the CRC32 of the second piece, gives the CRC32 of the whole (the pre- and post-conditioning cancel out).
+static unsigned int MultiplyMatrixVector(const std::array<unsigned int, 32>& Matrix, unsigned int Vector)
+{
+	unsigned int Product{ 0 };
+	for (int i{ 0 }; Vector != 0; ++i, Vector >>= 1)
+		if (Vector & 1)
+			Product ^= Matrix[i];
+
+	return Product;
+}
+
+static void SquareMatrix(std::array<unsigned int, 32>& out_Square, const std::array<unsigned int, 32>& Matrix)
+{
+	for (int i{ 0 }; i < 32; ++i)
+		out_Square[i] = MultiplyMatrixVector(Matrix, Matrix[i]);
+}
+
+unsigned long long CRC32::Combine(const unsigned long long FirstChecksum, const unsigned long long SecondChecksum, unsigned long long SecondLength)
+{
+	if (SecondLength == 0)
+		return FirstChecksum;
+
+	// The operator for a single zero bit.
+	std::array<unsigned int, 32> Odd;
+	Odd[0] = 0xEDB88320;
+	for (int i{ 1 }; i < 32; ++i)
+		Odd[i] = 1u << (i - 1);
+
+	// The operators for two and four zero bits.
+	std::array<unsigned int, 32> Even;
+	SquareMatrix(Even, Odd);
+	SquareMatrix(Odd, Even);
+
+	// Apply the operators for 1, 2, 4... zero bytes, as selected by the bits of SecondLength.
+	auto Checksum{ static_cast<unsigned int>(FirstChecksum) };
+	do
+	{
+		SquareMatrix(Even, Odd);
+		if (SecondLength & 1)
+			Checksum = MultiplyMatrixVector(Even, Checksum);
+		SecondLength >>= 1;
+
+		if (SecondLength == 0)
+			break;
+
+		SquareMatrix(Odd, Even);
+		if (SecondLength & 1)
+			Checksum = MultiplyMatrixVector(Odd, Checksum);
+		SecondLength >>= 1;
+
+	} while (SecondLength != 0);
+
+	return Checksum ^ static_cast<unsigned int>(SecondChecksum);
+}
+
+std::span<const KERNEL_VARIANT<CRC32_KERNEL>> GetCRC32Variants()
+{
+	return AddBytesVariants;
 }
\ No newline at end of file
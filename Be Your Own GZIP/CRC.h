@@ -1,19 +1,29 @@
 #pragma once
 
-#include <memory>
-#include <array>
+#include "CPUDispatch.h"
+
+#include <cstddef>
+#include <span>
 
 class CRC32
 {
-	static std::unique_ptr<std::array<unsigned int, 256>> m_ptr_Table;
-	static void GenerateTable();
-
 	unsigned long long m_CRC;
 
 public:
 	CRC32();
 
 	void AddByte(const unsigned char Byte);
-	unsigned long long GetCRC() const;
+	// Uses the variant of the CRC32 kernel picked for the instruction set of the processor, the first time it is called.
+	void AddBytes(const unsigned char* Data, size_t Length);
+	unsigned long long GetChecksum() const;
 	void Reset();
-};
\ No newline at end of file
+
+	// Computes the CRC32 of two pieces of data put together, from the CRC32 of each piece and the length of the second one.
+	static unsigned long long Combine(unsigned long long FirstChecksum, unsigned long long SecondChecksum, unsigned long long SecondLength);
+};
+
+// Runs the CRC register, as it is between the pre- and post-conditioning, over Length bytes.
+using CRC32_KERNEL = unsigned int (*)(unsigned int Register, const unsigned char* Data, size_t Length);
+
+// Every variant of the CRC32 kernel, from the generic one up, whether the processor supports it or not; for comparing them.
+std::span<const KERNEL_VARIANT<CRC32_KERNEL>> GetCRC32Variants();
\ No newline at end of file
@@ -0,0 +1,189 @@
+#include "Carving.h"
+
+#include "TeeStream.h"
+#include "Tracing.h"
+
+#include <algorithm>
+
+#define WIN32_LEAN_AND_MEAN
+#define VC_EXTRALEAN
+#include <Windows.h>
+
+std::runtime_error PrepareException(const std::wstring& ErrorMessage)
+{
+	std::u8string msg;
+	msg.resize(WideCharToMultiByte(CP_UTF8, NULL, ErrorMessage.c_str(), -1, NULL, 0, NULL, NULL));
+	WideCharToMultiByte(CP_UTF8, NULL, ErrorMessage.c_str(), -1, reinterpret_cast<char*>(msg.data()), static_cast<int>(msg.size()), NULL, NULL);
+
+	return std::runtime_error(reinterpret_cast<const char*>(msg.c_str()));
+}
+
+std::wstring GetExceptionMessage(const std::exception& Exception)
+{
+	std::wstring wmsg;
+	wmsg.resize(MultiByteToWideChar(CP_UTF8, NULL, Exception.what(), -1, NULL, 0));
+	MultiByteToWideChar(CP_UTF8, NULL, Exception.what(), -1, wmsg.data(), static_cast<int>(wmsg.size()));
+
+	// The length given includes the terminating zero, unless the conversion failed, and gave nothing at all.
+	if (wmsg.empty() == false)
+		wmsg.pop_back();
+
+	return wmsg;
+}
+
+std::string ConvertToUTF8(const std::wstring& Text)
+{
+	std::string l_Text;
+	l_Text.resize(WideCharToMultiByte(CP_UTF8, NULL, Text.c_str(), -1, NULL, 0, NULL, NULL));
+	WideCharToMultiByte(CP_UTF8, NULL, Text.c_str(), -1, l_Text.data(), static_cast<int>(l_Text.size()), NULL, NULL);
+
+	// The length given includes the terminating zero, unless the conversion failed, and gave nothing at all.
+	if (l_Text.empty() == false)
+		l_Text.pop_back();
+
+	return l_Text;
+}
+
+bool Read4LittleEndianByteValue(std::istream& InputStream, unsigned long long& BytesRead, unsigned long long& Value)
+{
+	unsigned long long l_Value{ 0 };
+
+	for (int i{ 0 }; i < 4; ++i)
+	{
+		auto Byte{ InputStream.get() };
+
+		if (Byte == std::char_traits<char>::eof())
+			return false;
+		else
+		{
+			++BytesRead;
+			l_Value |= static_cast<unsigned long long>(Byte & 0xFF) << (8 * i);
+		}
+	}
+
+	Value = l_Value;
+
+	return true;
+}
+
+bool Read4BigEndianByteValue(std::istream& InputStream, unsigned long long& BytesRead, unsigned long long& Value)
+{
+	unsigned long long l_Value{ 0 };
+
+	for (int i{ 0 }; i < 4; ++i)
+	{
+		auto Byte{ InputStream.get() };
+
+		if (Byte == std::char_traits<char>::eof())
+			return false;
+		else
+		{
+			++BytesRead;
+			l_Value = (l_Value << 8) | static_cast<unsigned long long>(Byte & 0xFF);
+		}
+	}
+
+	Value = l_Value;
+
+	return true;
+}
+
+std::ofstream CreateOutputFile(const std::filesystem::path& OutputFilePath)
+{
+	if (std::filesystem::exists(OutputFilePath))
+		throw PrepareException(L"Could not create a new file:\n   " + OutputFilePath.wstring());
+
+	{
+		const auto ParentDirectory{ OutputFilePath.parent_path() };
+		if (std::filesystem::exists(ParentDirectory))
+		{
+			if (std::filesystem::is_directory(ParentDirectory) == false)
+				throw PrepareException(L"Could not create a new file:\n   " + OutputFilePath.wstring());
+		}
+		else
+			std::filesystem::create_directories(ParentDirectory);
+	}
+
+	std::ofstream OutputStream;
+	OutputStream.open(OutputFilePath, std::ofstream::binary);
+	if (OutputStream.good() == false)
+		throw PrepareException(L"Could not write to a file:\n   " + OutputFilePath.wstring());
+
+	return OutputStream;
+}
+
+void ReplaceFile(const std::filesystem::path& FilePath, const std::string& Data)
+{
+	auto TemporaryFilePath{ FilePath };
+	TemporaryFilePath += L".tmp";
+	{
+		std::ofstream TemporaryFile{ TemporaryFilePath, std::ios::binary | std::ios::trunc };
+		TemporaryFile.write(Data.data(), Data.size());
+		if (TemporaryFile.good() == false)
+			throw PrepareException(L"An error occured while writing to a file:\n   " + TemporaryFilePath.wstring());
+	}
+
+	// Otherwise, a crash right after the rename could leave the file named, but empty.
+	const auto Handle{ CreateFileW(TemporaryFilePath.c_str(), GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr) };
+	if (Handle == INVALID_HANDLE_VALUE)
+		throw PrepareException(L"An error occured while writing to a file:\n   " + TemporaryFilePath.wstring());
+
+	const bool Flushed{ FlushFileBuffers(Handle) != FALSE };
+	CloseHandle(Handle);
+	if (Flushed == false)
+		throw PrepareException(L"An error occured while writing to a file:\n   " + TemporaryFilePath.wstring());
+
+	if (MoveFileExW(TemporaryFilePath.c_str(), FilePath.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) == FALSE)
+		throw PrepareException(L"An error occured while writing to a file:\n   " + FilePath.wstring());
+}
+
+void CopyCarvedData(std::istream& InputStream, const std::streampos StartPosition, unsigned long long Size, std::ostream& Output)
+{
+	// The data may have been kept in memory as it was validated; otherwise, it is read again.
+	if (const auto Data{ GetRecordedData(InputStream, static_cast<unsigned long long>(static_cast<std::streamoff>(StartPosition)), Size) }; Data != nullptr)
+		Output.write(reinterpret_cast<const char*>(Data), static_cast<std::streamsize>(Size));
+	else
+	{
+		InputStream.clear();
+		InputStream.seekg(StartPosition);
+		if (InputStream.good() == false)
+			throw std::runtime_error("An error occured while reading the binary.");
+
+		while ((Size--) > 0)
+			Output.put(InputStream.get());
+	}
+}
+
+void WriteCarvedData(std::istream& InputStream, const std::streampos StartPosition, const unsigned long long Size, const std::filesystem::path& OutputFilePath, const std::vector<unsigned char>& Trailer)
+{
+	TRACE_SPAN(WriteSpan, "write");
+	TRACE_ARGUMENT(WriteSpan, "size", Size + Trailer.size());
+
+	auto OutputStream{ CreateOutputFile(OutputFilePath) };
+
+	CopyCarvedData(InputStream, StartPosition, Size, OutputStream);
+	OutputStream.write(reinterpret_cast<const char*>(Trailer.data()), Trailer.size());
+
+	if (OutputStream.good() == false)
+		throw PrepareException(L"An error occured while writing to a file:\n   " + OutputFilePath.wstring());
+
+	OutputStream.close();
+}
+
+void DiscardOutput(const std::filesystem::path& OutputFolder_Path, const unsigned long long Offset)
+{
+	if (std::filesystem::is_directory(OutputFolder_Path) == false)
+		return;
+
+	std::vector<std::filesystem::path> Discarded;
+	for (const auto& Entry : std::filesystem::directory_iterator{ OutputFolder_Path })
+	{
+		const auto Name{ Entry.path().filename().wstring() };
+		const auto Length{ std::min(Name.find_first_not_of(L"0123456789"), Name.size()) };
+		if ((Length > 0) && (Length < 20) && (std::stoull(Name.substr(0, Length)) >= Offset))
+			Discarded.push_back(Entry.path());
+	}
+
+	for (const auto& Path : Discarded)
+		std::filesystem::remove_all(Path);
+}
\ No newline at end of file
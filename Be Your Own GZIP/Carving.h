@@ -0,0 +1,30 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+std::runtime_error PrepareException(const std::wstring& ErrorMessage);
+// The message of an exception, such as one made by PrepareException; empty if it cannot be converted.
+std::wstring GetExceptionMessage(const std::exception& Exception);
+std::string ConvertToUTF8(const std::wstring& Text);
+
+bool Read4LittleEndianByteValue(std::istream& InputStream, unsigned long long& BytesRead, unsigned long long& Value);
+bool Read4BigEndianByteValue(std::istream& InputStream, unsigned long long& BytesRead, unsigned long long& Value);
+
+// Creates a new file for output, along with the folders leading to it; fails if the file already exists.
+std::ofstream CreateOutputFile(const std::filesystem::path& OutputFilePath);
+// Replaces the content of a file with Data, creating it if need be. Data is written under another name, flushed to the disk, and then renamed over the file, so that the file is never seen half-written, even after a crash.
+void ReplaceFile(const std::filesystem::path& FilePath, const std::string& Data);
+
+// Removes whatever was written for the candidates at or past Offset from the output folder, all of which is named after the offset of its candidate, so that they can be scanned again.
+void DiscardOutput(const std::filesystem::path& OutputFolder_Path, unsigned long long Offset);
+
+// Copies Size bytes, starting at StartPosition, from the input stream to Output.
+void CopyCarvedData(std::istream& InputStream, std::streampos StartPosition, unsigned long long Size, std::ostream& Output);
+// Copies Size bytes, starting at StartPosition, from the input stream to a new file, followed by the bytes of Trailer.
+void WriteCarvedData(std::istream& InputStream, std::streampos StartPosition, unsigned long long Size, const std::filesystem::path& OutputFilePath, const std::vector<unsigned char>& Trailer = {});
\ No newline at end of file
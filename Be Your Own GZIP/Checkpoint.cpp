@@ -0,0 +1,131 @@
+#include "Checkpoint.h"
+
+#include "Carving.h"
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+// Identifies a file as a checkpoint, along with the version of its layout.
+constexpr char CheckpointHeader[]{ "BeYourOwnGZIP-checkpoint 3" };
+
+template <typename VALUE>
+static bool ReadField(std::istream& Stream, const char* const Name, VALUE& out_Value)
+{
+	std::string Key;
+	return static_cast<bool>(Stream >> Key >> out_Value) && (Key == Name);
+}
+
+// A string may hold spaces, so it is written quoted.
+static bool ReadQuotedField(std::istream& Stream, const char* const Name, std::string& out_Value)
+{
+	std::string Key;
+	return static_cast<bool>(Stream >> Key >> std::quoted(out_Value)) && (Key == Name);
+}
+
+static bool ReadFilter(std::istream& Stream, GZIP_FILTER& out_Filter)
+{
+	return ReadQuotedField(Stream, "filter_name", out_Filter.NamePattern) && ReadField(Stream, "filter_minimum_time", out_Filter.MinimumTime) && ReadField(Stream, "filter_maximum_time", out_Filter.MaximumTime) && ReadField(Stream, "filter_os", out_Filter.OperatingSystem) && ReadField(Stream, "filter_minimum_size", out_Filter.MinimumSize);
+}
+
+static bool IsSameFilter(const GZIP_FILTER& First, const GZIP_FILTER& Second)
+{
+	return (First.NamePattern == Second.NamePattern) && (First.MinimumTime == Second.MinimumTime) && (First.MaximumTime == Second.MaximumTime) && (First.OperatingSystem == Second.OperatingSystem) && (First.MinimumSize == Second.MinimumSize);
+}
+
+SCAN_CHECKPOINT::SCAN_CHECKPOINT(const std::filesystem::path& OutputFolder_Path, const unsigned long long FileSize, const SCAN_OPTIONS& Options) :
+	m_FilePath{ OutputFolder_Path / CheckpointFileName },
+	m_FileSize{ FileSize },
+	m_Formats{ Options.Formats },
+	m_Deduplicate{ Options.Deduplicate },
+	m_Offset{ Options.Offset },
+	m_Length{ Options.Length },
+	m_ValidationLevel{ Options.ValidationLevel },
+	m_Filter{ Options.Filter },
+	m_Interval{ Options.CheckpointInterval },
+	m_LastWritten{ std::chrono::steady_clock::now() },
+	m_CreatedOutputFolder{ false }
+{
+}
+
+bool SCAN_CHECKPOINT::Read(unsigned long long& out_ScanOffset, unsigned long long& out_ResumeOffset, FINDINGS_SINK& Sink, DUPLICATE_FILTER* const ptr_Duplicates)
+{
+	std::ifstream Checkpoint{ m_FilePath };
+	if (Checkpoint.is_open() == false)
+		return false;
+
+	std::string Header;
+	std::getline(Checkpoint, Header);
+
+	unsigned long long FileSize, Offset, Length, ScanOffset, ResumeOffset;
+	unsigned int Formats, ValidationLevel;
+	bool Deduplicate, CreatedOutputFolder;
+	GZIP_FILTER Filter;
+	if ((Header != CheckpointHeader) || (ReadField(Checkpoint, "file_size", FileSize) == false) || (ReadField(Checkpoint, "formats", Formats) == false) || (ReadField(Checkpoint, "deduplicate", Deduplicate) == false) || (ReadField(Checkpoint, "offset", Offset) == false) || (ReadField(Checkpoint, "length", Length) == false) || (ReadField(Checkpoint, "validation", ValidationLevel) == false) || (ReadFilter(Checkpoint, Filter) == false) || (ReadField(Checkpoint, "created_output_folder", CreatedOutputFolder) == false) || (ReadField(Checkpoint, "scan_offset", ScanOffset) == false) || (ReadField(Checkpoint, "resume_offset", ResumeOffset) == false))
+		throw PrepareException(L"Could not read the checkpoint:\n   " + m_FilePath.wstring());
+
+	if ((FileSize != m_FileSize) || (Formats != m_Formats) || (Deduplicate != m_Deduplicate) || (Offset != m_Offset) || (Length != m_Length) || (ValidationLevel != static_cast<unsigned int>(m_ValidationLevel)) || (IsSameFilter(Filter, m_Filter) == false))
+		throw PrepareException(L"The checkpoint was left by a scan of another file, or with other options:\n   " + m_FilePath.wstring());
+
+	std::string End;
+	if ((Sink.LoadState(Checkpoint) == false) || ((ptr_Duplicates != nullptr) && (ptr_Duplicates->LoadState(Checkpoint) == false)) || ((Checkpoint >> End) && (End == "end")) == false)
+		throw PrepareException(L"Could not read the checkpoint:\n   " + m_FilePath.wstring());
+
+	// Whatever was written for a candidate at or past the checkpoint will be written again.
+	DiscardOutput(m_FilePath.parent_path(), ScanOffset);
+
+	out_ScanOffset = ScanOffset;
+	out_ResumeOffset = ResumeOffset;
+	m_CreatedOutputFolder = CreatedOutputFolder;
+
+	return true;
+}
+
+void SCAN_CHECKPOINT::Update(const unsigned long long ScanOffset, const unsigned long long ResumeOffset, const FINDINGS_SINK& Sink, DUPLICATE_FILTER* const ptr_Duplicates)
+{
+	const auto Now{ std::chrono::steady_clock::now() };
+	if ((m_Interval.count() == 0) || (Now - m_LastWritten < m_Interval))
+		return;
+
+	m_LastWritten = Now;
+
+	// Nothing may have been extracted yet.
+	if (std::filesystem::create_directories(m_FilePath.parent_path()))
+		m_CreatedOutputFolder = true;
+
+	std::ostringstream Checkpoint;
+	Checkpoint << CheckpointHeader << '\n' <<
+		"file_size " << m_FileSize << '\n' <<
+		"formats " << m_Formats << '\n' <<
+		"deduplicate " << m_Deduplicate << '\n' <<
+		"offset " << m_Offset << '\n' <<
+		"length " << m_Length << '\n' <<
+		"validation " << static_cast<unsigned int>(m_ValidationLevel) << '\n' <<
+		"filter_name " << std::quoted(m_Filter.NamePattern) << '\n' <<
+		"filter_minimum_time " << m_Filter.MinimumTime << '\n' <<
+		"filter_maximum_time " << m_Filter.MaximumTime << '\n' <<
+		"filter_os " << m_Filter.OperatingSystem << '\n' <<
+		"filter_minimum_size " << m_Filter.MinimumSize << '\n' <<
+		"created_output_folder " << m_CreatedOutputFolder << '\n' <<
+		"scan_offset " << ScanOffset << '\n' <<
+		"resume_offset " << ResumeOffset << '\n';
+
+	Sink.SaveState(Checkpoint);
+	if (ptr_Duplicates != nullptr)
+		ptr_Duplicates->SaveState(Checkpoint);
+
+	Checkpoint << "end\n";
+
+	ReplaceFile(m_FilePath, Checkpoint.str());
+}
+
+void SCAN_CHECKPOINT::Remove() const
+{
+	std::error_code Error;
+	std::filesystem::remove(m_FilePath, Error);
+
+	// Removing a folder that is not empty fails, and leaves it as it is.
+	if (m_CreatedOutputFolder)
+		std::filesystem::remove(m_FilePath.parent_path(), Error);
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Deduplication.h"
+#include "GZIP.h"
+
+#include <chrono>
+#include <filesystem>
+
+// The name of the checkpoint file, in the output folder of the scan.
+constexpr wchar_t CheckpointFileName[]{ L"checkpoint.txt" };
+
+// Saves the state of a scan now and then, so that a scan that gets interrupted can carry on from its last checkpoint, rather than from the start.
+// A checkpoint holds the offset below which every candidate has been dealt with, along with what the sink and the duplicate filter keep of the findings so far. It is written next to the output, and then put in place of the previous one, so that it is never seen half-written.
+class SCAN_CHECKPOINT
+{
+	const std::filesystem::path m_FilePath;
+	const unsigned long long m_FileSize;
+	const unsigned int m_Formats;
+	const bool m_Deduplicate;
+	const unsigned long long m_Offset;
+	const unsigned long long m_Length;
+	const VALIDATION_LEVEL m_ValidationLevel;
+	const GZIP_FILTER m_Filter;
+	const std::chrono::seconds m_Interval;
+	std::chrono::steady_clock::time_point m_LastWritten;
+	// Set if the output folder was only created to hold the checkpoint, by this scan or by the one it resumes; it is removed along with the checkpoint if nothing else was written to it.
+	bool m_CreatedOutputFolder;
+
+public:
+	SCAN_CHECKPOINT() = delete;
+	// The size of the scanned file, and the options that change what is found or kept of the findings, tell a checkpoint of the same scan from any other. A checkpoint is written every SCAN_OPTIONS::CheckpointInterval seconds, or never if that is 0.
+	SCAN_CHECKPOINT(const std::filesystem::path& OutputFolder_Path, unsigned long long FileSize, const SCAN_OPTIONS& Options);
+
+	// Reads the checkpoint left by an interrupted scan, restoring the findings to the Sink and the Duplicates, and removes what was extracted past it, as it will be scanned again. Returns false if there is no checkpoint; throws if it belongs to another scan.
+	bool Read(unsigned long long& out_ScanOffset, unsigned long long& out_ResumeOffset, FINDINGS_SINK& Sink, DUPLICATE_FILTER* ptr_Duplicates);
+	// Writes a checkpoint, if the interval has passed since the last one was written, or since the scan started. It is flushed to the disk before it takes the place of the previous one.
+	void Update(unsigned long long ScanOffset, unsigned long long ResumeOffset, const FINDINGS_SINK& Sink, DUPLICATE_FILTER* ptr_Duplicates);
+	// Removes the checkpoint, once the scan is complete; and the output folder, if it was only created for the checkpoint, and is empty.
+	void Remove() const;
+};
\ No newline at end of file
@@ -1,57 +1,70 @@
 #include "DEFLATE.h"
 
 #include "BitStream.h"
-#include "OutputData.h"
+#include "InflateContext.h"
+#include "MemoryStream.h"
+#include "Tracing.h"
+#include "WorkerThreads.h"
 
-class HUFFMAN_NODE
-{
-public:
-	int Value{ -1 };
-	std::unique_ptr<HUFFMAN_NODE> ptr_Zero{ nullptr };
-	std::unique_ptr<HUFFMAN_NODE> ptr_One{ nullptr };
+#include <algorithm>
+#include <bit>
+#include <thread>
+#include <type_traits>
 
-	int Resolve(BIT_STREAM& BitStream) const
-	{
-		if (Value != -1)
-			return Value;
+VALIDATION_BUDGET_EXCEPTION::VALIDATION_BUDGET_EXCEPTION(const char* ExceptionMessage) : std::runtime_error(ExceptionMessage) {}
 
-		switch (BitStream.FetchBit())
-		{
-			case 0:
-				return (ptr_Zero == nullptr) ? -1 : ptr_Zero->Resolve(BitStream);
-			case 1:
-				return (ptr_One == nullptr) ? -1 : ptr_One->Resolve(BitStream);
-			default:
-				return -1;
-		}
-	}
+bool VALIDATION_BUDGET::IsExceeded(const unsigned long long CompressedSize, const unsigned long long DecompressedSize) const
+{
+	if ((MaximumCompressedSize > 0) && (CompressedSize > MaximumCompressedSize))
+		return true;
 
-	void Place(const int par_Value, const int Code, int CodeLength)
-	{
-		if (CodeLength > 0)
-		{
-			--CodeLength;
+	if ((MaximumDecompressedSize > 0) && (DecompressedSize > MaximumDecompressedSize))
+		return true;
 
-			const bool BitSet{ static_cast<bool>(Code & (0b00000001 << CodeLength)) };
+	// Dividing rather than multiplying, so that a large ratio cannot overflow.
+	if ((MaximumExpansionRatio > 0) && (DecompressedSize / std::max(CompressedSize, 1ull) > MaximumExpansionRatio))
+		return true;
 
-			auto& ptr_NextNode{ BitSet ? ptr_One : ptr_Zero };
+	return false;
+}
 
-			if (ptr_NextNode == nullptr)
-				ptr_NextNode = std::make_unique<HUFFMAN_NODE>();
+// The fixed order in which codes for the values of the code lengths alphabet are given.
+constexpr int CodeLengthsAlphabetSize{ 19 };
+constexpr int CodeLengthsOrder[CodeLengthsAlphabetSize]{ 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
 
-			ptr_NextNode->Place(par_Value, Code, CodeLength);
-		}
-		else
-			Value = par_Value;
-	}
+// How many symbols of a compressed block are decoded between checks of the budget; at most 258 bytes each, so a block cannot go past the budget by more than about a megabyte.
+constexpr int BudgetCheckInterval{ 4096 };
+
+// The budget of a stream, as checked while decoding part of it on its own: the sizes of the data before that part count towards it.
+struct BUDGET_SHARE
+{
+	const VALIDATION_BUDGET& Budget;
+	unsigned long long CompressedSizeBefore{ 0 };
+	unsigned long long DecompressedSizeBefore{ 0 };
 };
 
-static bool ValidateCompressedBlock(BIT_STREAM& BitStream, OUTPUT_DATA_INFO& DecompressedData, const HUFFMAN_NODE& Literal_Length_Root, const HUFFMAN_NODE& Distance_Root)
+static void CheckBudget(const BUDGET_SHARE& Share, const BIT_STREAM& BitStream, const unsigned long long DecompressedSize)
+{
+	if (Share.Budget.IsExceeded(Share.CompressedSizeBefore + BitStream.BytesFetched(), Share.DecompressedSizeBefore + DecompressedSize))
+		throw VALIDATION_BUDGET_EXCEPTION("The candidate went past its validation budget.");
+}
+
+// If ptr_Budget is given, it is checked every BudgetCheckInterval symbols, so that a single block that keeps decoding is abandoned too.
+template <typename OUTPUT_DATA>
+static bool ValidateCompressedBlock(BIT_STREAM& BitStream, OUTPUT_DATA& DecompressedData, const HUFFMAN_TREE& Literal_Length_Tree, const HUFFMAN_TREE& Distance_Tree, const BUDGET_SHARE* const ptr_Budget)
 {
+	int SymbolsUntilBudgetCheck{ BudgetCheckInterval };
+
 	for (;;)
 	{
+		if ((ptr_Budget != nullptr) && (--SymbolsUntilBudgetCheck == 0))
+		{
+			CheckBudget(*ptr_Budget, BitStream, DecompressedData.GetBytesTotalCount());
+			SymbolsUntilBudgetCheck = BudgetCheckInterval;
+		}
+
 		// Decode a literal value/length code from the bit stream.
-		const auto Literal_Length_ValueCode{ Literal_Length_Root.Resolve(BitStream) };
+		const auto Literal_Length_ValueCode{ Literal_Length_Tree.Resolve(BitStream) };
 
 		// Interpret what kind of value has been decoded.
 		// 1. Is it a valid value?
@@ -152,7 +165,7 @@ static bool ValidateCompressedBlock(BIT_STREAM& BitStream, OUTPUT_DATA_INFO& Dec
 				// Next, decode that distance code from the bit stream, and calculate the distance value.
 				int DistanceValue;
 				{
-					const auto DistanceValueCode{ Distance_Root.Resolve(BitStream) };
+					const auto DistanceValueCode{ Distance_Tree.Resolve(BitStream) };
 					int ExtraBits;
 					switch (DistanceValueCode)
 					{
@@ -283,49 +296,16 @@ static bool ValidateCompressedBlock(BIT_STREAM& BitStream, OUTPUT_DATA_INFO& Dec
 	}
 }
 
-static bool ValidateCompressedBlock_FixedHuffman(BIT_STREAM& BitStream, OUTPUT_DATA_INFO& DecompressedData)
+template <typename OUTPUT_DATA>
+static bool ValidateCompressedBlock_FixedHuffman(BIT_STREAM& BitStream, OUTPUT_DATA& DecompressedData, const HUFFMAN_TABLES& Tables, const BUDGET_SHARE* const ptr_Budget)
 {
-	static std::unique_ptr<HUFFMAN_NODE> Fixed_Literal_Length_Root{ nullptr };
-	static std::unique_ptr<HUFFMAN_NODE> Fixed_Distance_Root{ nullptr };
-
-	// If a fixed Huffman tree for the literal and length values has not been previously generated, generate one.
-	if (Fixed_Literal_Length_Root == nullptr)
-	{
-		Fixed_Literal_Length_Root = std::make_unique<HUFFMAN_NODE>();
-
-		int Code{ 0 };
-
-		for (int Value{ 256 }; Value < 280; ++Code, ++Value)
-			Fixed_Literal_Length_Root->Place(Value, Code, 7);
-		Code <<= 1;
-
-		for (int Value{ 0 }; Value < 144; ++Code, ++Value)
-			Fixed_Literal_Length_Root->Place(Value, Code, 8);
-		for (int Value{ 280 }; Value < 288; ++Code, ++Value)
-			if ((Value != 286) && (Value != 287))
-				Fixed_Literal_Length_Root->Place(Value, Code, 8);
-		Code <<= 1;
-
-		for (int Value{ 144 }; Value < 256; ++Code, ++Value)
-			Fixed_Literal_Length_Root->Place(Value, Code, 9);
-	}
-
-	// If a fixed Huffman tree for the distance values has not been previously generated, generate one.
-	if (Fixed_Distance_Root == nullptr)
-	{
-		Fixed_Distance_Root = std::make_unique<HUFFMAN_NODE>();
-
-		int Code{ 0 };
-
-		for (int Value{ 0 }; Value < 30; ++Code, ++Value)
-			Fixed_Distance_Root->Place(Value, Code, 5);
-	}
-
-	return ValidateCompressedBlock(BitStream, DecompressedData, *Fixed_Literal_Length_Root, *Fixed_Distance_Root);
+	return ValidateCompressedBlock(BitStream, DecompressedData, Tables.Fixed_Literal_Length, Tables.Fixed_Distance, ptr_Budget);
 }
 
-static void BuildHuffmanTree(const std::vector<unsigned char>& CodeLengths, HUFFMAN_NODE& RootNode, const int Start, const int End)
+static void BuildHuffmanTree(const unsigned char* const CodeLengths, HUFFMAN_TREE& Tree, const int Start, const int End)
 {
+	Tree.Clear();
+
 	int MinimumCodeLength{ std::numeric_limits<int>::max() };
 	int MaximumCodeLength{ 1 };
 
@@ -343,13 +323,17 @@ static void BuildHuffmanTree(const std::vector<unsigned char>& CodeLengths, HUFF
 		}
 	}
 
+	// No values have a code; the tree stays empty, and any attempt to decode with it fails.
+	if (MinimumCodeLength > MaximumCodeLength)
+		return;
+
 	int Code{ 0 };
 	int CodeLength{ MinimumCodeLength };
 	do
 	{
 		for (int i{ Start }; i < End; ++i)
 			if (CodeLengths[i] == CodeLength)
-				RootNode.Place(i - Start, Code++, CodeLength);
+				Tree.Place(i - Start, Code++, CodeLength);
 
 		Code <<= 1;
 		++CodeLength;
@@ -357,7 +341,8 @@ static void BuildHuffmanTree(const std::vector<unsigned char>& CodeLengths, HUFF
 	} while (CodeLength <= MaximumCodeLength);
 }
 
-static bool ValidateCompressedBlock_DynamicHuffman(BIT_STREAM& BitStream, OUTPUT_DATA_INFO& DecompressedData)
+// Reads the header of a block compressed with dynamic Huffman codes, and builds the trees it describes, in place of the ones of the previous block.
+static bool ReadDynamicHuffmanTrees(BIT_STREAM& BitStream, HUFFMAN_TABLES& Tables)
 {
 	// Read the preheader.
 	const auto HLIT{ BitStream.FetchBits(5) };
@@ -373,44 +358,27 @@ static bool ValidateCompressedBlock_DynamicHuffman(BIT_STREAM& BitStream, OUTPUT
 		return false;
 
 	// Build Huffman trees used to decode the rest of the data.
-	HUFFMAN_NODE Literal_Length_Root;
-	HUFFMAN_NODE Distance_Root;
 	{
 		// Build a Huffman tree that will be used to decode code lengths sed to build the other trees.
-		HUFFMAN_NODE CodeLengthsCodes_Root;
 		{
-			// The fixed order in which codes for the values of the code lengths alphabet are given.
-			constexpr int CodeLengthsAlphabetSize{ 19 };
-			constexpr int CodeLengthsOrder[CodeLengthsAlphabetSize]{ 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
-
-			// Read the code lengths for the code lengths alphabet.
-			std::vector<unsigned char> CodeLengths_unsorted;
-			CodeLengths_unsorted.reserve(CodeLengthsAlphabetSize);
+			// Read the code lengths for the code lengths alphabet, unscrambling them to follow the alphabetic order; the ones not given are 0.
+			unsigned char CodeLengths[CodeLengthsAlphabetSize]{};
 			for (int i{ 0 }; i < CodeLengthsCodesCount; ++i)
-				CodeLengths_unsorted.push_back(BitStream.FetchBits(3));
-
-			// Extend the code length table to account for the entire code lengths alphabet.
-			CodeLengths_unsorted.resize(CodeLengthsAlphabetSize, 0);
-
-			// Unscramble the code lengths table to follow the alphabetic order. 
-			std::vector<unsigned char> CodeLengths;
-			CodeLengths.resize(CodeLengthsAlphabetSize);
-			for (int i{ 0 }; i < CodeLengthsAlphabetSize; ++i)
-				CodeLengths[CodeLengthsOrder[i]] = CodeLengths_unsorted[i];
+				CodeLengths[CodeLengthsOrder[i]] = BitStream.FetchBits(3);
 
 			// Use the table to construct a tree.
-			BuildHuffmanTree(CodeLengths, CodeLengthsCodes_Root, 0, CodeLengthsAlphabetSize);
+			BuildHuffmanTree(CodeLengths, Tables.CodeLengthsCodes, 0, CodeLengthsAlphabetSize);
 		}
 
 		// Calculate the total number of code lengths to be derived from the rest of the header.
 		const auto TotalCodeLengthsCount{ LiteralAndLengthCodesCount + DistanceCodesCount };
 
-		// Derive all the code lengths.
-		std::vector<unsigned char> CodeLengths;
-		CodeLengths.reserve(TotalCodeLengthsCount);
-		while (CodeLengths.size() < TotalCodeLengthsCount)
+		// Derive all the code lengths. The last repeat code may run past the total; the code lengths beyond it are ignored.
+		unsigned char CodeLengths[286 + 32 + 138];
+		int CodeLengthsCount{ 0 };
+		while (CodeLengthsCount < TotalCodeLengthsCount)
 		{
-			const auto Code{ CodeLengthsCodes_Root.Resolve(BitStream) };			
+			const auto Code{ Tables.CodeLengthsCodes.Resolve(BitStream) };			
 			switch (Code)
 			{
 				case 0:
@@ -430,19 +398,19 @@ static bool ValidateCompressedBlock_DynamicHuffman(BIT_STREAM& BitStream, OUTPUT
 				case 14:
 				case 15:
 				{
-					CodeLengths.push_back(Code);
+					CodeLengths[CodeLengthsCount++] = Code;
 
 					break;
 				}
 				case 16:
 				{
-					if (CodeLengths.size() == 0)
+					if (CodeLengthsCount == 0)
 						return false;
 
 					const auto TimesCopied{ BitStream.FetchBits(2) + 3 };
 
-					for (int i{ 0 }; i < TimesCopied; ++i)
-						CodeLengths.push_back(CodeLengths.back());
+					for (int i{ 0 }; i < TimesCopied; ++i, ++CodeLengthsCount)
+						CodeLengths[CodeLengthsCount] = CodeLengths[CodeLengthsCount - 1];
 
 					break;
 				}
@@ -451,7 +419,7 @@ static bool ValidateCompressedBlock_DynamicHuffman(BIT_STREAM& BitStream, OUTPUT
 					const auto TimesCopied{ BitStream.FetchBits(3) + 3 };
 
 					for (int i{ 0 }; i < TimesCopied; ++i)
-						CodeLengths.push_back(0);
+						CodeLengths[CodeLengthsCount++] = 0;
 
 					break;
 				}
@@ -460,7 +428,7 @@ static bool ValidateCompressedBlock_DynamicHuffman(BIT_STREAM& BitStream, OUTPUT
 					const auto TimesCopied{ BitStream.FetchBits(7) + 11 };
 
 					for (int i{ 0 }; i < TimesCopied; ++i)
-						CodeLengths.push_back(0);
+						CodeLengths[CodeLengthsCount++] = 0;
 
 					break;
 				}
@@ -470,14 +438,24 @@ static bool ValidateCompressedBlock_DynamicHuffman(BIT_STREAM& BitStream, OUTPUT
 		}
 
 		// Build the tree for literal/length values and the tree for distance values from the derived code lengths.
-		BuildHuffmanTree(CodeLengths, Literal_Length_Root, 0, LiteralAndLengthCodesCount);
-		BuildHuffmanTree(CodeLengths, Distance_Root, LiteralAndLengthCodesCount, TotalCodeLengthsCount);
+		BuildHuffmanTree(CodeLengths, Tables.Literal_Length, 0, LiteralAndLengthCodesCount);
+		BuildHuffmanTree(CodeLengths, Tables.Distance, LiteralAndLengthCodesCount, TotalCodeLengthsCount);
 	}
 
-	return ValidateCompressedBlock(BitStream, DecompressedData, Literal_Length_Root, Distance_Root);
+	return true;
+}
+
+template <typename OUTPUT_DATA>
+static bool ValidateCompressedBlock_DynamicHuffman(BIT_STREAM& BitStream, OUTPUT_DATA& DecompressedData, HUFFMAN_TABLES& Tables, const BUDGET_SHARE* const ptr_Budget)
+{
+	if (ReadDynamicHuffmanTrees(BitStream, Tables) == false)
+		return false;
+
+	return ValidateCompressedBlock(BitStream, DecompressedData, Tables.Literal_Length, Tables.Distance, ptr_Budget);
 }
 
-static bool ValidateUncompressedBlock(BIT_STREAM& BitStream, OUTPUT_DATA_INFO& DecompressedData)
+template <typename OUTPUT_DATA>
+static bool ValidateUncompressedBlock(BIT_STREAM& BitStream, OUTPUT_DATA& DecompressedData, std::vector<unsigned char>& Buffer)
 {
 	BitStream.MoveToByteBoundary();
 
@@ -499,55 +477,564 @@ static bool ValidateUncompressedBlock(BIT_STREAM& BitStream, OUTPUT_DATA_INFO& D
 			return false;
 	}
 
-	// Traverse the uncompressed data.
-	for (int i{ 0 }; i < LEN; ++i)
-		DecompressedData.AddByte(BitStream.FetchBits(8));
+	// The data of a stored block is only copied, so it is read and added in one go, rather than a byte at a time.
+	BitStream.FetchBytes(Buffer.data(), static_cast<size_t>(LEN));
+	DecompressedData.AddBytes(Buffer.data(), static_cast<size_t>(LEN));
 
 	return true;
 }
 
-bool ValidateDEFLATEdata(std::istream& InputStream, size_t& out_GZIPsize, size_t& out_SizeOfDecompressedData, unsigned long long& out_CRC32ofDecompressedData)
+// Validates blocks up to and including the final one; or, if a StopPosition is given, only up to the first block starting at or after that bit position, in which case out_FinalBlockReached is left false.
+// If ptr_Budget is given, it is checked within compressed blocks, and after every block, the final one included.
+template <typename OUTPUT_DATA>
+static bool ValidateDEFLATEblocks(BIT_STREAM& BitStream, OUTPUT_DATA& DecompressedData, INFLATE_CONTEXT& Context, const unsigned long long StopPosition, bool& out_FinalBlockReached, const BUDGET_SHARE* const ptr_Budget = nullptr)
 {
-	BIT_STREAM BitStream{ InputStream };
-	static OUTPUT_DATA_INFO DecompressedData(32768);
-	DecompressedData.Reset();
+	out_FinalBlockReached = false;
 
-	try
+	for (;;)
 	{
-		for (;;)
+		if (BitStream.BitsFetched() >= StopPosition)
+			return true;
+
+		TRACE_SPAN(BlockSpan, "DEFLATE block");
+#ifdef TRACING
+		const auto FirstBit{ BitStream.BitsFetched() };
+		const auto FirstByte{ DecompressedData.GetBytesTotalCount() };
+#endif
+
+		const auto BlockHeader{ BitStream.FetchBits(3) };
+		TRACE_ARGUMENT(BlockSpan, "type", (BlockHeader >> 1) & 0b11);
+		const bool FinalBlock{ static_cast<bool>(BlockHeader & 0b00000001) };
+		switch (BlockHeader & 0b00000110)
 		{
-			const auto BlockHeader{ BitStream.FetchBits(3) };
-			const bool FinalBlock{ static_cast<bool>(BlockHeader & 0b00000001) };
-			switch (BlockHeader & 0b00000110)
+			case 0b00000000:
 			{
-				case 0b00000000:
-				{
-					if (false == ValidateUncompressedBlock(BitStream, DecompressedData))
-						return false;
+				if (false == ValidateUncompressedBlock(BitStream, DecompressedData, Context.StoredBlockData))
+					return false;
 
-					break;
-				}
-				case 0b00000010:
-				{
-					if (false == ValidateCompressedBlock_FixedHuffman(BitStream, DecompressedData))
-						return false;
+				break;
+			}
+			case 0b00000010:
+			{
+				if (false == ValidateCompressedBlock_FixedHuffman(BitStream, DecompressedData, Context.Tables, ptr_Budget))
+					return false;
 
-					break;
-				}
-				case 0b00000100:
+				break;
+			}
+			case 0b00000100:
+			{
+				if (false == ValidateCompressedBlock_DynamicHuffman(BitStream, DecompressedData, Context.Tables, ptr_Budget))
+					return false;
+
+				break;
+			}
+			default:
+				return false;
+		}
+
+		TRACE_ARGUMENT(BlockSpan, "compressed_bytes", (BitStream.BitsFetched() - FirstBit + 7) / 8);
+		TRACE_ARGUMENT(BlockSpan, "decompressed_bytes", DecompressedData.GetBytesTotalCount() - FirstByte);
+		TRACE_END(BlockSpan);
+
+		if (ptr_Budget != nullptr)
+			CheckBudget(*ptr_Budget, BitStream, DecompressedData.GetBytesTotalCount());
+
+		if (FinalBlock)
+		{
+			out_FinalBlockReached = true;
+
+			return true;
+		}
+	}
+}
+
+// Runs the decoder with the given type of output data, and collects its results.
+template <typename OUTPUT_DATA>
+static bool ValidateDEFLATEdata(BIT_STREAM& BitStream, OUTPUT_DATA& DecompressedData, INFLATE_CONTEXT& Context, unsigned long long& out_SizeOfDecompressedData, unsigned long long& out_ChecksumOfDecompressedData, const unsigned long long StopPosition, bool& out_FinalBlockReached, const VALIDATION_BUDGET& Budget)
+{
+	DecompressedData.Reset();
+
+	const BUDGET_SHARE Share{ Budget };
+	if (ValidateDEFLATEblocks(BitStream, DecompressedData, Context, StopPosition, out_FinalBlockReached, &Share) == false)
+		return false;
+
+	out_SizeOfDecompressedData = DecompressedData.GetBytesTotalCount();
+	if constexpr (std::is_same_v<OUTPUT_DATA, OUTPUT_DATA_COUNTER>)
+		out_ChecksumOfDecompressedData = 0;
+	else
+		out_ChecksumOfDecompressedData = DecompressedData.GetChecksum();
+
+	return true;
+}
+
+// Validates blocks from a block boundary in the middle of a stream: the InputStream is positioned at the byte holding the boundary, and FirstBit is the position of the boundary within that byte.
+// StopPosition and out_EndPosition are bit positions counted from the start of that byte. out_EndOfData tells a stream that ended too early from invalid data.
+template <typename OUTPUT_DATA>
+static bool ValidateDEFLATEblocksAt(std::istream& InputStream, const int FirstBit, const unsigned long long StopPosition, OUTPUT_DATA& DecompressedData, INFLATE_CONTEXT& Context, unsigned long long& out_EndPosition, bool& out_FinalBlockReached, bool& out_EndOfData, const BUDGET_SHARE* const ptr_Budget = nullptr)
+{
+	BIT_STREAM BitStream{ InputStream };
+	out_EndOfData = false;
+
+	try
+	{
+		BitStream.FetchBits(FirstBit);
+
+		if (ValidateDEFLATEblocks(BitStream, DecompressedData, Context, StopPosition, out_FinalBlockReached, ptr_Budget) == false)
+			return false;
+	}
+	catch (const BIT_STREAM_EXCEPTION& ex)
+	{
+		if (*(ex.what()) != '0')
+			throw;
+
+		out_EndOfData = true;
+
+		return false;
+	}
+
+	out_EndPosition = BitStream.BitsFetched();
+
+	return true;
+}
+
+// Reads the 57 or more bits starting at the given bit position; bits past the end of the data read as zeros.
+static unsigned long long PeekBits(const unsigned char* const Data, const size_t Length, const unsigned long long BitPosition)
+{
+	const auto BytePosition{ static_cast<size_t>(BitPosition / 8) };
+
+	unsigned long long Bits{ 0 };
+	for (size_t i{ 0 }; (i < 8) && (BytePosition + i < Length); ++i)
+		Bits |= static_cast<unsigned long long>(Data[BytePosition + i]) << (8 * i);
+
+	return Bits >> (BitPosition % 8);
+}
+
+// Checks that the code lengths describe a complete prefix code: one that neither leaves any code unused, nor assigns more codes than there are.
+static bool IsCompleteCode(const unsigned char* const CodeLengths, const int Count, const int MaximumCodeLength)
+{
+	unsigned long long Sum{ 0 };
+	for (int i{ 0 }; i < Count; ++i)
+		if (CodeLengths[i] > 0)
+			Sum += 1ull << (MaximumCodeLength - CodeLengths[i]);
+
+	return Sum == (1ull << MaximumCodeLength);
+}
+
+// Checks whether a block compressed with dynamic Huffman codes could start at the given bit position.
+// It is stricter than the decoder, as real encoders always produce complete codes, with a code for the end-of-block value; this rules out almost every position that is not a block boundary after reading only a few bits.
+static bool CheckDynamicBlockHeader(const unsigned char* const Data, const size_t Length, unsigned long long Position)
+{
+	auto Bits{ PeekBits(Data, Length, Position) };
+
+	// BTYPE of 10.
+	if ((Bits & 0b110) != 0b100)
+		return false;
+
+	const auto HLIT{ static_cast<int>((Bits >> 3) & 0b11111) };
+	const auto HDIST{ static_cast<int>((Bits >> 8) & 0b11111) };
+	const auto HCLEN{ static_cast<int>((Bits >> 13) & 0b1111) };
+	if ((HLIT > 29) || (HDIST > 29))
+		return false;
+
+	Position += 17;
+
+	// Read the code lengths for the code lengths alphabet.
+	unsigned char CodeLengthsCodeLengths[CodeLengthsAlphabetSize]{};
+	Bits = PeekBits(Data, Length, Position);
+	for (int i{ 0 }; i < HCLEN + 4; ++i)
+		CodeLengthsCodeLengths[CodeLengthsOrder[i]] = static_cast<unsigned char>((Bits >> (3 * i)) & 0b111);
+
+	Position += 3 * static_cast<unsigned long long>(HCLEN + 4);
+
+	if (IsCompleteCode(CodeLengthsCodeLengths, CodeLengthsAlphabetSize, 7) == false)
+		return false;
+
+	// Build a table decoding the code lengths alphabet from the next 7 bits of the stream. Huffman codes are packed starting with their most significant bit, so the table is indexed by the reversed codes.
+	struct
+	{
+		unsigned char Value;
+		unsigned char CodeLength;
+	} CodeLengthsTable[1 << 7]{};
+	{
+		int Code{ 0 };
+		for (int CodeLength{ 1 }; CodeLength <= 7; ++CodeLength, Code <<= 1)
+			for (int Value{ 0 }; Value < CodeLengthsAlphabetSize; ++Value)
+				if (CodeLengthsCodeLengths[Value] == CodeLength)
 				{
-					if (false == ValidateCompressedBlock_DynamicHuffman(BitStream, DecompressedData))
-						return false;
+					int ReversedCode{ 0 };
+					for (int i{ 0 }; i < CodeLength; ++i)
+						ReversedCode |= ((Code >> i) & 1) << (CodeLength - 1 - i);
 
-					break;
+					for (int Index{ ReversedCode }; Index < (1 << 7); Index += 1 << CodeLength)
+						CodeLengthsTable[Index] = { static_cast<unsigned char>(Value), static_cast<unsigned char>(CodeLength) };
+
+					++Code;
 				}
-				default:
+	}
+
+	// Derive all the code lengths.
+	const int LiteralAndLengthCodesCount{ HLIT + 257 };
+	const int TotalCodeLengthsCount{ LiteralAndLengthCodesCount + HDIST + 1 };
+	unsigned char CodeLengths[286 + 30]{};
+	for (int Count{ 0 }; Count < TotalCodeLengthsCount; )
+	{
+		if (Position >= static_cast<unsigned long long>(Length) * 8)
+			return false;
+
+		Bits = PeekBits(Data, Length, Position);
+		const auto& Entry{ CodeLengthsTable[Bits & 0b1111111] };
+		Bits >>= Entry.CodeLength;
+		Position += Entry.CodeLength;
+
+		int Repeat;
+		unsigned char RepeatedLength{ 0 };
+		switch (Entry.Value)
+		{
+			case 16:
+			{
+				if (Count == 0)
 					return false;
+
+				Repeat = 3 + static_cast<int>(Bits & 0b11);
+				RepeatedLength = CodeLengths[Count - 1];
+				Position += 2;
+
+				break;
 			}
+			case 17:
+			{
+				Repeat = 3 + static_cast<int>(Bits & 0b111);
+				Position += 3;
 
-			if (FinalBlock)
 				break;
+			}
+			case 18:
+			{
+				Repeat = 11 + static_cast<int>(Bits & 0b1111111);
+				Position += 7;
+
+				break;
+			}
+			default:
+			{
+				Repeat = 1;
+				RepeatedLength = Entry.Value;
+			}
 		}
+
+		if (Count + Repeat > TotalCodeLengthsCount)
+			return false;
+
+		for (; Repeat > 0; --Repeat)
+			CodeLengths[Count++] = RepeatedLength;
+	}
+
+	if (CodeLengths[256] == 0)
+		return false;
+
+	if (IsCompleteCode(CodeLengths, LiteralAndLengthCodesCount, 15) == false)
+		return false;
+
+	// A single distance code, or none at all, is the one case where encoders leave a code incomplete.
+	int DistanceCodesUsed{ 0 };
+	for (int i{ LiteralAndLengthCodesCount }; i < TotalCodeLengthsCount; ++i)
+		if (CodeLengths[i] > 0)
+			++DistanceCodesUsed;
+
+	return (DistanceCodesUsed <= 1) || IsCompleteCode(CodeLengths + LiteralAndLengthCodesCount, HDIST + 1, 15);
+}
+
+// Reads the 64 bits starting at the given bit position; bits past the end of the data read as zeros.
+static unsigned long long Read64Bits(const unsigned char* const Data, const size_t Length, const unsigned long long BitPosition)
+{
+	const auto Shift{ static_cast<int>(BitPosition % 8) };
+	const auto Bits{ PeekBits(Data, Length, BitPosition) };
+	if (Shift == 0)
+		return Bits;
+
+	// PeekBits leaves the top bits empty after shifting, fill them from the ninth byte.
+	const auto NinthBytePosition{ static_cast<size_t>(BitPosition / 8) + 8 };
+	const unsigned long long NinthByte{ (NinthBytePosition < Length) ? Data[NinthBytePosition] : 0u };
+
+	return Bits | (NinthByte << (64 - Shift));
+}
+
+// Tests the 64 positions starting at Position at once, for where a block compressed with dynamic Huffman codes could start, judging by its first 13 bits: BTYPE of 10, and HLIT and HDIST no larger than 29.
+// Each of the words below holds, in bit i, the bit found k positions after Position + i; so a single bitwise operation tests a bit of the header at all 64 positions.
+static unsigned long long ProbeDynamicBlockHeaders(const unsigned char* const Data, const size_t Length, const unsigned long long Position)
+{
+	const auto Low{ Read64Bits(Data, Length, Position) };
+	const auto High{ Read64Bits(Data, Length, Position + 64) };
+
+	unsigned long long Shifted[13];
+	Shifted[0] = Low;
+	for (int k{ 1 }; k < 13; ++k)
+		Shifted[k] = (Low >> k) | (High << (64 - k));
+
+	// HLIT or HDIST are larger than 29 when their four most significant bits are all set.
+	const auto HLIT_TooLarge{ Shifted[4] & Shifted[5] & Shifted[6] & Shifted[7] };
+	const auto HDIST_TooLarge{ Shifted[9] & Shifted[10] & Shifted[11] & Shifted[12] };
+
+	return ~Shifted[1] & Shifted[2] & ~HLIT_TooLarge & ~HDIST_TooLarge;
+}
+
+// Looks for the first bit position, from FirstPosition up to LastPosition, where a block compressed with dynamic Huffman codes could start.
+static bool FindDynamicBlockHeader(const unsigned char* const Data, const size_t Length, const unsigned long long FirstPosition, const unsigned long long LastPosition, unsigned long long& out_Position)
+{
+	for (auto Position{ FirstPosition }; Position < LastPosition; Position += 64)
+	{
+		// Most positions fail on the first few bits of the header, so those are checked for 64 positions at once, before anything else.
+		auto Candidates{ ProbeDynamicBlockHeaders(Data, Length, Position) };
+		if (LastPosition - Position < 64)
+			Candidates &= (1ull << (LastPosition - Position)) - 1;
+
+		while (Candidates != 0)
+		{
+			const auto Candidate{ Position + std::countr_zero(Candidates) };
+			Candidates &= Candidates - 1;
+
+			if (CheckDynamicBlockHeader(Data, Length, Candidate))
+			{
+				out_Position = Candidate;
+
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+// A chunk of compressed data validated on its own by a worker thread. Positions are in bits, counted from the start of the data read for the round.
+struct SPECULATIVE_CHUNK
+{
+	// Where to look for the first block, and where to stop: before the first block starting at or after LastPosition.
+	unsigned long long FirstPosition{ 0 };
+	unsigned long long LastPosition{ 0 };
+	// Whether FirstPosition is known to be a block boundary, rather than the point to start looking for one.
+	bool KnownStart{ false };
+
+	bool Decoded{ false };
+	unsigned long long StartPosition{ 0 };
+	unsigned long long EndPosition{ 0 };
+	bool FinalBlockReached{ false };
+};
+
+// The Budget is the share of the data before the round; the data of the chunks before this one is not counted, as its size is not known yet.
+static void DecodeSpeculativeChunk(const unsigned char* const Data, const size_t Length, SPECULATIVE_CHUNK& Chunk, INFLATE_CONTEXT& Context, const BUDGET_SHARE& Budget)
+{
+	TRACE_SPAN(ChunkSpan, "speculative chunk");
+	TRACE_ARGUMENT(ChunkSpan, "length", Length);
+
+	auto& DecompressedData{ Context.SpeculativeData };
+
+	try
+	{
+		for (auto Candidate{ Chunk.FirstPosition }; Candidate < Chunk.LastPosition; ++Candidate)
+		{
+			if ((Chunk.KnownStart == false) && (FindDynamicBlockHeader(Data, Length, Candidate, Chunk.LastPosition, Candidate) == false))
+				return;
+
+			const auto BytePosition{ static_cast<size_t>(Candidate / 8) };
+			MEMORY_STREAM_BUFFER Buffer{ Data + BytePosition, Length - BytePosition };
+			std::istream Stream{ &Buffer };
+
+			DecompressedData.Reset();
+
+			const BUDGET_SHARE Share{ Budget.Budget, Budget.CompressedSizeBefore + BytePosition, Budget.DecompressedSizeBefore };
+
+			unsigned long long EndPosition;
+			bool EndOfData;
+			if (ValidateDEFLATEblocksAt(Stream, static_cast<int>(Candidate % 8), Chunk.LastPosition - (BytePosition * 8), DecompressedData, Context, EndPosition, Chunk.FinalBlockReached, EndOfData, &Share))
+			{
+				Chunk.Decoded = true;
+				Chunk.StartPosition = Candidate;
+				Chunk.EndPosition = (BytePosition * 8) + EndPosition;
+
+				return;
+			}
+
+			if (Chunk.KnownStart)
+				return;
+		}
+	}
+	catch (const std::exception&)
+	{
+		// Whatever went wrong, the chunk gets validated serially instead.
+		Chunk.Decoded = false;
+	}
+}
+
+// Amount of compressed data given to one thread at a time.
+constexpr size_t ParallelChunkSize{ 1 << 22 };
+// Data read past the last chunk of a round, so that the block that straddles the end of the chunk can usually be decoded from memory.
+constexpr size_t ParallelChunkOverrun{ 1 << 20 };
+// The number of chunks in the first round; it doubles with every round, up to one per thread, so that a stream only a little larger than the first chunk is not read far past its end.
+constexpr unsigned int ParallelFirstRoundChunks{ 2 };
+
+// Validates the rest of a DEFLATE stream in parallel, carrying on from a block boundary reached by the serial decoder. Positions are in bits, counted from StartPosition.
+// The compressed data is read in rounds of one chunk per thread. The first chunk of a round starts at the known boundary; the others start at the first block header found in them, and are decoded speculatively, with the bytes they copy from the unknown data before them left as markers.
+// The chunks are then checked in order: a chunk is only accepted if it starts exactly where the previous one ended, and its markers resolve against the window left by the previous one. Any other chunk is validated again serially, from where the previous one ended; so a stream is accepted or rejected exactly as the serial decoder would.
+// Every chunk is decoded within its share of the Budget, and the Budget is checked again once the chunk is accepted; no more data is read ahead than the budget allows, give or take the overrun.
+static bool ValidateRemainingDEFLATEdataInParallel(INFLATE_CONTEXT& Context, std::istream& InputStream, const std::streampos StartPosition, unsigned long long Position, const unsigned int Threads, const VALIDATION_BUDGET& Budget, std::vector<unsigned char>& Window, unsigned long long& io_SizeOfDecompressedData, unsigned long long& io_ChecksumOfDecompressedData, unsigned long long& out_EndPosition)
+{
+	// The threads, and a context for each, are kept by the context of the stream; the chunks that have to be validated serially use the context of the stream itself.
+	if (Context.WorkerThreads == nullptr)
+		Context.WorkerThreads = std::make_unique<WORKER_THREADS>();
+
+	if (Context.WorkerContexts == nullptr)
+		Context.WorkerContexts = std::make_unique<INFLATE_CONTEXT_POOL>();
+
+	std::vector<INFLATE_CONTEXT_POOL::LEASE> WorkerContexts;
+	for (unsigned int i{ 0 }; i < Threads; ++i)
+		WorkerContexts.push_back(Context.WorkerContexts->Acquire());
+
+	auto& Buffer{ Context.ReadAheadBuffer };
+	std::vector<SPECULATIVE_CHUNK> Chunks(Threads);
+	auto& SerialData{ Context.CRC32Data };
+
+	for (unsigned int ChunkCount{ std::min(ParallelFirstRoundChunks, Threads) };; ChunkCount = std::min(ChunkCount * 2, Threads))
+	{
+		// Read the data for this round, starting with the byte that holds the current position.
+		const unsigned long long BufferPosition{ (Position / 8) * 8 };
+		unsigned long long ReadLength{ (ChunkCount * ParallelChunkSize) + ParallelChunkOverrun };
+		if (Budget.MaximumCompressedSize > 0)
+			ReadLength = std::min(ReadLength, std::max(Budget.MaximumCompressedSize, BufferPosition / 8) - (BufferPosition / 8) + ParallelChunkOverrun);
+
+		if (Buffer.size() < ReadLength)
+			Buffer.resize(static_cast<size_t>(ReadLength));
+
+		InputStream.clear();
+		InputStream.seekg(StartPosition + static_cast<std::streamoff>(BufferPosition / 8));
+		if (InputStream.good() == false)
+			throw std::runtime_error("An error occured while reading the binary.");
+
+		InputStream.read(reinterpret_cast<char*>(Buffer.data()), static_cast<std::streamsize>(ReadLength));
+		const auto BufferLength{ static_cast<size_t>(InputStream.gcount()) };
+
+		for (unsigned int i{ 0 }; i < ChunkCount; ++i)
+		{
+			auto& Chunk{ Chunks[i] };
+			Chunk = {};
+			Chunk.FirstPosition = (i == 0) ? (Position - BufferPosition) : (static_cast<unsigned long long>(i) * ParallelChunkSize * 8);
+			Chunk.LastPosition = static_cast<unsigned long long>(i + 1) * ParallelChunkSize * 8;
+			Chunk.KnownStart = (i == 0);
+		}
+
+		const BUDGET_SHARE RoundShare{ Budget, BufferPosition / 8, io_SizeOfDecompressedData };
+		Context.WorkerThreads->Run(ChunkCount, [&](const unsigned int i)
+		{
+			if (Chunks[i].FirstPosition < static_cast<unsigned long long>(BufferLength) * 8)
+				DecodeSpeculativeChunk(Buffer.data(), BufferLength, Chunks[i], *WorkerContexts[i], RoundShare);
+		});
+
+		for (unsigned int i{ 0 }; i < ChunkCount; ++i)
+		{
+			const auto& Chunk{ Chunks[i] };
+
+			bool FinalBlockReached;
+			if (Chunk.Decoded && (BufferPosition + Chunk.StartPosition == Position) && WorkerContexts[i]->SpeculativeData.Resolve(Window, io_ChecksumOfDecompressedData))
+			{
+				io_SizeOfDecompressedData += WorkerContexts[i]->SpeculativeData.GetBytesTotalCount();
+				Position = BufferPosition + Chunk.EndPosition;
+				FinalBlockReached = Chunk.FinalBlockReached;
+			}
+			else
+			{
+				// Validate the chunk serially, from where the previous one ended, now that the window is known.
+				const unsigned long long SerialPosition{ (Position / 8) * 8 };
+
+				InputStream.clear();
+				InputStream.seekg(StartPosition + static_cast<std::streamoff>(SerialPosition / 8));
+				if (InputStream.good() == false)
+					throw std::runtime_error("An error occured while reading the binary.");
+
+				SerialData.Reset(Window);
+
+				const BUDGET_SHARE Share{ Budget, SerialPosition / 8, io_SizeOfDecompressedData };
+				unsigned long long EndPosition;
+				bool EndOfData;
+				if (ValidateDEFLATEblocksAt(InputStream, static_cast<int>(Position % 8), BufferPosition + Chunk.LastPosition - SerialPosition, SerialData, Context, EndPosition, FinalBlockReached, EndOfData, &Share) == false)
+					return false;
+
+				io_SizeOfDecompressedData += SerialData.GetBytesTotalCount();
+				io_ChecksumOfDecompressedData = CRC32::Combine(io_ChecksumOfDecompressedData, SerialData.GetChecksum(), SerialData.GetBytesTotalCount());
+				SerialData.GetWindow(Window);
+				Position = SerialPosition + EndPosition;
+			}
+
+			if (Budget.IsExceeded(Position / 8, io_SizeOfDecompressedData))
+				throw VALIDATION_BUDGET_EXCEPTION("The candidate went past its validation budget.");
+
+			if (FinalBlockReached)
+			{
+				out_EndPosition = Position;
+
+				return true;
+			}
+		}
+	}
+}
+
+bool ValidateDEFLATEdata(INFLATE_CONTEXT& Context, std::istream& InputStream, unsigned long long& out_GZIPsize, unsigned long long& out_SizeOfDecompressedData, unsigned long long& out_ChecksumOfDecompressedData, const VALIDATION_LEVEL Level, const CHECKSUM_TYPE Checksum, unsigned int Threads, const VALIDATION_BUDGET& Budget)
+{
+	const auto StartPosition{ InputStream.tellg() };
+	BIT_STREAM BitStream{ InputStream };
+
+	if (Threads == 0)
+		Threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+	try
+	{
+		constexpr auto NoStopPosition{ std::numeric_limits<unsigned long long>::max() };
+		bool FinalBlockReached;
+
+		// Each validation level, and each checksum, gets its own instantiation of the decoder, so that the structural one does not pay for the window and the checksum.
+		bool Valid;
+		if (Level == VALIDATION_LEVEL::STRUCTURAL)
+		{
+			auto& DecompressedData{ Context.DataCounter };
+			Valid = ValidateDEFLATEdata(BitStream, DecompressedData, Context, out_SizeOfDecompressedData, out_ChecksumOfDecompressedData, NoStopPosition, FinalBlockReached, Budget);
+		}
+		else if (Checksum == CHECKSUM_TYPE::ADLER32)
+		{
+			auto& DecompressedData{ Context.Adler32Data };
+			Valid = ValidateDEFLATEdata(BitStream, DecompressedData, Context, out_SizeOfDecompressedData, out_ChecksumOfDecompressedData, NoStopPosition, FinalBlockReached, Budget);
+		}
+		else
+		{
+			// With more than one thread, only the first chunk of the stream is validated here; a stream that goes on past it is large enough for the rest to be worth validating in parallel.
+			auto& DecompressedData{ Context.CRC32Data };
+			Valid = ValidateDEFLATEdata(BitStream, DecompressedData, Context, out_SizeOfDecompressedData, out_ChecksumOfDecompressedData, (Threads > 1) ? (ParallelChunkSize * 8) : NoStopPosition, FinalBlockReached, Budget);
+
+			if (Valid && (FinalBlockReached == false))
+			{
+				std::vector<unsigned char> Window;
+				DecompressedData.GetWindow(Window);
+
+				unsigned long long SizeOfDecompressedData{ DecompressedData.GetBytesTotalCount() };
+				unsigned long long ChecksumOfDecompressedData{ DecompressedData.GetChecksum() };
+				unsigned long long EndPosition;
+				if (ValidateRemainingDEFLATEdataInParallel(Context, InputStream, StartPosition, BitStream.BitsFetched(), Threads, Budget, Window, SizeOfDecompressedData, ChecksumOfDecompressedData, EndPosition) == false)
+					return false;
+
+				// Leave the stream right after the data, as the serial decoder does.
+				const unsigned long long Size{ (EndPosition + 7) / 8 };
+				InputStream.clear();
+				InputStream.seekg(StartPosition + static_cast<std::streamoff>(Size));
+				if (InputStream.good() == false)
+					throw std::runtime_error("An error occured while reading the binary.");
+
+				out_GZIPsize += Size;
+				out_SizeOfDecompressedData = SizeOfDecompressedData;
+				out_ChecksumOfDecompressedData = ChecksumOfDecompressedData;
+
+				return true;
+			}
+		}
+
+		if (Valid == false)
+			return false;
 	}
 	catch (const BIT_STREAM_EXCEPTION& ex)
 	{
@@ -558,8 +1045,184 @@ bool ValidateDEFLATEdata(std::istream& InputStream, size_t& out_GZIPsize, size_t
 	}
 
 	out_GZIPsize += BitStream.BytesFetched();
-	out_SizeOfDecompressedData = DecompressedData.GetBytesTotalCount();
-	out_CRC32ofDecompressedData = DecompressedData.GetCRC32();
 
 	return true;
+}
+
+bool InflateDEFLATEdata(INFLATE_CONTEXT& Context, std::istream& InputStream, std::vector<unsigned char>& io_Data)
+{
+	BIT_STREAM BitStream{ InputStream };
+	OUTPUT_DATA_BUFFER DecompressedData(32768, io_Data);
+
+	try
+	{
+		bool FinalBlockReached;
+		return ValidateDEFLATEblocks(BitStream, DecompressedData, Context, std::numeric_limits<unsigned long long>::max(), FinalBlockReached);
+	}
+	catch (const BIT_STREAM_EXCEPTION& ex)
+	{
+		if (*(ex.what()) != '0')
+			throw;
+
+		return false;
+	}
+}
+
+bool InflateDEFLATEdata(INFLATE_CONTEXT& Context, std::istream& InputStream, std::ostream& Output, unsigned long long& out_SizeOfDecompressedData)
+{
+	BIT_STREAM BitStream{ InputStream };
+	OUTPUT_DATA_STREAM DecompressedData(32768, Output);
+
+	try
+	{
+		bool FinalBlockReached;
+		const bool Valid{ ValidateDEFLATEblocks(BitStream, DecompressedData, Context, std::numeric_limits<unsigned long long>::max(), FinalBlockReached) };
+
+		DecompressedData.Finish();
+		out_SizeOfDecompressedData = DecompressedData.GetBytesTotalCount();
+
+		return Valid;
+	}
+	catch (const BIT_STREAM_EXCEPTION& ex)
+	{
+		if (*(ex.what()) != '0')
+			throw;
+
+		return false;
+	}
+}
+
+// Checks whether a stored block could start at the given bit position: the three bits of its header, BTYPE of 00, are followed at the next byte boundary by LEN and its complement NLEN.
+// Only positions three bits before a byte boundary are considered; if the header starts earlier, the padding after it reads as the header of a non-final block, and the block decodes just the same.
+static bool CheckStoredBlockHeader(const unsigned char* const Data, const size_t Length, const unsigned long long Position)
+{
+	if ((Position + 3) % 8 != 0)
+		return false;
+
+	const auto LEN_Position{ static_cast<size_t>((Position + 3) / 8) };
+	if (LEN_Position + 4 > Length)
+		return false;
+
+	if ((Data[LEN_Position - 1] >> 6) != 0)
+		return false;
+
+	const auto LEN{ Data[LEN_Position] | (Data[LEN_Position + 1] << 8) };
+	const auto NLEN{ Data[LEN_Position + 2] | (Data[LEN_Position + 3] << 8) };
+
+	return (LEN ^ NLEN) == 0xFFFF;
+}
+
+// How far past damaged data to look for the next block, before giving up.
+constexpr size_t RecoveryProbeDistance{ 1 << 22 };
+// Data read past the probed data, so that a block starting near its end can still be decoded from memory.
+constexpr size_t RecoveryProbeOverrun{ 1 << 20 };
+
+// Looks for the first position, from FirstPosition on, where a block header could start, and a whole block can be decoded from there. Positions are in bits, counted from StartPosition.
+// Block headers are probed 64 positions at a time, so that gigabytes of damaged data can be skipped over quickly.
+static bool FindRecoveryPosition(INFLATE_CONTEXT& Context, std::istream& InputStream, const std::streampos StartPosition, const unsigned long long FirstPosition, std::vector<unsigned char>& Buffer, OUTPUT_DATA_SPECULATIVE& TrialData, unsigned long long& out_Position)
+{
+	const unsigned long long BufferPosition{ (FirstPosition / 8) * 8 };
+
+	InputStream.clear();
+	InputStream.seekg(StartPosition + static_cast<std::streamoff>(BufferPosition / 8));
+	if (InputStream.good() == false)
+		return false;
+
+	Buffer.resize(RecoveryProbeDistance + RecoveryProbeOverrun);
+	InputStream.read(reinterpret_cast<char*>(Buffer.data()), Buffer.size());
+	const auto Length{ static_cast<size_t>(InputStream.gcount()) };
+	const unsigned long long LastPosition{ static_cast<unsigned long long>(std::min(Length, RecoveryProbeDistance)) * 8 };
+
+	for (auto Position{ FirstPosition - BufferPosition }; Position < LastPosition; Position += 64)
+	{
+		auto Candidates{ ProbeDynamicBlockHeaders(Buffer.data(), Length, Position) };
+		for (auto Offset{ (13 - (Position % 8)) % 8 }; Offset < 64; Offset += 8)
+			if (CheckStoredBlockHeader(Buffer.data(), Length, Position + Offset))
+				Candidates |= 1ull << Offset;
+
+		if (LastPosition - Position < 64)
+			Candidates &= (1ull << (LastPosition - Position)) - 1;
+
+		while (Candidates != 0)
+		{
+			const auto Candidate{ Position + std::countr_zero(Candidates) };
+			Candidates &= Candidates - 1;
+
+			if ((CheckStoredBlockHeader(Buffer.data(), Length, Candidate) == false) && (CheckDynamicBlockHeader(Buffer.data(), Length, Candidate) == false))
+				continue;
+
+			// Only accept the position if the whole block decodes.
+			const auto BytePosition{ static_cast<size_t>(Candidate / 8) };
+			MEMORY_STREAM_BUFFER CandidateBuffer{ Buffer.data() + BytePosition, Length - BytePosition };
+			std::istream CandidateStream{ &CandidateBuffer };
+
+			TrialData.Reset();
+
+			unsigned long long EndPosition;
+			bool FinalBlockReached, EndOfData;
+			if (ValidateDEFLATEblocksAt(CandidateStream, static_cast<int>(Candidate % 8), (Candidate % 8) + 1, TrialData, Context, EndPosition, FinalBlockReached, EndOfData))
+			{
+				out_Position = BufferPosition + Candidate;
+
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+void RecoverDEFLATEdata(INFLATE_CONTEXT& Context, std::istream& InputStream, std::ostream& Output, std::vector<RECOVERED_SEGMENT>& out_Segments)
+{
+	const auto StartPosition{ InputStream.tellg() };
+
+	OUTPUT_DATA_RECOVERY DecompressedData(32768);
+	// Candidate positions are tried out with a decoder that keeps nothing but the count of bytes.
+	OUTPUT_DATA_SPECULATIVE TrialData(32768, 0);
+	std::vector<unsigned char> Buffer;
+
+	RECOVERED_SEGMENT Segment;
+	unsigned long long UnknownBytesBeforeSegment{ 0 };
+
+	for (unsigned long long Position{ 0 }; ; )
+	{
+		// Decode the stream one block at a time, so that the data of a block that turns out to be damaged is never written out.
+		InputStream.clear();
+		InputStream.seekg(StartPosition + static_cast<std::streamoff>(Position / 8));
+
+		unsigned long long EndPosition;
+		bool FinalBlockReached{ false }, EndOfData{ false };
+		const bool Decoded{ InputStream.good() && ValidateDEFLATEblocksAt(InputStream, static_cast<int>(Position % 8), (Position % 8) + 1, DecompressedData, Context, EndPosition, FinalBlockReached, EndOfData) };
+		if (Decoded)
+		{
+			DecompressedData.WriteBlock(Output);
+			Position = ((Position / 8) * 8) + EndPosition;
+
+			if (FinalBlockReached == false)
+				continue;
+		}
+		else
+			DecompressedData.DiscardBlock();
+
+		// The segment ends here: after the final block, or where a block could not be decoded.
+		Segment.EndPosition = Position;
+		Segment.OutputSize = DecompressedData.GetBytesTotalCount() - Segment.OutputPosition;
+		Segment.UnknownBytes = DecompressedData.GetUnknownBytesCount() - UnknownBytesBeforeSegment;
+		Segment.FinalBlockReached = Decoded && FinalBlockReached;
+		out_Segments.push_back(Segment);
+
+		if (Segment.FinalBlockReached || EndOfData || (InputStream.good() == false))
+			return;
+
+		// Skip over the damaged data, to where the next block that decodes starts. The data it refers to back has been lost with the damaged data.
+		if (FindRecoveryPosition(Context, InputStream, StartPosition, Position + 1, Buffer, TrialData, Position) == false)
+			return;
+
+		DecompressedData.ForgetWindow();
+
+		Segment = {};
+		Segment.StartPosition = Position;
+		Segment.OutputPosition = DecompressedData.GetBytesTotalCount();
+		UnknownBytesBeforeSegment = DecompressedData.GetUnknownBytesCount();
+	}
 }
\ No newline at end of file
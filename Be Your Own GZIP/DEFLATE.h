@@ -1,5 +1,73 @@
 #pragma once
 
+#include "InflateContext.h"
+
 #include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+// How much of a DEFLATE stream gets checked.
+// STRUCTURAL checks the block headers, the Huffman codes, and that every back-reference stays within the data decoded so far; it only counts the decompressed bytes.
+// FULL additionally keeps the sliding window and computes the CRC32 of the decompressed data.
+enum class VALIDATION_LEVEL
+{
+	STRUCTURAL,
+	FULL
+};
+
+// The checksum computed over the decompressed data, as used by the container format: CRC32 for GZIP, ADLER32 for ZLIB.
+enum class CHECKSUM_TYPE
+{
+	CRC32,
+	ADLER32
+};
+
+// Limits on the work spent on a single candidate, so that a false candidate that happens to keep decoding cannot stall a scan; 0 means no limit.
+// The sizes of a DEFLATE stream are checked every few thousand symbols within a block, and after every block, the final one included; a stream may go past them by about a megabyte before it is abandoned.
+struct VALIDATION_BUDGET
+{
+	unsigned long long MaximumCompressedSize = 0;
+	unsigned long long MaximumDecompressedSize = 0;
+	// The largest number of decompressed bytes per compressed byte.
+	unsigned long long MaximumExpansionRatio = 0;
+	// The longest zero-terminated string in a header, such as the file name of a GZIP; checked by the container formats.
+	unsigned long long MaximumHeaderStringLength = 0;
+
+	bool IsExceeded(unsigned long long CompressedSize, unsigned long long DecompressedSize) const;
+};
+
+// Thrown when a candidate goes past its VALIDATION_BUDGET; the candidate is neither valid nor invalid, only abandoned.
+class VALIDATION_BUDGET_EXCEPTION : public std::runtime_error
+{
+public:
+	explicit VALIDATION_BUDGET_EXCEPTION(const char*);
+};
+
+// The decoder works with the window, checksum and Huffman trees held by the Context, so that nothing is allocated from one stream to the next; threads validating streams at the same time each need a context of their own.
+// With VALIDATION_LEVEL::STRUCTURAL, out_ChecksumOfDecompressedData is set to 0. A stream that goes past the Budget throws VALIDATION_BUDGET_EXCEPTION.
+// A stream checked with CRC32 at VALIDATION_LEVEL::FULL that is larger than a few megabytes is validated using up to Threads threads (0 meaning one per processor); the result is the same as with a single thread.
+bool ValidateDEFLATEdata(INFLATE_CONTEXT& Context, std::istream& InputStream, unsigned long long& out_Size, unsigned long long& out_SizeOfDecompressedData, unsigned long long& out_ChecksumOfDecompressedData, VALIDATION_LEVEL Level = VALIDATION_LEVEL::FULL, CHECKSUM_TYPE Checksum = CHECKSUM_TYPE::CRC32, unsigned int Threads = 1, const VALIDATION_BUDGET& Budget = {});
+
+// Decompresses a DEFLATE stream, appending the decompressed data to io_Data; the data is validated on the way, as by ValidateDEFLATEdata, but without a checksum.
+bool InflateDEFLATEdata(INFLATE_CONTEXT& Context, std::istream& InputStream, std::vector<unsigned char>& io_Data);
+// The same, writing the decompressed data to Output as it is decoded, rather than keeping all of it in memory; out_SizeOfDecompressedData is set to the number of bytes written.
+bool InflateDEFLATEdata(INFLATE_CONTEXT& Context, std::istream& InputStream, std::ostream& Output, unsigned long long& out_SizeOfDecompressedData);
+
+// A stretch of a damaged DEFLATE stream that could still be decoded. Positions are in bits, counted from the start of the stream.
+struct RECOVERED_SEGMENT
+{
+	unsigned long long StartPosition{ 0 };
+	unsigned long long EndPosition{ 0 };
+	// Where the decoded data starts in the recovered data, and its size.
+	unsigned long long OutputPosition{ 0 };
+	unsigned long long OutputSize{ 0 };
+	// Bytes copied from data lost to the damage before the segment; they are written out as '?'.
+	unsigned long long UnknownBytes{ 0 };
+	// Whether the segment ends with the final block of the stream, rather than with damaged data.
+	bool FinalBlockReached{ false };
+};
 
-bool ValidateDEFLATEdata(std::istream& InputStream, size_t& out_Size, size_t& out_SizeOfDecompressedData, unsigned long long& out_CRC32ofDecompressedData);
\ No newline at end of file
+// Decodes as much as possible of a damaged DEFLATE stream, writing the decoded data to Output. After a block fails to decode, the following bit positions are probed for where the next block that decodes starts, and decoding carries on from there.
+// Every stretch decoded is described by a segment; the first one starts at the start of the stream, and ends where the damage was found.
+void RecoverDEFLATEdata(INFLATE_CONTEXT& Context, std::istream& InputStream, std::ostream& Output, std::vector<RECOVERED_SEGMENT>& out_Segments);
\ No newline at end of file
@@ -0,0 +1,195 @@
+#include "Deduplication.h"
+
+#include "Carving.h"
+#include "TeeStream.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+size_t DUPLICATE_FILTER::FINGERPRINT_HASH::operator()(const FINGERPRINT& Fingerprint) const
+{
+	return static_cast<size_t>(Fingerprint.Checksum ^ (Fingerprint.SizeOfDecompressedData * 0x9E3779B97F4A7C15ull) ^ (Fingerprint.Size * 0xC2B2AE3D27D4EB4Full));
+}
+
+// A 64-bit FNV-1a hash, taken over 8 bytes at a time.
+static unsigned long long HashBytes(unsigned long long Hash, const unsigned char* const Data, const size_t Length)
+{
+	constexpr unsigned long long Prime{ 0x100000001B3ull };
+
+	size_t i{ 0 };
+	for (; i + 8 <= Length; i += 8)
+	{
+		unsigned long long Word{ 0 };
+		for (int j{ 0 }; j < 8; ++j)
+			Word |= static_cast<unsigned long long>(Data[i + j]) << (8 * j);
+
+		Hash = (Hash ^ Word) * Prime;
+	}
+	for (; i < Length; ++i)
+		Hash = (Hash ^ Data[i]) * Prime;
+
+	return Hash;
+}
+
+static unsigned long long HashData(std::istream& InputStream, const std::streampos StartPosition, unsigned long long Size)
+{
+	unsigned long long Hash{ 0xCBF29CE484222325ull };
+
+	// The file just validated may have been kept in memory.
+	if (const auto Data{ GetRecordedData(InputStream, static_cast<unsigned long long>(static_cast<std::streamoff>(StartPosition)), Size) }; Data != nullptr)
+		return HashBytes(Hash, Data, static_cast<size_t>(Size));
+
+	InputStream.clear();
+	InputStream.seekg(StartPosition);
+	if (InputStream.good() == false)
+		throw std::runtime_error("An error occured while reading the binary.");
+
+	// The buffer holds a whole number of words, so that only the last read can leave bytes over.
+	std::vector<unsigned char> Buffer(1 << 16);
+	while (Size > 0)
+	{
+		const auto Length{ static_cast<size_t>(std::min<unsigned long long>(Size, Buffer.size())) };
+		InputStream.read(reinterpret_cast<char*>(Buffer.data()), Length);
+		if (static_cast<size_t>(InputStream.gcount()) != Length)
+			throw std::runtime_error("An error occured while reading the binary.");
+
+		Hash = HashBytes(Hash, Buffer.data(), Length);
+
+		Size -= Length;
+	}
+
+	return Hash;
+}
+
+// Compares the Size bytes at two positions of the stream, a block of each at a time.
+static bool IsSameData(std::istream& InputStream, const std::streampos FirstPosition, const std::streampos SecondPosition, const unsigned long long Size)
+{
+	std::vector<unsigned char> FirstBlock(1 << 16);
+	std::vector<unsigned char> SecondBlock(FirstBlock.size());
+	for (unsigned long long Offset{ 0 }; Offset < Size;)
+	{
+		const auto Length{ static_cast<size_t>(std::min<unsigned long long>(Size - Offset, FirstBlock.size())) };
+		for (auto [Position, Block] : { std::pair{ FirstPosition, FirstBlock.data() }, std::pair{ SecondPosition, SecondBlock.data() } })
+		{
+			InputStream.clear();
+			InputStream.seekg(Position + static_cast<std::streamoff>(Offset));
+			InputStream.read(reinterpret_cast<char*>(Block), Length);
+			if (static_cast<size_t>(InputStream.gcount()) != Length)
+				throw std::runtime_error("An error occured while reading the binary.");
+		}
+
+		if (std::equal(FirstBlock.begin(), FirstBlock.begin() + Length, SecondBlock.begin()) == false)
+			return false;
+
+		Offset += Length;
+	}
+
+	return true;
+}
+
+DUPLICATE_FILTER::DUPLICATE_FILTER(const std::filesystem::path& ManifestFilePath) : m_ManifestFilePath{ ManifestFilePath }
+{
+}
+
+bool DUPLICATE_FILTER::IsDuplicate(std::istream& InputStream, const std::streampos StartPosition, const unsigned long long Size, const unsigned long long Checksum, const unsigned long long SizeOfDecompressedData, const std::filesystem::path& FileName)
+{
+	auto& SameFingerprint{ m_ExtractedFiles[{ Checksum, SizeOfDecompressedData, Size }] };
+
+	if (SameFingerprint.empty() == false)
+	{
+		const auto Hash{ HashData(InputStream, StartPosition, Size) };
+
+		for (auto& ExtractedFile : SameFingerprint)
+		{
+			if (ExtractedFile.Hashed == false)
+			{
+				ExtractedFile.Hash = HashData(InputStream, ExtractedFile.StartPosition, Size);
+				ExtractedFile.Hashed = true;
+			}
+
+			// The hash only rules files out; files with the same hash are compared byte for byte.
+			if ((ExtractedFile.Hash == Hash) && IsSameData(InputStream, ExtractedFile.StartPosition, StartPosition, Size))
+			{
+				if (m_Manifest.is_open() == false)
+				{
+					m_Manifest = CreateOutputFile(m_ManifestFilePath);
+					m_Manifest << "duplicate,original\n";
+				}
+
+				m_Manifest << FileName.string() << ',' << ExtractedFile.FileName.string() << '\n';
+				if (m_Manifest.good() == false)
+					throw PrepareException(L"An error occured while writing to a file:\n   " + m_ManifestFilePath.wstring());
+
+				return true;
+			}
+		}
+
+		SameFingerprint.push_back({ StartPosition, FileName, true, Hash });
+
+		return false;
+	}
+
+	SameFingerprint.push_back({ StartPosition, FileName, false, 0 });
+
+	return false;
+}
+
+void DUPLICATE_FILTER::SaveState(std::ostream& Stream)
+{
+	unsigned long long ManifestSize{ 0 };
+	if (m_Manifest.is_open())
+	{
+		m_Manifest.flush();
+		ManifestSize = static_cast<unsigned long long>(m_Manifest.tellp());
+	}
+
+	size_t Count{ 0 };
+	for (const auto& [Fingerprint, Files] : m_ExtractedFiles)
+		Count += Files.size();
+
+	Stream << "duplicates " << ManifestSize << ' ' << Count << '\n';
+	for (const auto& [Fingerprint, Files] : m_ExtractedFiles)
+		for (const auto& File : Files)
+			Stream << Fingerprint.Checksum << ' ' << Fingerprint.SizeOfDecompressedData << ' ' << Fingerprint.Size << ' ' << static_cast<unsigned long long>(File.StartPosition) << ' ' << File.FileName.string() << ' ' << File.Hashed << ' ' << File.Hash << '\n';
+}
+
+bool DUPLICATE_FILTER::LoadState(std::istream& Stream)
+{
+	std::string Key;
+	unsigned long long ManifestSize;
+	size_t Count;
+	if (((Stream >> Key >> ManifestSize >> Count) && (Key == "duplicates")) == false)
+		return false;
+
+	m_ExtractedFiles.clear();
+	for (size_t i{ 0 }; i < Count; ++i)
+	{
+		FINGERPRINT Fingerprint;
+		unsigned long long StartPosition;
+		std::string FileName;
+		EXTRACTED_FILE File;
+		if (static_cast<bool>(Stream >> Fingerprint.Checksum >> Fingerprint.SizeOfDecompressedData >> Fingerprint.Size >> StartPosition >> FileName >> File.Hashed >> File.Hash) == false)
+			return false;
+
+		File.StartPosition = static_cast<std::streamoff>(StartPosition);
+		File.FileName = FileName;
+		m_ExtractedFiles[Fingerprint].push_back(File);
+	}
+
+	// Whatever was added to the manifest after the state was saved will be added again.
+	if (m_Manifest.is_open())
+		m_Manifest.close();
+
+	if (ManifestSize == 0)
+		std::filesystem::remove(m_ManifestFilePath);
+	else
+	{
+		std::filesystem::resize_file(m_ManifestFilePath, ManifestSize);
+		m_Manifest.open(m_ManifestFilePath, std::ofstream::binary | std::ofstream::app);
+		if (m_Manifest.good() == false)
+			throw PrepareException(L"Could not write to a file:\n   " + m_ManifestFilePath.wstring());
+	}
+
+	return true;
+}
\ No newline at end of file
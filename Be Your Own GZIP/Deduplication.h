@@ -0,0 +1,53 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+// Keeps track of the files extracted so far, so that a file identical to one already extracted is not written again; every such duplicate is listed in a manifest instead.
+// Files are first told apart by a fingerprint: the checksum and size of their decompressed data, and their own size. Only files with the same fingerprint have their data hashed; and only files with the same hash have their data compared, to confirm that they are the same.
+class DUPLICATE_FILTER
+{
+	struct FINGERPRINT
+	{
+		unsigned long long Checksum;
+		unsigned long long SizeOfDecompressedData;
+		unsigned long long Size;
+
+		bool operator==(const FINGERPRINT&) const = default;
+	};
+
+	struct FINGERPRINT_HASH
+	{
+		size_t operator()(const FINGERPRINT& Fingerprint) const;
+	};
+
+	struct EXTRACTED_FILE
+	{
+		std::streampos StartPosition;
+		std::filesystem::path FileName;
+		// The hash is only computed once another file with the same fingerprint turns up.
+		bool Hashed;
+		unsigned long long Hash;
+	};
+
+	const std::filesystem::path m_ManifestFilePath;
+	std::ofstream m_Manifest;
+
+	std::unordered_map<FINGERPRINT, std::vector<EXTRACTED_FILE>, FINGERPRINT_HASH> m_ExtractedFiles;
+
+public:
+	DUPLICATE_FILTER() = delete;
+	// The manifest is only created once the first duplicate is found.
+	explicit DUPLICATE_FILTER(const std::filesystem::path& ManifestFilePath);
+
+	// Checks whether the Size bytes at StartPosition are identical to a file already extracted. If they are, FileName is added to the manifest, along with the name of the original; otherwise, they are recorded as extracted under FileName.
+	bool IsDuplicate(std::istream& InputStream, std::streampos StartPosition, unsigned long long Size, unsigned long long Checksum, unsigned long long SizeOfDecompressedData, const std::filesystem::path& FileName);
+
+	// Save and restore the files extracted so far, as text, for a checkpoint of the scan. The manifest is cut back to what it held when the state was saved, and carried on from there. LoadState returns false if the text is not what SaveState writes.
+	void SaveState(std::ostream& Stream);
+	bool LoadState(std::istream& Stream);
+};
\ No newline at end of file
@@ -0,0 +1,209 @@
+#include "FindingsReport.h"
+
+#include <charconv>
+
+FINDINGS_REPORT::FINDINGS_REPORT(std::wostream& Stream, const REPORT_FORMAT Format) : m_Stream{ Stream }, m_Format{ Format }, m_HeaderWritten{ false }
+{
+	m_Buffer.reserve(m_BufferSize);
+}
+
+FINDINGS_REPORT::~FINDINGS_REPORT()
+{
+	try
+	{
+		Flush();
+	}
+	catch (...) {}
+}
+
+// Numbers are always written in decimal, whatever the formatting flags of the stream, and without going through a string of their own.
+void FINDINGS_REPORT::AppendNumber(const unsigned long long Number)
+{
+	char Digits[20];
+	const auto End{ std::to_chars(Digits, Digits + sizeof(Digits), Number).ptr };
+
+	for (auto Digit{ Digits }; Digit != End; ++Digit)
+		m_Buffer.push_back(static_cast<wchar_t>(*Digit));
+}
+
+void FINDINGS_REPORT::AppendBoolean(const bool Value)
+{
+	if (m_Format == REPORT_FORMAT::NDJSON)
+		m_Buffer.append(Value ? L"true" : L"false");
+	else
+		m_Buffer.push_back(Value ? L'1' : L'0');
+}
+
+void FINDINGS_REPORT::AppendCSVField(const std::wstring_view Text)
+{
+	if (Text.find_first_of(L",\"\r\n") == std::wstring_view::npos)
+	{
+		m_Buffer.append(Text);
+
+		return;
+	}
+
+	m_Buffer.push_back(L'"');
+	for (const auto Character : Text)
+	{
+		if (Character == L'"')
+			m_Buffer.push_back(L'"');
+		m_Buffer.push_back(Character);
+	}
+	m_Buffer.push_back(L'"');
+}
+
+void FINDINGS_REPORT::AppendJSONString(const std::wstring_view Text)
+{
+	m_Buffer.push_back(L'"');
+	for (const auto Character : Text)
+	{
+		if ((Character == L'"') || (Character == L'\\'))
+		{
+			m_Buffer.push_back(L'\\');
+			m_Buffer.push_back(Character);
+		}
+		else if (Character < 0x20)
+		{
+			constexpr wchar_t HexDigits[]{ L"0123456789abcdef" };
+			m_Buffer.append(L"\\u00");
+			m_Buffer.push_back(HexDigits[Character >> 4]);
+			m_Buffer.push_back(HexDigits[Character & 0xF]);
+		}
+		else
+			m_Buffer.push_back(Character);
+	}
+	m_Buffer.push_back(L'"');
+}
+
+void FINDINGS_REPORT::AddFinding(const std::filesystem::path& FilePath, const FINDINGS& Finding, const std::wstring_view FormatName)
+{
+	if ((m_Format == REPORT_FORMAT::HUMAN) || ((Finding.ValidHeader == false) && (Finding.Aborted == false)))
+		return;
+
+	const auto FilePathText{ FilePath.wstring() };
+
+	if (m_Format == REPORT_FORMAT::CSV)
+	{
+		if (m_HeaderWritten == false)
+		{
+			m_Buffer.append(L"file,offset,format,valid_file,bgzf_blocks,bgzf_end_marker,recovered,duplicate,path,aborted,filtered\n");
+			m_HeaderWritten = true;
+		}
+
+		AppendCSVField(FilePathText);
+		m_Buffer.push_back(L',');
+		AppendNumber(Finding.Position);
+		m_Buffer.push_back(L',');
+		m_Buffer.append(FormatName);
+		m_Buffer.push_back(L',');
+		AppendBoolean(Finding.ValidFile);
+		m_Buffer.push_back(L',');
+		AppendNumber(Finding.BGZFBlocks);
+		m_Buffer.push_back(L',');
+		AppendBoolean(Finding.BGZFEndMarker);
+		m_Buffer.push_back(L',');
+		AppendBoolean(Finding.Recovered);
+		m_Buffer.push_back(L',');
+		AppendBoolean(Finding.Duplicate);
+		m_Buffer.push_back(L',');
+		AppendCSVField(Finding.GetPath());
+		m_Buffer.push_back(L',');
+		AppendBoolean(Finding.Aborted);
+		m_Buffer.push_back(L',');
+		AppendBoolean(Finding.Filtered);
+		m_Buffer.push_back(L'\n');
+	}
+	else
+	{
+		m_Buffer.append(L"{\"file\":");
+		AppendJSONString(FilePathText);
+		m_Buffer.append(L",\"offset\":");
+		AppendNumber(Finding.Position);
+		m_Buffer.append(L",\"format\":");
+		AppendJSONString(FormatName);
+		m_Buffer.append(L",\"valid_file\":");
+		AppendBoolean(Finding.ValidFile);
+		m_Buffer.append(L",\"bgzf_blocks\":");
+		AppendNumber(Finding.BGZFBlocks);
+		m_Buffer.append(L",\"bgzf_end_marker\":");
+		AppendBoolean(Finding.BGZFEndMarker);
+		m_Buffer.append(L",\"recovered\":");
+		AppendBoolean(Finding.Recovered);
+		m_Buffer.append(L",\"duplicate\":");
+		AppendBoolean(Finding.Duplicate);
+		m_Buffer.append(L",\"path\":");
+		AppendJSONString(Finding.GetPath());
+		m_Buffer.append(L",\"aborted\":");
+		AppendBoolean(Finding.Aborted);
+		m_Buffer.append(L",\"filtered\":");
+		AppendBoolean(Finding.Filtered);
+		m_Buffer.append(L"}\n");
+	}
+
+	if (m_Buffer.size() >= m_BufferSize)
+	{
+		m_Stream.write(m_Buffer.data(), m_Buffer.size());
+		m_Buffer.clear();
+	}
+}
+
+void FINDINGS_REPORT::AddVerification(const std::filesystem::path& FilePath, const VERIFY_RESULT& Result)
+{
+	if (m_Format == REPORT_FORMAT::HUMAN)
+		return;
+
+	const auto FilePathText{ FilePath.wstring() };
+
+	if (m_Format == REPORT_FORMAT::CSV)
+	{
+		if (m_HeaderWritten == false)
+		{
+			m_Buffer.append(L"file,valid,members,failed_offset,reason\n");
+			m_HeaderWritten = true;
+		}
+
+		AppendCSVField(FilePathText);
+		m_Buffer.push_back(L',');
+		AppendBoolean(Result.Valid);
+		m_Buffer.push_back(L',');
+		AppendNumber(Result.Members);
+		m_Buffer.push_back(L',');
+		if (Result.Valid == false)
+			AppendNumber(Result.FailedOffset);
+		m_Buffer.push_back(L',');
+		AppendCSVField(Result.Reason);
+		m_Buffer.push_back(L'\n');
+	}
+	else
+	{
+		m_Buffer.append(L"{\"file\":");
+		AppendJSONString(FilePathText);
+		m_Buffer.append(L",\"valid\":");
+		AppendBoolean(Result.Valid);
+		m_Buffer.append(L",\"members\":");
+		AppendNumber(Result.Members);
+		m_Buffer.append(L",\"failed_offset\":");
+		if (Result.Valid)
+			m_Buffer.append(L"null");
+		else
+			AppendNumber(Result.FailedOffset);
+		m_Buffer.append(L",\"reason\":");
+		AppendJSONString(Result.Reason);
+		m_Buffer.append(L"}\n");
+	}
+
+	if (m_Buffer.size() >= m_BufferSize)
+	{
+		m_Stream.write(m_Buffer.data(), m_Buffer.size());
+		m_Buffer.clear();
+	}
+}
+
+void FINDINGS_REPORT::Flush()
+{
+	m_Stream.write(m_Buffer.data(), m_Buffer.size());
+	m_Buffer.clear();
+
+	m_Stream.flush();
+}
\ No newline at end of file
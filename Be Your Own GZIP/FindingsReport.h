@@ -0,0 +1,47 @@
+#pragma once
+
+#include "GZIP.h"
+
+#include <filesystem>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+enum class REPORT_FORMAT
+{
+	HUMAN,
+	CSV,
+	NDJSON
+};
+
+// Writes a record for every valid header found, and for every candidate abandoned for going past its validation budget, as soon as it is found, in CSV or NDJSON. Records are collected in a large buffer, which is only written to the stream when it fills up, or when the report is flushed.
+// With REPORT_FORMAT::HUMAN, no records are written; the findings get summed up once a file has been scanned instead.
+class FINDINGS_REPORT
+{
+	static constexpr size_t m_BufferSize{ 1 << 16 };
+
+	std::wostream& m_Stream;
+	const REPORT_FORMAT m_Format;
+
+	std::wstring m_Buffer;
+	bool m_HeaderWritten;
+
+	void AppendNumber(unsigned long long Number);
+	void AppendBoolean(bool Value);
+	void AppendCSVField(std::wstring_view Text);
+	void AppendJSONString(std::wstring_view Text);
+
+public:
+	FINDINGS_REPORT() = delete;
+	FINDINGS_REPORT(std::wostream& Stream, REPORT_FORMAT Format);
+
+	~FINDINGS_REPORT();
+
+	FINDINGS_REPORT(const FINDINGS_REPORT&) = delete;
+	FINDINGS_REPORT& operator=(const FINDINGS_REPORT&) = delete;
+
+	void AddFinding(const std::filesystem::path& FilePath, const FINDINGS& Finding, std::wstring_view FormatName);
+	// Writes a record for a file checked with VerifyGZIPFile.
+	void AddVerification(const std::filesystem::path& FilePath, const VERIFY_RESULT& Result);
+	void Flush();
+};
\ No newline at end of file
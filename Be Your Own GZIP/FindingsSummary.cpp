@@ -0,0 +1,139 @@
+#include "FindingsSummary.h"
+
+#include <string>
+#include <type_traits>
+
+FINDINGS_SUMMARY::FINDINGS_SUMMARY(const bool KeepHeaderPositions) : m_KeepHeaderPositions{ KeepHeaderPositions }
+{
+}
+
+void FINDINGS_SUMMARY::AddFinding(const FINDINGS& Finding)
+{
+	auto& Summary{ m_Formats[static_cast<size_t>(Finding.Format)] };
+
+	if (Finding.Aborted && Finding.Container.empty())
+	{
+		++Summary.CandidatesAborted;
+		if (m_KeepHeaderPositions)
+			Summary.AbortedPositions.push_back(Finding.Position);
+	}
+
+	if (Finding.Container.empty() == false)
+	{
+		if (Finding.ValidFile && (Finding.Filtered == false))
+		{
+			++Summary.NestedFilesFound;
+			if (m_KeepHeaderPositions)
+				Summary.NestedFilePaths.push_back(Finding.GetPath());
+		}
+
+		return;
+	}
+
+	++Summary.Occurrences;
+
+	if (Finding.ValidHeader == false)
+		return;
+
+	++Summary.HeadersFound;
+	if (m_KeepHeaderPositions)
+		Summary.HeaderPositions.push_back(Finding.Position);
+
+	if (Finding.Recovered)
+		++Summary.FilesRecovered;
+
+	if (Finding.Filtered)
+	{
+		++Summary.CandidatesFiltered;
+
+		return;
+	}
+
+	if (Finding.ValidFile)
+	{
+		++Summary.FilesFound;
+		if (Finding.Duplicate)
+			++Summary.FilesDuplicated;
+		if (Finding.BGZFBlocks > 1)
+		{
+			++Summary.BGZFChainsFound;
+			Summary.BGZFBlocksFound += Finding.BGZFBlocks;
+			if (Finding.BGZFEndMarker == false)
+				++Summary.BGZFChainsTruncated;
+		}
+	}
+}
+
+const FORMAT_SUMMARY& FINDINGS_SUMMARY::GetFormatSummary(const SIGNATURE_FORMAT Format) const
+{
+	return m_Formats[static_cast<size_t>(Format)];
+}
+
+// A list is saved on a single line, as its name, its length, and its items.
+template <typename ITEM>
+static void SaveList(std::ostream& Stream, const char* const Name, const std::vector<ITEM>& List)
+{
+	Stream << Name << ' ' << List.size();
+	for (const auto& Item : List)
+		if constexpr (std::is_same_v<ITEM, std::wstring>)
+			Stream << ' ' << std::filesystem::path{ Item }.string();
+		else
+			Stream << ' ' << Item;
+	Stream << '\n';
+}
+
+template <typename ITEM>
+static bool LoadList(std::istream& Stream, const char* const Name, std::vector<ITEM>& out_List)
+{
+	std::string Key;
+	size_t Length;
+	if (((Stream >> Key >> Length) && (Key == Name)) == false)
+		return false;
+
+	out_List.clear();
+	for (size_t i{ 0 }; i < Length; ++i)
+	{
+		if constexpr (std::is_same_v<ITEM, std::wstring>)
+		{
+			std::string Item;
+			if (static_cast<bool>(Stream >> Item) == false)
+				return false;
+			out_List.push_back(std::filesystem::path{ Item }.wstring());
+		}
+		else
+		{
+			ITEM Item;
+			if (static_cast<bool>(Stream >> Item) == false)
+				return false;
+			out_List.push_back(Item);
+		}
+	}
+
+	return true;
+}
+
+void FINDINGS_SUMMARY::SaveState(std::ostream& Stream) const
+{
+	for (const auto& Summary : m_Formats)
+	{
+		Stream << "summary " << Summary.Occurrences << ' ' << Summary.HeadersFound << ' ' << Summary.FilesFound << ' ' << Summary.FilesRecovered << ' ' << Summary.FilesDuplicated << ' ' << Summary.BGZFChainsFound << ' ' << Summary.BGZFBlocksFound << ' ' << Summary.BGZFChainsTruncated << ' ' << Summary.CandidatesAborted << ' ' << Summary.CandidatesFiltered << ' ' << Summary.NestedFilesFound << '\n';
+		SaveList(Stream, "header_positions", Summary.HeaderPositions);
+		SaveList(Stream, "aborted_positions", Summary.AbortedPositions);
+		SaveList(Stream, "nested_file_paths", Summary.NestedFilePaths);
+	}
+}
+
+bool FINDINGS_SUMMARY::LoadState(std::istream& Stream)
+{
+	for (auto& Summary : m_Formats)
+	{
+		std::string Key;
+		if (((Stream >> Key >> Summary.Occurrences >> Summary.HeadersFound >> Summary.FilesFound >> Summary.FilesRecovered >> Summary.FilesDuplicated >> Summary.BGZFChainsFound >> Summary.BGZFBlocksFound >> Summary.BGZFChainsTruncated >> Summary.CandidatesAborted >> Summary.CandidatesFiltered >> Summary.NestedFilesFound) && (Key == "summary")) == false)
+			return false;
+
+		if ((LoadList(Stream, "header_positions", Summary.HeaderPositions) && LoadList(Stream, "aborted_positions", Summary.AbortedPositions) && LoadList(Stream, "nested_file_paths", Summary.NestedFilePaths)) == false)
+			return false;
+	}
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "GZIP.h"
+
+#include <array>
+#include <string>
+#include <vector>
+
+// The statistics for the findings of a single format.
+struct FORMAT_SUMMARY
+{
+	unsigned long long Occurrences{ 0 };
+	unsigned long long HeadersFound{ 0 };
+	unsigned long long FilesFound{ 0 };
+	unsigned long long FilesRecovered{ 0 };
+	unsigned long long FilesDuplicated{ 0 };
+	unsigned long long BGZFChainsFound{ 0 };
+	unsigned long long BGZFBlocksFound{ 0 };
+	unsigned long long BGZFChainsTruncated{ 0 };
+	unsigned long long CandidatesAborted{ 0 };
+	unsigned long long CandidatesFiltered{ 0 };
+
+	// The positions of the valid headers, in the order they were found; only kept if asked for.
+	std::vector<unsigned long long> HeaderPositions;
+	// The positions of the candidates abandoned for going past the validation budget, so that they can be revisited; only kept if asked for.
+	std::vector<unsigned long long> AbortedPositions;
+
+	// Files found in the decompressed data of other files are only counted here, once extracted, and not among the candidates of the scanned file itself.
+	unsigned long long NestedFilesFound{ 0 };
+	// The paths of the nested files extracted, as given by FINDINGS::GetPath(); only kept if asked for.
+	std::vector<std::wstring> NestedFilePaths;
+};
+
+// Sums up the findings of a scan by format, in constant memory; unless the positions of the valid headers are kept, which takes 8 bytes for each of them. Rejected candidates are only ever counted.
+class FINDINGS_SUMMARY : public FINDINGS_SINK
+{
+	const bool m_KeepHeaderPositions;
+	std::array<FORMAT_SUMMARY, SIGNATURE_FORMAT_COUNT> m_Formats;
+
+public:
+	FINDINGS_SUMMARY() = delete;
+	explicit FINDINGS_SUMMARY(bool KeepHeaderPositions);
+
+	void AddFinding(const FINDINGS& Finding) override;
+	void SaveState(std::ostream& Stream) const override;
+	bool LoadState(std::istream& Stream) override;
+
+	const FORMAT_SUMMARY& GetFormatSummary(SIGNATURE_FORMAT Format) const;
+};
\ No newline at end of file
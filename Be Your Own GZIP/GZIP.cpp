@@ -1,53 +1,102 @@
 #include "GZIP.h"
 
+#include "Base64.h"
+#include "Carving.h"
+#include "Checkpoint.h"
+#include "Deduplication.h"
 #include "DEFLATE.h"
-
+#include "InflateContext.h"
+#include "InputSource.h"
+#include "MemoryStream.h"
+#include "OutputData.h"
+#include "Progress.h"
+#include "TeeStream.h"
+#include "Tracing.h"
+#include "ZIP.h"
+#include "ZLIB.h"
+
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 
-#define WIN32_LEAN_AND_MEAN
-#define VC_EXTRALEAN
-#include <Windows.h>
-
-FINDINGS::FINDINGS(const size_t par_Position) : Position(par_Position) {};
+FINDINGS::FINDINGS(const unsigned long long par_Position, const SIGNATURE_FORMAT par_Format) : Position(par_Position), Format(par_Format) {};
 
-static std::runtime_error PrepareException(const std::wstring& ErrorMessage)
+std::wstring FINDINGS::GetPath() const
 {
-	std::u8string msg;
-	msg.resize(WideCharToMultiByte(CP_UTF8, NULL, ErrorMessage.c_str(), -1, NULL, 0, NULL, NULL));
-	WideCharToMultiByte(CP_UTF8, NULL, ErrorMessage.c_str(), -1, reinterpret_cast<char*>(msg.data()), static_cast<int>(msg.size()), NULL, NULL);
+	if (Container.empty())
+		return std::to_wstring(Position);
 
-	return std::runtime_error(reinterpret_cast<const char*>(msg.c_str()));
+	return Container + L"/" + std::to_wstring(Position);
 }
 
-static bool Read4LittleEndianByteValue(std::istream& InputStream, size_t& BytesRead, unsigned long long& Value)
+constexpr int ID1{ 0x1F };
+constexpr int ID2{ 0x8B };
+
+// The extra subfield used by BGZF to record the total size of the block.
+constexpr int BGZF_SI1{ 'B' };
+constexpr int BGZF_SI2{ 'C' };
+// A BGZF block never holds more than 64 KiB of uncompressed data.
+constexpr unsigned long long BGZF_MaximumBlockData{ 65536 };
+
+struct GZIP_MEMBER
 {
-	unsigned long long l_Value{ 0 };
+	// Size of the member, not counting the magic word.
+	unsigned long long Size{ 0 };
+	unsigned long long SizeOfDecompressedData{ 0 };
+	unsigned long long CRC32{ 0 };
+	// Set if the member is a BGZF block whose BSIZE field matches its actual size.
+	bool BGZFBlock{ false };
+	// Where the compressed data starts, once the header has been validated.
+	std::streampos DataPosition{ 0 };
+};
+
+// Matches Text against a pattern in which '*' stands for any number of characters, and '?' for any single one, regardless of the case of letters. Only the last '*' met is ever gone back to, which is enough for a match to be found if there is one.
+static bool MatchesPattern(const std::string& Text, const std::string& Pattern)
+{
+	const auto Fold{ [](const char Character) { return ((Character >= 'A') && (Character <= 'Z')) ? static_cast<char>(Character - 'A' + 'a') : Character; } };
 
-	for (int i{ 0 }; i < 4; ++i)
+	size_t TextPosition{ 0 }, PatternPosition{ 0 };
+	size_t StarPosition{ std::string::npos }, StarTextPosition{ 0 };
+	while (TextPosition < Text.size())
 	{
-		auto Byte{ InputStream.get() };
-
-		if (Byte == std::char_traits<char>::eof())
-			return false;
-		else
+		if ((PatternPosition < Pattern.size()) && (Pattern[PatternPosition] == '*'))
+		{
+			StarPosition = PatternPosition++;
+			StarTextPosition = TextPosition;
+		}
+		else if ((PatternPosition < Pattern.size()) && ((Pattern[PatternPosition] == '?') || (Fold(Pattern[PatternPosition]) == Fold(Text[TextPosition]))))
 		{
-			++BytesRead;
-			l_Value |= static_cast<unsigned long long>(Byte & 0xFF) << (8 * i);
+			++PatternPosition;
+			++TextPosition;
 		}
+		else if (StarPosition != std::string::npos)
+		{
+			// Let the last '*' take one more character.
+			PatternPosition = StarPosition + 1;
+			TextPosition = ++StarTextPosition;
+		}
+		else
+			return false;
 	}
 
-	Value = l_Value;
+	while ((PatternPosition < Pattern.size()) && (Pattern[PatternPosition] == '*'))
+		++PatternPosition;
 
-	return true;
+	return PatternPosition == Pattern.size();
 }
 
-constexpr int ID1{ 0x1F };
-constexpr int ID2{ 0x8B };
-
-static bool ExtractGZIP(std::istream& InputStream, const std::filesystem::path& OutputFilePath, size_t& out_Size, FINDINGS& Findings)
+// Validates a single GZIP member, starting right after its magic word. On success, the stream is left positioned right after the member.
+// If ptr_Filter is given, a member whose header does not meet it is not validated any further: Findings.Filtered is set, and false returned.
+static bool ValidateGZIP(INFLATE_CONTEXT& Context, std::istream& InputStream, const SCAN_OPTIONS& Options, const GZIP_FILTER* const ptr_Filter, GZIP_MEMBER& out_Member, FINDINGS& Findings)
 {
-	const auto StartPosition{ InputStream.tellg() };
-	size_t l_Size{ 0 };
+	TRACE_SPAN(HeaderSpan, "GZIP header");
+
+	unsigned long long l_Size{ 0 };
+	int BSIZE{ -1 };
+	// Only kept for the filter.
+	unsigned long long ModificationTime{ 0 };
+	int OperatingSystem{ -1 };
+	std::string FileName;
 
 	// Check if the byte describing the compression method used is set to a valid value.
 	const auto CompressionMethod{ InputStream.get() };
@@ -112,16 +161,9 @@ static bool ExtractGZIP(std::istream& InputStream, const std::filesystem::path&
 		++l_Size;
 	}
 
-	// Skip the MTIME field.
-	{	
-		for (int i{ 0 }; i < 4; ++i)
-		{
-			if (InputStream.get() == std::char_traits<char>::eof())
-				return false;
-
-			++l_Size;
-		}
-	}
+	// Read the MTIME field.
+	if ((Read4LittleEndianByteValue(InputStream, l_Size, ModificationTime)) == false)
+		return false;
 
 	// Skip the extra flags.
 	{
@@ -133,7 +175,8 @@ static bool ExtractGZIP(std::istream& InputStream, const std::filesystem::path&
 
 	// Read the OS field.
 	{
-		switch (InputStream.get())
+		OperatingSystem = InputStream.get();
+		switch (OperatingSystem)
 		{
 			case 0:// FAT filesystem (MS-DOS, OS/2, NT/Win32)
 			case 1:// Amiga
@@ -161,29 +204,64 @@ static bool ExtractGZIP(std::istream& InputStream, const std::filesystem::path&
 
 	if (Flags.FEXTRA)
 	{
-		// Read the extra length field.
-		const auto ExtraLength{ InputStream.get() };
+		// Read the XLEN field.
+		int ExtraLength{ 0 };
+		for (int i{ 0 }; i < 2; ++i)
 		{
-			if (ExtraLength == std::char_traits<char>::eof())
+			const auto Byte{ InputStream.get() };
+			if (Byte == std::char_traits<char>::eof())
 				return false;
 
+			ExtraLength |= (Byte & 0xFF) << (8 * i);
 			++l_Size;
 		}
 
-		// Skip the extra field.
-		for (int i{ 0 }; i < ExtraLength; ++i)
+		// Read the extra field.
+		std::vector<unsigned char> ExtraField(ExtraLength);
+		if (ExtraLength > 0)
 		{
-			if (InputStream.get() == std::char_traits<char>::eof())
+			InputStream.read(reinterpret_cast<char*>(ExtraField.data()), ExtraLength);
+			if (InputStream.gcount() != ExtraLength)
 				return false;
 
-			++l_Size;
+			l_Size += ExtraLength;
+		}
+
+		// Walk the subfields, looking for the BGZF block size. A malformed subfield list does not invalidate the header, but it does disqualify the member from being treated as a BGZF block.
+		for (int SubfieldStart{ 0 }; SubfieldStart < ExtraLength; )
+		{
+			if (ExtraLength - SubfieldStart < 4)
+			{
+				BSIZE = -1;
+
+				break;
+			}
+
+			const auto SI1{ ExtraField[SubfieldStart] };
+			const auto SI2{ ExtraField[SubfieldStart + 1] };
+			const int SubfieldLength{ ExtraField[SubfieldStart + 2] | (ExtraField[SubfieldStart + 3] << 8) };
+			SubfieldStart += 4;
+
+			if (SubfieldLength > ExtraLength - SubfieldStart)
+			{
+				BSIZE = -1;
+
+				break;
+			}
+
+			if ((SI1 == BGZF_SI1) && (SI2 == BGZF_SI2) && (SubfieldLength == 2))
+				BSIZE = ExtraField[SubfieldStart] | (ExtraField[SubfieldStart + 1] << 8);
+
+			SubfieldStart += SubfieldLength;
 		}
 	}
 
-	// Skip the original filename.
+	// Skip the original filename, unless the filter needs it.
+	const bool KeepFileName{ (ptr_Filter != nullptr) && (ptr_Filter->NamePattern.empty() == false) };
 	if (Flags.FNAME)
 	{
 		int NameCharacter{ std::char_traits<char>::eof() };
+		unsigned long long NameLength{ 0 };
 		do
 		{
 			NameCharacter = InputStream.get();
@@ -192,6 +270,12 @@ static bool ExtractGZIP(std::istream& InputStream, const std::filesystem::path&
 
 			++l_Size;
 
+			if (KeepFileName && (NameCharacter != 0))
+				FileName.push_back(static_cast<char>(NameCharacter));
+
+			if ((++NameLength > Options.Budget.MaximumHeaderStringLength) && (Options.Budget.MaximumHeaderStringLength > 0))
+				throw VALIDATION_BUDGET_EXCEPTION("The file name in the header is longer than the validation budget allows.");
+
 		} while (NameCharacter != 0);
 	}
 
@@ -199,6 +283,7 @@ static bool ExtractGZIP(std::istream& InputStream, const std::filesystem::path&
 	if (Flags.FCOMMENT)
 	{
 		int CommentCharacter{ std::char_traits<char>::eof() };
+		unsigned long long CommentLength{ 0 };
 		do
 		{
 			CommentCharacter = InputStream.get();
@@ -207,6 +292,9 @@ static bool ExtractGZIP(std::istream& InputStream, const std::filesystem::path&
 
 			++l_Size;
 
+			if ((++CommentLength > Options.Budget.MaximumHeaderStringLength) && (Options.Budget.MaximumHeaderStringLength > 0))
+				throw VALIDATION_BUDGET_EXCEPTION("The file comment in the header is longer than the validation budget allows.");
+
 		} while (CommentCharacter != 0);
 	}
 
@@ -224,6 +312,23 @@ static bool ExtractGZIP(std::istream& InputStream, const std::filesystem::path&
 
 	// Header has now been confirmed to be valid.
 	Findings.ValidHeader = true;
+	out_Member.DataPosition = InputStream.tellg();
+	TRACE_ARGUMENT(HeaderSpan, "size", 2 + l_Size);
+	TRACE_END(HeaderSpan);
+
+	// Skip the member before any of its data gets inflated, if its header does not meet the filter.
+	if (ptr_Filter != nullptr)
+	{
+		const bool NameMatches{ (KeepFileName == false) || (Flags.FNAME && MatchesPattern(FileName, ptr_Filter->NamePattern)) };
+		const bool TimeMatches{ (ModificationTime >= ptr_Filter->MinimumTime) && (ModificationTime <= ptr_Filter->MaximumTime) };
+		const bool OperatingSystemMatches{ (ptr_Filter->OperatingSystem < 0) || (ptr_Filter->OperatingSystem == OperatingSystem) };
+		if ((NameMatches && TimeMatches && OperatingSystemMatches) == false)
+		{
+			Findings.Filtered = true;
+
+			return false;
+		}
+	}
 
 	// Make sure there is at least one byte of the compressed data.
 	if (InputStream.peek() == std::char_traits<char>::eof())
@@ -231,14 +336,14 @@ static bool ExtractGZIP(std::istream& InputStream, const std::filesystem::path&
 
 	// Validate the compressed data, and the footer.
 	{
-		size_t SizeOfDecompressedData;
+		unsigned long long SizeOfDecompressedData;
 		unsigned long long CRC32ofDecompressedData;
 
 		switch (CompressionMethod)
 		{
 			case 8:
 			{
-				if (ValidateDEFLATEdata(InputStream, l_Size, SizeOfDecompressedData, CRC32ofDecompressedData) == false)
+				if (ValidateDEFLATEdata(Context, InputStream, l_Size, SizeOfDecompressedData, CRC32ofDecompressedData, Options.ValidationLevel, CHECKSUM_TYPE::CRC32, Options.Threads, Options.Budget) == false)
 					return false;
 
 				break;
@@ -248,113 +353,606 @@ static bool ExtractGZIP(std::istream& InputStream, const std::filesystem::path&
 		}
 
 		// Validate the CRC32 field.
-		{
-			unsigned long long RecordedCRC32;
-			if ((Read4LittleEndianByteValue(InputStream, l_Size, RecordedCRC32)) == false)
-				return false;
+		TRACE_SPAN(FooterSpan, "CRC32 check");
+		unsigned long long RecordedCRC32;
+		if ((Read4LittleEndianByteValue(InputStream, l_Size, RecordedCRC32)) == false)
+			return false;
 
-			if (RecordedCRC32 != CRC32ofDecompressedData)
-				return false;
-		}
+		if ((Options.ValidationLevel == VALIDATION_LEVEL::FULL) && (RecordedCRC32 != CRC32ofDecompressedData))
+			return false;
 
-		// Validate the ISIZE field.
+		// Validate the ISIZE field, which only holds the size of the decompressed data modulo 2^32.
 		{
 			unsigned long long RecordedSize;
 			if ((Read4LittleEndianByteValue(InputStream, l_Size, RecordedSize)) == false)
 				return false;
 
-			if (RecordedSize != SizeOfDecompressedData)
+			if (RecordedSize != (SizeOfDecompressedData & 0xFFFFFFFF))
 				return false;
 		}
+
+		out_Member.SizeOfDecompressedData = SizeOfDecompressedData;
+		out_Member.CRC32 = RecordedCRC32;
+	}
+
+	out_Member.Size = l_Size;
+	out_Member.BGZFBlock = (BSIZE >= 0) && (static_cast<unsigned long long>(BSIZE) + 1 == l_Size + 2) && (out_Member.SizeOfDecompressedData <= BGZF_MaximumBlockData);
+
+	return true;
+}
+
+// Extends a validated BGZF block with the BGZF blocks that directly follow it. The chain ends at the end-of-file marker block (an empty BGZF block), or at the first thing that is not a valid BGZF block.
+// If ptr_Blocks is given, the blocks found are added to it.
+static void FollowBGZFChain(INFLATE_CONTEXT& Context, std::istream& InputStream, const SCAN_OPTIONS& Options, unsigned long long& io_Size, FINDINGS& Findings, std::vector<GZIP_MEMBER>* const ptr_Blocks)
+{
+	for (;;)
+	{
+		const auto BlockPosition{ InputStream.tellg() };
+
+		GZIP_MEMBER Block;
+		FINDINGS BlockFindings{ 0, SIGNATURE_FORMAT::GZIP };
+		const bool ValidBlock{ (InputStream.get() == ID1) && (InputStream.get() == ID2) && ValidateGZIP(Context, InputStream, Options, nullptr, Block, BlockFindings) && Block.BGZFBlock };
+		if (ValidBlock == false)
+		{
+			InputStream.clear();
+			InputStream.seekg(BlockPosition);
+			if (InputStream.good() == false)
+				throw std::runtime_error("An error occured while reading the binary.");
+
+			return;
+		}
+
+		io_Size += 2 + Block.Size;
+		++Findings.BGZFBlocks;
+		if (ptr_Blocks != nullptr)
+			ptr_Blocks->push_back(Block);
+
+		if (Block.SizeOfDecompressedData == 0)
+		{
+			Findings.BGZFEndMarker = true;
+
+			return;
+		}
+	}
+}
+
+// Writes a description of what was recovered from a damaged member, segment by segment.
+static void WriteRecoveryReport(const std::filesystem::path& ReportFilePath, const unsigned long long MemberPosition, const std::vector<RECOVERED_SEGMENT>& Segments)
+{
+	auto Report{ CreateOutputFile(ReportFilePath) };
+
+	Report << "Recovery report for the damaged GZIP member at offset " << MemberPosition << "." << std::endl;
+	Report << "Compressed positions are in bits, counted from the start of the compressed data; decompressed positions are in bytes, counted from the start of the recovered data." << std::endl;
+	Report << "Bytes that refer to data lost to the damage are written as '" << OUTPUT_DATA_RECOVERY::UnknownByte << "'. The data decoded right before the damage may itself be damaged." << std::endl << std::endl;
+
+	for (size_t i{ 0 }; i < Segments.size(); ++i)
+	{
+		const auto& Segment{ Segments[i] };
+
+		if ((i > 0) && (Segment.StartPosition > Segments[i - 1].EndPosition))
+			Report << "Damaged: compressed bits " << Segments[i - 1].EndPosition << " to " << Segment.StartPosition << " skipped." << std::endl;
+
+		Report << "Recovered: compressed bits " << Segment.StartPosition << " to " << Segment.EndPosition << ", decompressed bytes " << Segment.OutputPosition << " to " << (Segment.OutputPosition + Segment.OutputSize) << " (" << Segment.UnknownBytes << " of them unknown), ";
+		if (Segment.FinalBlockReached)
+			Report << "up to the end of the data." << std::endl;
+		else
+			Report << "up to damaged data." << std::endl;
+	}
+
+	if (Report.good() == false)
+		throw PrepareException(L"An error occured while writing to a file:\n   " + ReportFilePath.wstring());
+}
+
+// Recovers what can be recovered from a member whose header is valid, but whose data is not, writing the recovered data next to where the member would have been extracted.
+// A member whose very first block cannot be decoded is more likely to be no member at all than a damaged one, so nothing is written for it.
+static void RecoverGZIP(INFLATE_CONTEXT& Context, std::istream& InputStream, const std::streampos DataPosition, const std::filesystem::path& OutputFilePath, FINDINGS& Findings)
+{
+	auto RecoveredFilePath{ OutputFilePath };
+	RecoveredFilePath.replace_extension(L".recovered");
+
+	auto Recovered{ CreateOutputFile(RecoveredFilePath) };
+
+	InputStream.clear();
+	InputStream.seekg(DataPosition);
+	if (InputStream.good() == false)
+		throw std::runtime_error("An error occured while reading the binary.");
+
+	std::vector<RECOVERED_SEGMENT> Segments;
+	RecoverDEFLATEdata(Context, InputStream, Recovered, Segments);
+
+	if (Recovered.good() == false)
+		throw PrepareException(L"An error occured while writing to a file:\n   " + RecoveredFilePath.wstring());
+
+	Recovered.close();
+
+	if (Segments.empty() || (Segments.front().EndPosition == 0))
+	{
+		std::filesystem::remove(RecoveredFilePath);
+
+		return;
+	}
+
+	auto ReportFilePath{ OutputFilePath };
+	ReportFilePath.replace_extension(L".recovered.txt");
+	WriteRecoveryReport(ReportFilePath, Findings.Position, Segments);
+
+	Findings.Recovered = true;
+}
+
+// If ptr_Duplicates is given, a member identical to one already extracted is not written again.
+static bool ExtractGZIP(INFLATE_CONTEXT& Context, std::istream& InputStream, const std::filesystem::path& OutputFilePath, const SCAN_OPTIONS& Options, DUPLICATE_FILTER* const ptr_Duplicates, unsigned long long& out_Size, GZIP_MEMBER& Member, FINDINGS& Findings)
+{
+	const auto StartPosition{ InputStream.tellg() - std::streamoff{ 2 } };
+
+	if (ValidateGZIP(Context, InputStream, Options, &Options.Filter, Member, Findings) == false)
+	{
+		if (Options.Recover && Findings.ValidHeader && (Findings.Filtered == false))
+			RecoverGZIP(Context, InputStream, Member.DataPosition, OutputFilePath, Findings);
+
+		return false;
 	}
 
 	// The entire file has now been validated.
 	Findings.ValidFile = true;
 
-	// Ouput the found GZIP data to a file.
+	// A BGZF block is only the first piece of a BGZF file; validate the rest of the chain, so that it can be extracted as one unit.
+	// The blocks are only kept if the chain is to be decompressed to the standard output.
+	unsigned long long l_Size{ Member.Size };
+	const bool KeepBlocks{ Options.StandardOutput == STANDARD_OUTPUT_MODE::INFLATED };
+	std::vector<GZIP_MEMBER> Blocks;
+	if (KeepBlocks)
+		Blocks.push_back(Member);
+
+	if (Member.BGZFBlock)
+	{
+		Findings.BGZFBlocks = 1;
+		if (Member.SizeOfDecompressedData == 0)
+			Findings.BGZFEndMarker = true;
+		else
+			FollowBGZFChain(Context, InputStream, Options, l_Size, Findings, KeepBlocks ? &Blocks : nullptr);
+	}
+
+	out_Size = l_Size;
+
+	// The size of a member, or of a chain, is only known once it has been validated; one that is too small is passed over as a whole, but not written.
+	if (2 + l_Size < Options.Filter.MinimumSize)
 	{
-		if (!std::filesystem::exists(OutputFilePath))
-			throw PrepareException(L"Could not create a new file:\n   " + OutputFilePath.wstring());
+		Findings.Filtered = true;
 
+		return true;
+	}
+
+	// The fingerprint of a BGZF chain is that of its first block, but the hash confirming it covers the whole chain.
+	if ((ptr_Duplicates != nullptr) && ptr_Duplicates->IsDuplicate(InputStream, StartPosition, 2 + l_Size, Member.CRC32, Member.SizeOfDecompressedData, OutputFilePath.filename()))
+	{
+		Findings.Duplicate = true;
+
+		return true;
+	}
+
+	// Ouput the found GZIP data to a file, or to the standard output.
+	switch (Options.StandardOutput)
+	{
+		case STANDARD_OUTPUT_MODE::NONE:
+			WriteCarvedData(InputStream, StartPosition, 2 + l_Size, OutputFilePath);
+			break;
+		case STANDARD_OUTPUT_MODE::FRAMED:
+			WriteCarvedDataToStandardOutput(InputStream, StartPosition, 2 + l_Size, Findings.GetPath() + OutputFilePath.extension().wstring());
+			break;
+		case STANDARD_OUTPUT_MODE::CONCATENATED:
+			WriteCarvedDataToStandardOutput(InputStream, StartPosition, 2 + l_Size, L"");
+			break;
+		case STANDARD_OUTPUT_MODE::INFLATED:
 		{
-			const auto ParentDirectory{ OutputFilePath.parent_path() };
-			if (std::filesystem::exists(ParentDirectory))
+			std::vector<std::streampos> DataPositions;
+			unsigned long long SizeOfDecompressedData{ 0 };
+			for (const auto& Block : Blocks)
 			{
-				if (std::filesystem::is_directory(ParentDirectory) == false)
-					throw PrepareException(L"Could not create a new file:\n   " + OutputFilePath.wstring());
+				DataPositions.push_back(Block.DataPosition);
+				SizeOfDecompressedData += Block.SizeOfDecompressedData;
 			}
-			else
-				std::filesystem::create_directories(ParentDirectory);
+
+			InflateToStandardOutput(Context, InputStream, DataPositions, SizeOfDecompressedData, Findings.GetPath() + OutputFilePath.extension().wstring());
 		}
+	}
+
+	return true;
+}
+
+// The largest GZIP decoded from base64 text; it is held in memory while it is validated.
+constexpr size_t MaximumBase64DataSize{ 1ull << 30 };
+
+// Decodes the run of base64 text that "H4sI" starts, 2 bytes before the current position of the stream, and extracts the GZIP member it encodes as though it had been found in a file of its own, holding nothing but the decoded data; the member is written out decoded.
+// The decoded data is left in the Decoder, where the next run replaces it; so these members are not deduplicated. out_Size is the length of the text, not counting those 2 bytes, so that the scan can skip over it as it does over a member.
+// No more is decoded than the budget allows for the compressed size; a member cut short there is abandoned.
+static bool ExtractBase64GZIP(INFLATE_CONTEXT& Context, std::istream& InputStream, BASE64_DECODER& Decoder, const std::filesystem::path& OutputFilePath, const SCAN_OPTIONS& Options, unsigned long long& out_Size, GZIP_MEMBER& Member, FINDINGS& Findings)
+{
+	InputStream.seekg(InputStream.tellg() - std::streamoff{ 2 });
+	if (InputStream.good() == false)
+		throw std::runtime_error("An error occured while reading the binary.");
 
-		std::ofstream OutputStream;
-		OutputStream.open(OutputFilePath, std::ofstream::binary);
-		if (OutputStream.good() == false)
-			throw PrepareException(L"Could not write to a file:\n   " + OutputFilePath.wstring());
+	auto MaximumDataLength{ MaximumBase64DataSize };
+	if (Options.Budget.MaximumCompressedSize > 0)
+		MaximumDataLength = static_cast<size_t>(std::min<unsigned long long>(MaximumDataLength, Options.Budget.MaximumCompressedSize));
 
-		out_Size = l_Size;
+	bool Ended;
+	const auto TextLength{ Decoder.DecodeRun(InputStream, MaximumDataLength, Ended) };
+	out_Size = TextLength - 2;
 
+	// The text is read ahead in chunks; only a run that went on to the end of the data leaves the stream at its end, as a member read up to there does.
+	if (Ended)
 		InputStream.clear();
-		InputStream.seekg(StartPosition);
-		if (InputStream.good() == false)
+
+	MEMORY_STREAM_BUFFER Buffer{ Decoder.GetData(), Decoder.GetDataLength() };
+	std::istream DecodedStream{ &Buffer };
+	if ((DecodedStream.get() != ID1) || (DecodedStream.get() != ID2))
+		return false;
+
+	unsigned long long Size;
+	if (ExtractGZIP(Context, DecodedStream, OutputFilePath, Options, nullptr, Size, Member, Findings))
+		return true;
+
+	if (DecodedStream.eof() && (Decoder.GetDataLength() >= MaximumDataLength) && (MaximumDataLength < MaximumBase64DataSize))
+		throw VALIDATION_BUDGET_EXCEPTION("The base64 text went past the validation budget.");
+
+	return false;
+}
+
+// Checks 8 bytes at a time, which the compiler can widen further.
+static bool IsAllZeros(const unsigned char* const Data, const size_t Length)
+{
+	unsigned long long Bits{ 0 };
+
+	size_t i{ 0 };
+	for (; i + 8 <= Length; i += 8)
+	{
+		unsigned long long Word;
+		std::memcpy(&Word, Data + i, 8);
+		Bits |= Word;
+	}
+	for (; i < Length; ++i)
+		Bits |= Data[i];
+
+	return Bits == 0;
+}
+
+// The largest decompressed member whose data is scanned for nested files; the data is held in memory while it is scanned.
+constexpr size_t MaximumNestedDataSize{ 1ull << 30 };
+
+static void ScanStream(INFLATE_CONTEXT& Context, std::istream& BinaryStream, const std::vector<DATA_RANGE>& DataRanges, const std::filesystem::path& OutputFolder_Path, FINDINGS_SINK& Sink, const SCAN_OPTIONS& Options, const std::wstring& Container, unsigned int Depth, SCAN_PROGRESS* ptr_Progress, SCAN_CHECKPOINT* ptr_Checkpoint);
+
+// Decompresses a validated member into memory, and scans its decompressed data for files nested in it, as though it were a file of its own. Nothing but the nested files found is written out.
+// The nested files are extracted to a folder named after the offset of the member, next to the member itself.
+static void ScanNestedData(INFLATE_CONTEXT& Context, std::istream& InputStream, const GZIP_MEMBER& Member, const FINDINGS& Findings, const std::filesystem::path& OutputFolder_Path, FINDINGS_SINK& Sink, const SCAN_OPTIONS& Options, const unsigned int Depth)
+{
+	if (Member.SizeOfDecompressedData > MaximumNestedDataSize)
+		return;
+
+	InputStream.clear();
+	InputStream.seekg(Member.DataPosition);
+	if (InputStream.good() == false)
+		throw std::runtime_error("An error occured while reading the binary.");
+
+	std::vector<unsigned char> Data;
+	Data.reserve(static_cast<size_t>(Member.SizeOfDecompressedData));
+	if (InflateDEFLATEdata(Context, InputStream, Data) == false)
+		return;
+
+	MEMORY_STREAM_BUFFER Buffer{ Data.data(), Data.size() };
+	std::istream NestedStream{ &Buffer };
+
+	ScanStream(Context, NestedStream, { { 0, Data.size() } }, OutputFolder_Path / std::to_wstring(Findings.Position), Sink, Options, Findings.GetPath(), Depth, nullptr, nullptr);
+}
+
+// Scans the stream in large chunks, looking for the signatures of all the selected formats in a single pass over each chunk, and tries to extract a file at every signature found.
+// A chain of more than one BGZF block is always skipped over as a whole, as otherwise every block in it would be reported and extracted again on its own.
+// Container is the path of the member whose decompressed data the stream holds, empty for the scanned file itself; the members found are scanned in turn, as long as Depth is not 0.
+// If ptr_Checkpoint is given, the scan starts from the checkpoint, if resuming, and a checkpoint is taken between chunks, once every candidate in a chunk has been dealt with.
+// Only signatures starting within the DataRanges are looked for, but the files found are followed wherever they go.
+static void ScanStream(INFLATE_CONTEXT& Context, std::istream& BinaryStream, const std::vector<DATA_RANGE>& DataRanges, const std::filesystem::path& OutputFolder_Path, FINDINGS_SINK& Sink, const SCAN_OPTIONS& Options, const std::wstring& Container, const unsigned int Depth, SCAN_PROGRESS* const ptr_Progress, SCAN_CHECKPOINT* const ptr_Checkpoint)
+{
+	std::unique_ptr<DUPLICATE_FILTER> Duplicates;
+	if (Options.Deduplicate)
+		Duplicates = std::make_unique<DUPLICATE_FILTER>(OutputFolder_Path / L"duplicates.csv");
+
+	// Data already in memory, such as that of a nested scan, is not read through a tee.
+	auto* const ptr_Tee{ dynamic_cast<TEE_STREAM_BUFFER*>(BinaryStream.rdbuf()) };
+
+	constexpr size_t ScanChunkSize{ 1 << 20 };
+	std::vector<unsigned char> ScanChunk(ScanChunkSize);
+	std::vector<SIGNATURE_CANDIDATE> Candidates;
+	// Only used if GZIPs in base64 text are looked for; kept from one candidate to the next.
+	BASE64_DECODER Base64Decoder;
+
+	unsigned long long Chunk_Offset{ 0 };
+	// Signatures found before this offset are part of an already extracted file, and are skipped.
+	unsigned long long Resume_Offset{ 0 };
+
+	if ((ptr_Checkpoint != nullptr) && Options.Resume && ptr_Checkpoint->Read(Chunk_Offset, Resume_Offset, Sink, Duplicates.get()) && (ptr_Progress != nullptr))
+	{
+		ptr_Progress->StartOffset.store(Chunk_Offset, std::memory_order_relaxed);
+		ptr_Progress->Offset.store(Chunk_Offset, std::memory_order_relaxed);
+	}
+
+	for (auto Range{ DataRanges.begin() }; ; )
+	{
+		// Move on to the range the next chunk starts in, skipping over the gaps between ranges.
+		while ((Range != DataRanges.end()) && (Chunk_Offset >= Range->End))
+			++Range;
+		if (Range == DataRanges.end())
+			break;
+		Chunk_Offset = std::max(Chunk_Offset, Range->Start);
+
+		TRACE_SPAN(ChunkSpan, "scan chunk");
+		TRACE_ARGUMENT(ChunkSpan, "offset", Chunk_Offset);
+
+		BinaryStream.clear();
+		BinaryStream.seekg(static_cast<std::streamoff>(Chunk_Offset));
+		if (BinaryStream.good() == false)
 			throw std::runtime_error("An error occured while reading the binary.");
 
-		OutputStream.put(static_cast<char>(ID1));
-		OutputStream.put(static_cast<char>(ID2));
-		while ((l_Size--) > 0)
-			OutputStream.put(InputStream.get());
+		BinaryStream.read(reinterpret_cast<char*>(ScanChunk.data()), ScanChunkSize);
+		const auto ChunkLength{ static_cast<size_t>(BinaryStream.gcount()) };
+
+		// Signatures starting in the last few bytes of a chunk may not fit in it; unless this is the last chunk, leave those to the next one. Nor is any signature starting past the end of the range looked for.
+		const bool LastChunk{ ChunkLength < ScanChunkSize };
+		const size_t ScanLength{ std::min<size_t>(LastChunk ? ChunkLength : (ChunkLength - (SIGNATURE_MAXIMUM_LENGTH - 1)), static_cast<size_t>(std::min<unsigned long long>(Range->End - Chunk_Offset, ScanChunkSize))) };
+
+		// No signature starts with a zero byte, so a chunk of nothing but zeros, as found in large stretches of disk images, need not be searched.
+		Candidates.clear();
+		if (IsAllZeros(ScanChunk.data(), ScanLength) == false)
+			FindSignatures(ScanChunk.data(), ChunkLength, ScanLength, Options.Formats, Candidates);
+		TRACE_ARGUMENT(ChunkSpan, "length", ScanLength);
+		TRACE_ARGUMENT(ChunkSpan, "candidates", Candidates.size());
+
+		for (const auto& Candidate : Candidates)
+		{
+			const unsigned long long Binary_Offset{ Chunk_Offset + Candidate.Position };
+			if (Binary_Offset < Resume_Offset)
+				continue;
+
+			FINDINGS Findings{ Binary_Offset, Candidate.Format };
+			Findings.Container = Container;
 
-		if (OutputStream.good() == false)
-			throw PrepareException(L"An error occured while writing to a file:\n   " + OutputFilePath.wstring());
+			// Every candidate gets a span of its own, so that the ones that take long to be dealt with stand out.
+			TRACE_SPAN(CandidateSpan, "candidate");
+			TRACE_ARGUMENT(CandidateSpan, "offset", Binary_Offset);
+			TRACE_ARGUMENT(CandidateSpan, "format", Candidate.Format);
 
-		OutputStream.close();
+			if (ptr_Progress != nullptr)
+			{
+				ptr_Progress->Offset.store(Binary_Offset, std::memory_order_relaxed);
+				SCAN_PROGRESS::Increment(ptr_Progress->Candidates);
+			}
+
+			// A copy of the candidate is kept as it is read, signature and all, so that it can be written out without being read again.
+			BinaryStream.clear();
+			BinaryStream.seekg(static_cast<std::streamoff>(Binary_Offset));
+			if (ptr_Tee != nullptr)
+				ptr_Tee->StartRecording();
+			BinaryStream.ignore(2);
+			if (BinaryStream.good() == false)
+				throw std::runtime_error("An error occured while reading the binary.");
+
+			unsigned long long Size;
+			GZIP_MEMBER Member;
+			bool Extracted;
+			try
+			{
+				switch (Candidate.Format)
+				{
+					case SIGNATURE_FORMAT::ZLIB:
+					{
+						Extracted = ExtractZLIB(Context, BinaryStream, OutputFolder_Path / (std::to_wstring(Binary_Offset) + L".zlib"), Options, Size, Findings);
+
+						break;
+					}
+					case SIGNATURE_FORMAT::ZIP:
+					{
+						Extracted = ExtractZIPEntry(Context, BinaryStream, OutputFolder_Path / (std::to_wstring(Binary_Offset) + L".zip"), Options, Size, Findings);
+
+						break;
+					}
+					case SIGNATURE_FORMAT::BASE64:
+					{
+						Extracted = ExtractBase64GZIP(Context, BinaryStream, Base64Decoder, OutputFolder_Path / (std::to_wstring(Binary_Offset) + L".gz"), Options, Size, Member, Findings);
+
+						break;
+					}
+					case SIGNATURE_FORMAT::GZIP:
+					default:
+					{
+						Extracted = ExtractGZIP(Context, BinaryStream, OutputFolder_Path / (std::to_wstring(Binary_Offset) + L".gz"), Options, Duplicates.get(), Size, Member, Findings);
+					}
+				}
+			}
+			catch (const VALIDATION_BUDGET_EXCEPTION&)
+			{
+				// Nothing is written before a candidate has been validated, so an abandoned one leaves nothing behind.
+				Findings.ValidFile = false;
+				Findings.BGZFBlocks = 0;
+				Findings.BGZFEndMarker = false;
+				Findings.Recovered = false;
+				Findings.Aborted = true;
+				Extracted = false;
+			}
+
+			// A candidate that read up to the end of the data may have failed only for want of more of it.
+			if ((Findings.ValidFile == false) && (Findings.Aborted == false))
+				Findings.Truncated = BinaryStream.eof();
+
+			if (Extracted && (Findings.Filtered == false) && (ptr_Progress != nullptr))
+				SCAN_PROGRESS::Increment(ptr_Progress->FilesFound);
+
+			Sink.AddFinding(Findings);
+			TRACE_ARGUMENT(CandidateSpan, "valid", Findings.ValidFile);
+			TRACE_END(CandidateSpan);
+
+			// Only the data of a member that validated in full, and was extracted, is scanned. A duplicate has been scanned already, as the original; and the blocks of a BGZF chain are not scanned, as they are rarely anything but a single large file split up.
+			// The data of a member found in base64 text is in the decoder.
+			if (Findings.ValidFile && (Depth > 0) && (Findings.Duplicate == false) && (Findings.Filtered == false) && (Findings.BGZFBlocks == 0))
+			{
+				if (Candidate.Format == SIGNATURE_FORMAT::GZIP)
+					ScanNestedData(Context, BinaryStream, Member, Findings, OutputFolder_Path, Sink, Options, Depth - 1);
+				else if (Candidate.Format == SIGNATURE_FORMAT::BASE64)
+				{
+					MEMORY_STREAM_BUFFER Buffer{ Base64Decoder.GetData(), Base64Decoder.GetDataLength() };
+					std::istream DecodedStream{ &Buffer };
+
+					ScanNestedData(Context, DecodedStream, Member, Findings, OutputFolder_Path, Sink, Options, Depth - 1);
+				}
+			}
+
+			if (Extracted && ((Options.ThoroughMode == false) || (Findings.BGZFBlocks > 1)))
+				Resume_Offset = Binary_Offset + 2 + Size;
+		}
+
+		if (ptr_Progress != nullptr)
+			ptr_Progress->Offset.store(Chunk_Offset + ScanLength, std::memory_order_relaxed);
+
+		if (LastChunk)
+			break;
+
+		Chunk_Offset += ScanLength;
+
+		if (ptr_Checkpoint != nullptr)
+			ptr_Checkpoint->Update(Chunk_Offset, Resume_Offset, Sink, Duplicates.get());
 	}
+}
 
-	return true;
+void ExtractGZIPs(const std::filesystem::path& FileToSplit_Path, const std::filesystem::path& OutputFolder_Path, FINDINGS_SINK& Sink, const SCAN_OPTIONS& Options)
+{
+	// One decoder context serves every candidate in the file, nested ones included.
+	INFLATE_CONTEXT Context;
+
+	ExtractGZIPs(Context, FileToSplit_Path, OutputFolder_Path, Sink, Options);
 }
 
-// If ThoroughMode is false, if program discovers a valid GZIP file, it will pick up searching for the magic word AFTER the GZIP ends. If ThoroughMode is true, it will instead go back to right after the magic word of the GZIP, and continue searching from there.
-std::vector<FINDINGS> ExtractGZIPs(const std::filesystem::path& FileToSplit_Path, const std::filesystem::path& OutputFolder_Path, const bool ThoroughMode)
+void ExtractGZIPs(INFLATE_CONTEXT& Context, const std::filesystem::path& FileToSplit_Path, const std::filesystem::path& OutputFolder_Path, FINDINGS_SINK& Sink, const SCAN_OPTIONS& Options)
 {
-	std::ifstream BinaryStream;
-	BinaryStream.open(FileToSplit_Path, std::fstream::binary);
-	if (BinaryStream.good() == false)
-		throw PrepareException(L"Could not read the file:\n   " + FileToSplit_Path.wstring());
+	INPUT_SOURCE Source{ FileToSplit_Path };
+	const auto FileSize{ Source.GetSize() };
 
-	std::vector<FINDINGS> Findings;
+	// The range to scan, less the holes of a sparse file.
+	const auto End_Offset{ (Options.Length > 0) ? std::min(Options.Offset + Options.Length, FileSize) : FileSize };
+	const auto DataRanges{ Source.GetDataRanges(Options.Offset, End_Offset) };
 
-	size_t Binary_Offset{ 0 };
-	int Byte;
-	while ((Byte = BinaryStream.get()) != std::char_traits<char>::eof())
+	// Progress is only tracked when it is reported.
+	SCAN_PROGRESS Progress;
+	std::unique_ptr<PROGRESS_REPORTER> Reporter;
+	if (Options.ProgressInterval > 0)
 	{
-		if (Byte == ID1)
-			if ((BinaryStream.peek()) == ID2)
+		Progress.TotalSize.store(End_Offset, std::memory_order_relaxed);
+
+		Reporter = std::make_unique<PROGRESS_REPORTER>(Progress, Options.ProgressInterval, Options.StatusFilePath);
+	}
+
+	std::unique_ptr<SCAN_CHECKPOINT> Checkpoint;
+	if ((Options.CheckpointInterval > 0) || Options.Resume)
+		Checkpoint = std::make_unique<SCAN_CHECKPOINT>(OutputFolder_Path, FileSize, Options);
+
+	// The file is read through a tee, so that the files found are written out from the copy kept as they were validated, rather than read again.
+	TEE_STREAM_BUFFER Tee{ *Source.GetStream().rdbuf() };
+	std::istream BinaryStream{ &Tee };
+
+	ScanStream(Context, BinaryStream, DataRanges, OutputFolder_Path, Sink, Options, {}, Options.RecursionDepth, (Reporter != nullptr) ? &Progress : nullptr, Checkpoint.get());
+
+	// The scan is complete, so there is nothing left to resume.
+	if (Checkpoint != nullptr)
+		Checkpoint->Remove();
+}
+
+VERIFY_RESULT VerifyGZIPFile(INFLATE_CONTEXT& Context, const std::filesystem::path& FilePath, const SCAN_OPTIONS& Options)
+{
+	// A member that fails the filter is not validated, and one validated structurally has no CRC32 checked; neither would tell a valid file from a damaged one.
+	SCAN_OPTIONS MemberOptions{ Options };
+	MemberOptions.ValidationLevel = VALIDATION_LEVEL::FULL;
+	MemberOptions.Filter = {};
+
+	INPUT_SOURCE Source{ FilePath };
+	const auto FileSize{ Source.GetSize() };
+	auto& InputStream{ Source.GetStream() };
+
+	VERIFY_RESULT Result;
+	for (unsigned long long Offset{ 0 }; Offset < FileSize; )
+	{
+		Result.FailedOffset = Offset;
+
+		InputStream.clear();
+		InputStream.seekg(static_cast<std::streamoff>(Offset));
+		if (InputStream.good() == false)
+			throw std::runtime_error("An error occured while reading the binary.");
+
+		if ((InputStream.get() != ID1) || (InputStream.get() != ID2))
+		{
+			if (Result.Members == 0)
 			{
-				Findings.emplace_back(Binary_Offset);
+				Result.Reason = L"not a GZIP file";
 
-				const std::filesystem::path OutputFilePath{ OutputFolder_Path / (std::to_wstring(Binary_Offset) + L".gz") };
+				return Result;
+			}
 
-				BinaryStream.get();
-				const auto Backtrack_Binary_Position{ BinaryStream.tellg() };
+			// Whatever follows the last member has to be nothing but zeros.
+			std::vector<unsigned char> Tail(1 << 16);
+			InputStream.clear();
+			InputStream.seekg(static_cast<std::streamoff>(Offset));
+			for (;;)
+			{
+				InputStream.read(reinterpret_cast<char*>(Tail.data()), Tail.size());
+				const auto Length{ static_cast<size_t>(InputStream.gcount()) };
+				if (Length == 0)
+					break;
 
-				size_t Size;
-				if (ExtractGZIP(BinaryStream, OutputFilePath, Size, Findings.back()) && (ThoroughMode == false))
-					Binary_Offset += Size;
-				else
+				if (IsAllZeros(Tail.data(), Length) == false)
 				{
-					BinaryStream.clear();
-					BinaryStream.seekg(Backtrack_Binary_Position);
-					if (BinaryStream.good() == false)
-						throw std::runtime_error("An error occured while reading the binary.");
+					Result.Reason = L"trailing data after the last member";
+
+					return Result;
 				}
+			}
 
-				++Binary_Offset;
+			break;
+		}
+
+		TRACE_SPAN(MemberSpan, "verified member");
+		TRACE_ARGUMENT(MemberSpan, "offset", Offset);
+
+		FINDINGS Findings{ Offset, SIGNATURE_FORMAT::GZIP };
+		GZIP_MEMBER Member;
+		try
+		{
+			if (ValidateGZIP(Context, InputStream, MemberOptions, nullptr, Member, Findings) == false)
+			{
+				if (InputStream.eof())
+					Result.Reason = L"truncated member";
+				else if (Findings.ValidHeader)
+					Result.Reason = L"invalid compressed data or footer";
+				else
+					Result.Reason = L"invalid header";
+
+				return Result;
 			}
+		}
+		catch (const VALIDATION_BUDGET_EXCEPTION&)
+		{
+			Result.Reason = L"member went past the validation budget";
+
+			return Result;
+		}
+
+		++Result.Members;
+		Offset += 2 + Member.Size;
+	}
+
+	if (Result.Members == 0)
+	{
+		Result.Reason = L"empty file";
 
-		++Binary_Offset;
+		return Result;
 	}
 
-	BinaryStream.close();
+	Result.Valid = true;
+	Result.FailedOffset = 0;
 
-	return Findings;
+	return Result;
 }
\ No newline at end of file
@@ -1,15 +1,121 @@
 #pragma once
 
+#include "DEFLATE.h"
+#include "Signatures.h"
+#include "StandardOutput.h"
+
 #include <filesystem>
+#include <istream>
+#include <ostream>
+#include <string>
 
 struct FINDINGS
 {
 	FINDINGS() = delete;
-	explicit FINDINGS(size_t Position);
+	FINDINGS(unsigned long long Position, SIGNATURE_FORMAT Format);
 
-	const size_t Position;
+	// For a GZIP found in base64 text, the offset of the text; the member itself is extracted decoded.
+	const unsigned long long Position;
+	const SIGNATURE_FORMAT Format;
 	bool ValidHeader = false;
 	bool ValidFile = false;
+	// Number of BGZF blocks in the chain that starts here, and whether that chain ends with the BGZF end-of-file marker.
+	unsigned long long BGZFBlocks = 0;
+	bool BGZFEndMarker = false;
+	// Set if the file is damaged, but part of its data was recovered.
+	bool Recovered = false;
+	// Set if the file is identical to one extracted before, and so was not written again.
+	bool Duplicate = false;
+	// Set if the candidate was abandoned, as validating it went past the limits of SCAN_OPTIONS::Budget; it may be valid, and can be revisited with larger limits.
+	bool Aborted = false;
+	// Set if the candidate failed to validate only after running into the end of the data; it may yet validate, if the data is still being written.
+	bool Truncated = false;
+	// Set if the candidate was passed over for not meeting SCAN_OPTIONS::Filter: either its header did not meet it, and its data was not validated; or it is a valid file, but too small, and was not written.
+	bool Filtered = false;
+	// The path of the member whose decompressed data the file was found in, as its offset in the scanned file, followed by its offset in each enclosing member in turn, separated by slashes; empty for a file found in the scanned file itself.
+	std::wstring Container;
+
+	// The offset of the file, prefixed with its Container, if any; such as "1000/52" for a file at offset 52 of the data of the member at offset 1000.
+	std::wstring GetPath() const;
+};
+
+// Receives the findings of a scan one candidate at a time, as soon as each has been dealt with, so that no more of them has to be kept than the receiver wants.
+class FINDINGS_SINK
+{
+public:
+	virtual ~FINDINGS_SINK() = default;
+
+	virtual void AddFinding(const FINDINGS& Finding) = 0;
+
+	// Save and restore what the sink keeps of the findings so far, as text, for a checkpoint of the scan; a sink that keeps nothing has nothing to save. LoadState returns false if the text is not what SaveState writes.
+	virtual void SaveState(std::ostream&) const {}
+	virtual bool LoadState(std::istream&) { return true; }
+};
+
+// Conditions a GZIP member has to meet to be extracted. All but MinimumSize are checked on the header, before any of the data is inflated, so that the members that do not meet them cost next to nothing; a condition left at its default is always met.
+struct GZIP_FILTER
+{
+	// A pattern the file name recorded in the header has to match, in which '*' stands for any number of characters, and '?' for any single one; letters match regardless of case. A member that records no file name never matches.
+	std::string NamePattern;
+	// The range the modification time recorded in the header has to be within, inclusive, in seconds since 1970; a member that records no time has a time of 0.
+	unsigned long long MinimumTime = 0;
+	unsigned long long MaximumTime = 0xFFFFFFFF;
+	// The value the OS byte of the header has to hold; -1 means any.
+	int OperatingSystem = -1;
+	// The smallest size a member has to be, in bytes, header and footer included. The header does not record the size, so this is only checked once the member has been validated.
+	unsigned long long MinimumSize = 0;
+};
+
+struct SCAN_OPTIONS
+{
+	// If ThoroughMode is false, if program discovers a valid GZIP file, it will pick up searching for the magic word AFTER the GZIP ends. If ThoroughMode is true, it will instead go back to right after the magic word of the GZIP, and continue searching from there.
+	bool ThoroughMode = true;
+	// With VALIDATION_LEVEL::STRUCTURAL, the checksum recorded after the compressed data (CRC32 or Adler-32) is not checked; the ISIZE field of a GZIP still is.
+	VALIDATION_LEVEL ValidationLevel = VALIDATION_LEVEL::FULL;
+	// The formats to look for, as a combination of SignatureFormatBit() values.
+	unsigned int Formats = DEFAULT_SIGNATURE_FORMATS;
+	// The number of threads a single large DEFLATE stream may be validated with; 0 means one per processor.
+	unsigned int Threads = 1;
+	// If Recover is true, the data of a GZIP member that has a valid header but fails to validate is decoded as far as possible, skipping over the damaged parts.
+	bool Recover = false;
+	// If ProgressInterval is not 0, the progress of the scan is reported every ProgressInterval seconds: to the standard error stream, or, if StatusFilePath is not empty, to that file, which is replaced with every report.
+	unsigned int ProgressInterval = 0;
+	// If Deduplicate is true, a GZIP member identical to one already extracted from the same file is not written again, but listed in a duplicates.csv manifest, next to the extracted files.
+	bool Deduplicate = false;
+	// If RecursionDepth is not 0, the decompressed data of every GZIP member found is scanned in memory for files nested in it, to that many levels; nested files are extracted to a folder named after the path of their container.
+	unsigned int RecursionDepth = 0;
+	// The limits on the work spent on each candidate; none by default.
+	VALIDATION_BUDGET Budget;
+	// Every CheckpointInterval seconds, a checkpoint of the scan is written to the output folder, so that the scan can be resumed from there if it is interrupted; 0 means never. The checkpoint is removed once the scan is complete.
+	unsigned int CheckpointInterval = 60;
+	// If Length is not 0, only signatures starting within the Length bytes from Offset are looked for; the files found are still followed past the end of that range.
+	unsigned long long Offset = 0;
+	unsigned long long Length = 0;
+	// The GZIP members that do not meet the Filter are skipped; ZLIB streams and ZIP entries are not filtered.
+	GZIP_FILTER Filter;
+	// If StandardOutput is not STANDARD_OUTPUT_MODE::NONE, the files found are written to the standard output, rather than to the output folder; whatever else is written, such as recovered data or checkpoints, still goes to the output folder.
+	STANDARD_OUTPUT_MODE StandardOutput = STANDARD_OUTPUT_MODE::NONE;
+	// If Resume is true, and the output folder holds a checkpoint, the scan carries on from there.
+	bool Resume = false;
+	std::filesystem::path StatusFilePath;
+};
+
+// Every candidate found is passed to the Sink; none of them is kept by the scan itself.
+void ExtractGZIPs(const std::filesystem::path& FileToSplit_Path, const std::filesystem::path& OutputFolder_Path, FINDINGS_SINK& Sink, const SCAN_OPTIONS& Options = {});
+// The same, with a decoder context of the caller's, for a caller that scans file after file on the same thread.
+void ExtractGZIPs(INFLATE_CONTEXT& Context, const std::filesystem::path& FileToSplit_Path, const std::filesystem::path& OutputFolder_Path, FINDINGS_SINK& Sink, const SCAN_OPTIONS& Options);
+
+// The outcome of checking a file as GZIP members, one right after the other, as gzip -t does.
+struct VERIFY_RESULT
+{
+	bool Valid = false;
+	// The number of members that validated, in order from the start of the file.
+	unsigned long long Members = 0;
+	// For a file that is not valid, where the member that failed starts, or where whatever follows the last valid member starts; and why it failed.
+	unsigned long long FailedOffset = 0;
+	std::wstring Reason;
 };
 
-std::vector<FINDINGS> ExtractGZIPs(const std::filesystem::path& FileToSplit_Path, const std::filesystem::path& OutputFolder_Path, bool ThoroughMode = true);
\ No newline at end of file
+// Validates the file as a sequence of GZIP members from offset 0 to its end, with the CRC32 and size in the footer of each; nothing is written. Zeros after the last member, as left by padding to a block size, are allowed.
+// Every member is validated in full, and none is passed over, whatever the ValidationLevel and the Filter of the Options.
+VERIFY_RESULT VerifyGZIPFile(INFLATE_CONTEXT& Context, const std::filesystem::path& FilePath, const SCAN_OPTIONS& Options);
\ No newline at end of file
@@ -0,0 +1,50 @@
+#include "HuffmanTree.h"
+
+HUFFMAN_TREE::HUFFMAN_TREE() : m_NodeCount{ 1 }
+{
+}
+
+void HUFFMAN_TREE::Clear()
+{
+	m_Nodes[0] = {};
+	m_NodeCount = 1;
+}
+
+void HUFFMAN_TREE::Place(const int Value, const int Code, int CodeLength)
+{
+	size_t Node{ 0 };
+	while (CodeLength > 0)
+	{
+		--CodeLength;
+
+		const bool BitSet{ static_cast<bool>(Code & (0b00000001 << CodeLength)) };
+
+		auto& NextNode{ BitSet ? m_Nodes[Node].One : m_Nodes[Node].Zero };
+
+		if (NextNode == 0)
+		{
+			m_Nodes[m_NodeCount] = {};
+			NextNode = static_cast<unsigned short>(m_NodeCount++);
+		}
+
+		Node = NextNode;
+	}
+
+	m_Nodes[Node].Value = static_cast<short>(Value);
+}
+
+int HUFFMAN_TREE::Resolve(BIT_STREAM& BitStream) const
+{
+	size_t Node{ 0 };
+	while (m_Nodes[Node].Value == -1)
+	{
+		const auto NextNode{ (BitStream.FetchBit() == 1) ? m_Nodes[Node].One : m_Nodes[Node].Zero };
+
+		if (NextNode == 0)
+			return -1;
+
+		Node = NextNode;
+	}
+
+	return m_Nodes[Node].Value;
+}
\ No newline at end of file
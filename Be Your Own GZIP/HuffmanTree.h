@@ -0,0 +1,31 @@
+#pragma once
+
+#include "BitStream.h"
+
+#include <array>
+
+// A Huffman tree kept in a flat array of nodes, so that it can be rebuilt for every block without allocating memory.
+class HUFFMAN_TREE
+{
+	struct NODE
+	{
+		short Value{ -1 };
+		// Indexes of the child nodes, or 0 for none; the root is never a child.
+		unsigned short Zero{ 0 };
+		unsigned short One{ 0 };
+	};
+
+	// Placing a code adds at most one node per bit of it: at most 15 bits, for each of at most 288 values.
+	static constexpr size_t m_MaximumNodes{ 1 + (15 * 288) };
+
+	std::array<NODE, m_MaximumNodes> m_Nodes;
+	size_t m_NodeCount;
+
+public:
+	HUFFMAN_TREE();
+
+	void Clear();
+	void Place(int Value, int Code, int CodeLength);
+	// Returns -1 for a code that is not in the tree.
+	int Resolve(BIT_STREAM& BitStream) const;
+};
\ No newline at end of file
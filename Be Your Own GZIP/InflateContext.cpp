@@ -0,0 +1,92 @@
+#include "InflateContext.h"
+
+#include "WorkerThreads.h"
+
+// The longest a stored block can be.
+constexpr size_t StoredBlockMaximumLength{ 0xFFFF };
+// The most decoded bytes a chunk decoded for the parallel validator keeps track of before its window is free of references to the data before it; beyond that, the chunk is validated serially.
+constexpr size_t SpeculativeSymbolsLimit{ 1 << 24 };
+
+HUFFMAN_TABLES::HUFFMAN_TABLES()
+{
+	// The fixed Huffman tree for the literal and length values.
+	{
+		int Code{ 0 };
+
+		for (int Value{ 256 }; Value < 280; ++Code, ++Value)
+			Fixed_Literal_Length.Place(Value, Code, 7);
+		Code <<= 1;
+
+		for (int Value{ 0 }; Value < 144; ++Code, ++Value)
+			Fixed_Literal_Length.Place(Value, Code, 8);
+		for (int Value{ 280 }; Value < 288; ++Code, ++Value)
+			if ((Value != 286) && (Value != 287))
+				Fixed_Literal_Length.Place(Value, Code, 8);
+		Code <<= 1;
+
+		for (int Value{ 144 }; Value < 256; ++Code, ++Value)
+			Fixed_Literal_Length.Place(Value, Code, 9);
+	}
+
+	// The fixed Huffman tree for the distance values.
+	{
+		int Code{ 0 };
+
+		for (int Value{ 0 }; Value < 30; ++Code, ++Value)
+			Fixed_Distance.Place(Value, Code, 5);
+	}
+}
+
+INFLATE_CONTEXT::INFLATE_CONTEXT() : StoredBlockData(StoredBlockMaximumLength), SpeculativeData{ 32768, SpeculativeSymbolsLimit }
+{
+}
+
+INFLATE_CONTEXT::~INFLATE_CONTEXT() = default;
+
+INFLATE_CONTEXT_POOL::LEASE::LEASE(INFLATE_CONTEXT_POOL& Pool, std::unique_ptr<INFLATE_CONTEXT> Context) : m_ptr_Pool{ &Pool }, m_Context{ std::move(Context) }
+{
+}
+
+INFLATE_CONTEXT_POOL::LEASE::LEASE(LEASE&& Other) noexcept : m_ptr_Pool{ Other.m_ptr_Pool }, m_Context{ std::move(Other.m_Context) }
+{
+}
+
+INFLATE_CONTEXT_POOL::LEASE::~LEASE()
+{
+	if (m_Context != nullptr)
+		m_ptr_Pool->Release(std::move(m_Context));
+}
+
+INFLATE_CONTEXT& INFLATE_CONTEXT_POOL::LEASE::operator*() const
+{
+	return *m_Context;
+}
+
+INFLATE_CONTEXT* INFLATE_CONTEXT_POOL::LEASE::operator->() const
+{
+	return m_Context.get();
+}
+
+INFLATE_CONTEXT_POOL::LEASE INFLATE_CONTEXT_POOL::Acquire()
+{
+	{
+		std::lock_guard Lock{ m_Mutex };
+
+		if (m_FreeContexts.empty() == false)
+		{
+			auto Context{ std::move(m_FreeContexts.back()) };
+			m_FreeContexts.pop_back();
+
+			return { *this, std::move(Context) };
+		}
+	}
+
+	return { *this, std::make_unique<INFLATE_CONTEXT>() };
+}
+
+void INFLATE_CONTEXT_POOL::Release(std::unique_ptr<INFLATE_CONTEXT> Context)
+{
+	std::lock_guard Lock{ m_Mutex };
+
+	m_FreeContexts.push_back(std::move(Context));
+}
\ No newline at end of file
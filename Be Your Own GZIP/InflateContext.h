@@ -0,0 +1,79 @@
+#pragma once
+
+#include "HuffmanTree.h"
+#include "OutputData.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// The Huffman trees used by the decoder: the fixed ones, built once, and the ones described by the header of each dynamic block, rebuilt in place for every block.
+struct HUFFMAN_TABLES
+{
+	HUFFMAN_TREE Fixed_Literal_Length;
+	HUFFMAN_TREE Fixed_Distance;
+
+	HUFFMAN_TREE Literal_Length;
+	HUFFMAN_TREE Distance;
+	HUFFMAN_TREE CodeLengthsCodes;
+
+	HUFFMAN_TABLES();
+};
+
+class INFLATE_CONTEXT_POOL;
+class WORKER_THREADS;
+
+// Everything the decoder works with: the Huffman trees, and the window and checksum of the decompressed data, for each validation level and checksum.
+// A context is allocated once, and then reused for stream after stream without allocating memory again. It must only be used by one thread at a time.
+struct INFLATE_CONTEXT
+{
+	HUFFMAN_TABLES Tables;
+
+	OUTPUT_DATA_COUNTER DataCounter{ 32768 };
+	OUTPUT_DATA_INFO<CRC32> CRC32Data{ 32768 };
+	OUTPUT_DATA_INFO<ADLER32> Adler32Data{ 32768 };
+	// The data of a stored block, which is read and added in one go.
+	std::vector<unsigned char> StoredBlockData;
+
+	// Used when the context decodes a chunk for the parallel validator.
+	OUTPUT_DATA_SPECULATIVE SpeculativeData;
+	// The compressed data read for the parallel validator, its worker threads, and their contexts; all are kept from one stream to the next.
+	std::vector<unsigned char> ReadAheadBuffer;
+	std::unique_ptr<WORKER_THREADS> WorkerThreads;
+	std::unique_ptr<INFLATE_CONTEXT_POOL> WorkerContexts;
+
+	INFLATE_CONTEXT();
+	~INFLATE_CONTEXT();
+
+	INFLATE_CONTEXT(const INFLATE_CONTEXT&) = delete;
+	INFLATE_CONTEXT& operator=(const INFLATE_CONTEXT&) = delete;
+};
+
+// Hands out contexts to threads, creating a new one only when all the existing ones are in use. A context goes back to the pool when its lease ends.
+class INFLATE_CONTEXT_POOL
+{
+	std::mutex m_Mutex;
+	std::vector<std::unique_ptr<INFLATE_CONTEXT>> m_FreeContexts;
+
+	void Release(std::unique_ptr<INFLATE_CONTEXT> Context);
+
+public:
+	class LEASE
+	{
+		INFLATE_CONTEXT_POOL* m_ptr_Pool;
+		std::unique_ptr<INFLATE_CONTEXT> m_Context;
+
+	public:
+		LEASE() = delete;
+		LEASE(INFLATE_CONTEXT_POOL& Pool, std::unique_ptr<INFLATE_CONTEXT> Context);
+		LEASE(LEASE&& Other) noexcept;
+		LEASE& operator=(LEASE&&) = delete;
+
+		~LEASE();
+
+		INFLATE_CONTEXT& operator*() const;
+		INFLATE_CONTEXT* operator->() const;
+	};
+
+	LEASE Acquire();
+};
\ No newline at end of file
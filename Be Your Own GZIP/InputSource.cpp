@@ -0,0 +1,226 @@
+#include "InputSource.h"
+
+#include "Carving.h"
+
+#include <algorithm>
+
+#define NOMINMAX
+#include <Windows.h>
+#include <winioctl.h>
+
+bool IsDevicePath(const std::filesystem::path& Path)
+{
+	return Path.wstring().starts_with(L"\\\\.\\");
+}
+
+std::wstring GetDeviceName(const std::filesystem::path& DevicePath)
+{
+	auto Name{ DevicePath.wstring().substr(4) };
+	std::erase_if(Name, [](const wchar_t Character) { return (Character == L':') || (Character == L'\\') || (Character == L'/'); });
+
+	return Name;
+}
+
+// The sector size used when the device does not report one; a multiple of every sector size in use.
+constexpr unsigned long long DefaultSectorSize{ 1 << 12 };
+
+DEVICE_STREAM_BUFFER::DEVICE_STREAM_BUFFER(void* const Handle, const unsigned long long Size, const unsigned long long SectorSize) :
+	m_Handle{ Handle },
+	m_Size{ Size },
+	m_SectorSize{ std::clamp<unsigned long long>(SectorSize, 1, m_MaximumBufferSize) },
+	m_BufferSize{ static_cast<size_t>((m_MaximumBufferSize / m_SectorSize) * m_SectorSize) },
+	m_Buffer(m_BufferSize),
+	m_BufferPosition{ 0 }
+{
+	setg(m_Buffer.data(), m_Buffer.data(), m_Buffer.data());
+}
+
+// Reads the aligned block that holds the first byte past the data in the buffer.
+DEVICE_STREAM_BUFFER::int_type DEVICE_STREAM_BUFFER::underflow()
+{
+	if (gptr() < egptr())
+		return traits_type::to_int_type(*gptr());
+
+	const unsigned long long Position{ m_BufferPosition + static_cast<unsigned long long>(gptr() - eback()) };
+	if (Position >= m_Size)
+		return traits_type::eof();
+
+	const unsigned long long BlockPosition{ Position - (Position % m_SectorSize) };
+	// The last block of the device is as long as the device goes, rounded up to a whole sector; a device is made of whole sectors, so this never reads past its end.
+	const auto BlockSize{ static_cast<DWORD>(std::min<unsigned long long>(m_BufferSize, ((m_Size - BlockPosition + m_SectorSize - 1) / m_SectorSize) * m_SectorSize)) };
+
+	LARGE_INTEGER Distance;
+	Distance.QuadPart = static_cast<LONGLONG>(BlockPosition);
+	DWORD BytesRead{ 0 };
+	if ((SetFilePointerEx(m_Handle, Distance, nullptr, FILE_BEGIN) == FALSE) || (ReadFile(m_Handle, m_Buffer.data(), BlockSize, &BytesRead, nullptr) == FALSE))
+		return traits_type::eof();
+
+	BytesRead = static_cast<DWORD>(std::min<unsigned long long>(BytesRead, m_Size - BlockPosition));
+	if (Position - BlockPosition >= BytesRead)
+		return traits_type::eof();
+
+	m_BufferPosition = BlockPosition;
+	setg(m_Buffer.data(), m_Buffer.data() + (Position - BlockPosition), m_Buffer.data() + BytesRead);
+
+	return traits_type::to_int_type(*gptr());
+}
+
+// A position within the buffer is served from it; any other is only read once the data is asked for.
+DEVICE_STREAM_BUFFER::pos_type DEVICE_STREAM_BUFFER::seekoff(const off_type Offset, const std::ios_base::seekdir Direction, const std::ios_base::openmode Which)
+{
+	if ((Which & std::ios_base::in) == 0)
+		return pos_type(off_type(-1));
+
+	off_type Base;
+	switch (Direction)
+	{
+		case std::ios_base::beg:
+		{
+			Base = 0;
+
+			break;
+		}
+		case std::ios_base::cur:
+		{
+			Base = static_cast<off_type>(m_BufferPosition) + (gptr() - eback());
+
+			break;
+		}
+		case std::ios_base::end:
+		default:
+		{
+			Base = static_cast<off_type>(m_Size);
+		}
+	}
+
+	const off_type Position{ Base + Offset };
+	if ((Position < 0) || (static_cast<unsigned long long>(Position) > m_Size))
+		return pos_type(off_type(-1));
+
+	const auto BufferedLength{ static_cast<unsigned long long>(egptr() - eback()) };
+	if ((static_cast<unsigned long long>(Position) >= m_BufferPosition) && (static_cast<unsigned long long>(Position) < m_BufferPosition + BufferedLength))
+		setg(eback(), eback() + (static_cast<unsigned long long>(Position) - m_BufferPosition), egptr());
+	else
+	{
+		m_BufferPosition = static_cast<unsigned long long>(Position);
+		setg(m_Buffer.data(), m_Buffer.data(), m_Buffer.data());
+	}
+
+	return pos_type(Position);
+}
+
+DEVICE_STREAM_BUFFER::pos_type DEVICE_STREAM_BUFFER::seekpos(const pos_type Position, const std::ios_base::openmode Which)
+{
+	return seekoff(off_type(Position), std::ios_base::beg, Which);
+}
+
+INPUT_SOURCE::INPUT_SOURCE(const std::filesystem::path& Path) : m_Path{ Path }, m_Handle{ INVALID_HANDLE_VALUE }, m_Size{ 0 }
+{
+	// Other programs may go on writing to what is being scanned.
+	m_Handle = CreateFileW(Path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (m_Handle == INVALID_HANDLE_VALUE)
+		throw PrepareException(L"Could not read the file:\n   " + Path.wstring());
+
+	if (IsDevicePath(Path))
+	{
+		GET_LENGTH_INFORMATION LengthInformation;
+		DWORD BytesReturned;
+		if (DeviceIoControl(m_Handle, IOCTL_DISK_GET_LENGTH_INFO, nullptr, 0, &LengthInformation, sizeof(LengthInformation), &BytesReturned, nullptr) == FALSE)
+		{
+			CloseHandle(m_Handle);
+			throw PrepareException(L"Could not get the size of the device:\n   " + Path.wstring());
+		}
+
+		m_Size = static_cast<unsigned long long>(LengthInformation.Length.QuadPart);
+
+		// Reads have to be of whole sectors; a device that does not report its geometry gets the largest sector size in use.
+		unsigned long long SectorSize{ DefaultSectorSize };
+		DISK_GEOMETRY_EX Geometry;
+		if ((DeviceIoControl(m_Handle, IOCTL_DISK_GET_DRIVE_GEOMETRY_EX, nullptr, 0, &Geometry, sizeof(Geometry), &BytesReturned, nullptr) != FALSE) && (Geometry.Geometry.BytesPerSector > 0))
+			SectorSize = Geometry.Geometry.BytesPerSector;
+
+		m_DeviceBuffer = std::make_unique<DEVICE_STREAM_BUFFER>(m_Handle, m_Size, SectorSize);
+		m_DeviceStream = std::make_unique<std::istream>(m_DeviceBuffer.get());
+
+		return;
+	}
+
+	LARGE_INTEGER FileSize;
+	if (GetFileSizeEx(m_Handle, &FileSize))
+		m_Size = static_cast<unsigned long long>(FileSize.QuadPart);
+
+	m_File.open(Path, std::fstream::binary);
+	if (m_File.good() == false)
+	{
+		CloseHandle(m_Handle);
+		throw PrepareException(L"Could not read the file:\n   " + Path.wstring());
+	}
+}
+
+INPUT_SOURCE::~INPUT_SOURCE()
+{
+	m_DeviceStream.reset();
+	m_DeviceBuffer.reset();
+	m_File.close();
+
+	CloseHandle(m_Handle);
+}
+
+std::istream& INPUT_SOURCE::GetStream()
+{
+	if (m_DeviceStream != nullptr)
+		return *m_DeviceStream;
+
+	return m_File;
+}
+
+unsigned long long INPUT_SOURCE::GetSize() const
+{
+	return m_Size;
+}
+
+std::vector<DATA_RANGE> INPUT_SOURCE::GetDataRanges(const unsigned long long Start, unsigned long long End) const
+{
+	End = std::min(End, m_Size);
+	if (Start >= End)
+		return {};
+
+	// Only a file can be sparse; and if the file system cannot tell where the data is, it is all taken to be data.
+	if (m_DeviceStream != nullptr)
+		return { { Start, End } };
+
+	std::vector<DATA_RANGE> Ranges;
+	FILE_ALLOCATED_RANGE_BUFFER Query;
+	Query.FileOffset.QuadPart = static_cast<LONGLONG>(Start);
+	Query.Length.QuadPart = static_cast<LONGLONG>(End - Start);
+
+	FILE_ALLOCATED_RANGE_BUFFER Allocated[64];
+	for (;;)
+	{
+		DWORD BytesReturned{ 0 };
+		const bool Complete{ DeviceIoControl(m_Handle, FSCTL_QUERY_ALLOCATED_RANGES, &Query, sizeof(Query), Allocated, sizeof(Allocated), &BytesReturned, nullptr) != FALSE };
+		if ((Complete == false) && (GetLastError() != ERROR_MORE_DATA))
+			return { { Start, End } };
+
+		const auto Count{ BytesReturned / sizeof(FILE_ALLOCATED_RANGE_BUFFER) };
+		for (size_t i{ 0 }; i < Count; ++i)
+		{
+			const auto RangeStart{ std::max(static_cast<unsigned long long>(Allocated[i].FileOffset.QuadPart), Start) };
+			const auto RangeEnd{ std::min(static_cast<unsigned long long>(Allocated[i].FileOffset.QuadPart + Allocated[i].Length.QuadPart), End) };
+			if (RangeStart < RangeEnd)
+				Ranges.push_back({ RangeStart, RangeEnd });
+		}
+
+		if (Complete || (Count == 0))
+			break;
+
+		// Carry on from the end of the last range returned.
+		const auto NextStart{ static_cast<unsigned long long>(Allocated[Count - 1].FileOffset.QuadPart + Allocated[Count - 1].Length.QuadPart) };
+		if (NextStart >= End)
+			break;
+		Query.FileOffset.QuadPart = static_cast<LONGLONG>(NextStart);
+		Query.Length.QuadPart = static_cast<LONGLONG>(End - NextStart);
+	}
+
+	return Ranges;
+}
\ No newline at end of file
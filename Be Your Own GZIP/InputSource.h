@@ -0,0 +1,72 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+// A stretch of the input, from Start up to, but not including, End.
+struct DATA_RANGE
+{
+	unsigned long long Start;
+	unsigned long long End;
+};
+
+// Whether the path names a block device, such as \\.\PhysicalDrive0 or \\.\C:, rather than a file.
+bool IsDevicePath(const std::filesystem::path& Path);
+// A name for a block device that can be part of a file name, such as PhysicalDrive0 or C.
+std::wstring GetDeviceName(const std::filesystem::path& DevicePath);
+
+// A read-only stream buffer over a block device, which can only be read in whole sectors: every read is of a block aligned to the sector size, and the bytes asked for are served from it.
+class DEVICE_STREAM_BUFFER : public std::streambuf
+{
+	static constexpr size_t m_MaximumBufferSize{ 1 << 20 };
+
+	void* const m_Handle;
+	const unsigned long long m_Size;
+	const unsigned long long m_SectorSize;
+	// As many whole sectors as fit in m_MaximumBufferSize.
+	const size_t m_BufferSize;
+	std::vector<char> m_Buffer;
+	// Where the data in the buffer starts on the device.
+	unsigned long long m_BufferPosition;
+
+public:
+	DEVICE_STREAM_BUFFER() = delete;
+	DEVICE_STREAM_BUFFER(void* Handle, unsigned long long Size, unsigned long long SectorSize);
+
+protected:
+	int_type underflow() override;
+	pos_type seekoff(off_type Offset, std::ios_base::seekdir Direction, std::ios_base::openmode Which = std::ios_base::in) override;
+	pos_type seekpos(pos_type Position, std::ios_base::openmode Which = std::ios_base::in) override;
+};
+
+// The file or block device a scan reads from. A file is read through a std::ifstream, as ever; a block device through a DEVICE_STREAM_BUFFER.
+class INPUT_SOURCE
+{
+	const std::filesystem::path m_Path;
+	void* m_Handle;
+	unsigned long long m_Size;
+
+	std::ifstream m_File;
+	std::unique_ptr<DEVICE_STREAM_BUFFER> m_DeviceBuffer;
+	std::unique_ptr<std::istream> m_DeviceStream;
+
+public:
+	INPUT_SOURCE() = delete;
+	explicit INPUT_SOURCE(const std::filesystem::path& Path);
+
+	~INPUT_SOURCE();
+
+	INPUT_SOURCE(const INPUT_SOURCE&) = delete;
+	INPUT_SOURCE& operator=(const INPUT_SOURCE&) = delete;
+
+	std::istream& GetStream();
+	unsigned long long GetSize() const;
+
+	// The parts of the range from Start to End that hold data, in order: the whole range, but for the holes of a sparse file, which read as zeros and so cannot hold anything.
+	std::vector<DATA_RANGE> GetDataRanges(unsigned long long Start, unsigned long long End) const;
+};
\ No newline at end of file
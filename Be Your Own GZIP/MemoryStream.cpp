@@ -0,0 +1,49 @@
+#include "MemoryStream.h"
+
+MEMORY_STREAM_BUFFER::MEMORY_STREAM_BUFFER(const unsigned char* const Data, const size_t Length)
+{
+	// The buffer is only ever read from, the const is cast away only to satisfy the std::streambuf interface.
+	auto* const Begin{ reinterpret_cast<char*>(const_cast<unsigned char*>(Data)) };
+	setg(Begin, Begin, Begin + Length);
+}
+
+MEMORY_STREAM_BUFFER::pos_type MEMORY_STREAM_BUFFER::seekoff(const off_type Offset, const std::ios_base::seekdir Direction, const std::ios_base::openmode Which)
+{
+	if ((Which & std::ios_base::in) == 0)
+		return pos_type(off_type(-1));
+
+	off_type Base;
+	switch (Direction)
+	{
+		case std::ios_base::beg:
+		{
+			Base = 0;
+
+			break;
+		}
+		case std::ios_base::cur:
+		{
+			Base = gptr() - eback();
+
+			break;
+		}
+		case std::ios_base::end:
+		default:
+		{
+			Base = egptr() - eback();
+		}
+	}
+
+	const off_type Position{ Base + Offset };
+	if ((Position < 0) || (Position > egptr() - eback()))
+		return pos_type(off_type(-1));
+
+	setg(eback(), eback() + Position, egptr());
+
+	return pos_type(Position);
+}
+
+MEMORY_STREAM_BUFFER::pos_type MEMORY_STREAM_BUFFER::seekpos(const pos_type Position, const std::ios_base::openmode Which)
+{
+	return seekoff(off_type(Position), std::ios_base::beg, Which);
+}
\ No newline at end of file
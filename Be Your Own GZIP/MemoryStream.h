@@ -0,0 +1,15 @@
+#pragma once
+
+#include <streambuf>
+
+// A read-only stream buffer over a block of memory, so that data already in memory can be read through the same std::istream interface as a file.
+class MEMORY_STREAM_BUFFER : public std::streambuf
+{
+public:
+	MEMORY_STREAM_BUFFER() = delete;
+	MEMORY_STREAM_BUFFER(const unsigned char* Data, size_t Length);
+
+protected:
+	pos_type seekoff(off_type Offset, std::ios_base::seekdir Direction, std::ios_base::openmode Which = std::ios_base::in) override;
+	pos_type seekpos(pos_type Position, std::ios_base::openmode Which = std::ios_base::in) override;
+};
\ No newline at end of file
@@ -1,15 +1,22 @@
 #include "OutputData.h"
 
+#include <algorithm>
+#include <cstring>
+
+#ifdef CPU_DISPATCH_X86
+#include <immintrin.h>
+#endif
+
 OUTPUT_DATA_INFO_EXCEPTION::OUTPUT_DATA_INFO_EXCEPTION(const char* message) : std::runtime_error(message) {}
 
-OUTPUT_DATA_INFO::CIRCULAR_BUFFER::CIRCULAR_BUFFER(size_t BufferSize) : m_Array{ new unsigned char[BufferSize] }, m_ArraySize{ BufferSize }, m_DataStart{ 0 }, m_DataLength{ 0 } {}
+CIRCULAR_BUFFER::CIRCULAR_BUFFER(size_t BufferSize) : m_Array{ new unsigned char[BufferSize] }, m_ArraySize{ BufferSize }, m_DataStart{ 0 }, m_DataLength{ 0 } {}
 
-OUTPUT_DATA_INFO::CIRCULAR_BUFFER::~CIRCULAR_BUFFER()
+CIRCULAR_BUFFER::~CIRCULAR_BUFFER()
 {
 	delete[] m_Array;
 }
 
-unsigned char& OUTPUT_DATA_INFO::CIRCULAR_BUFFER::operator[](size_t Index)
+unsigned char& CIRCULAR_BUFFER::operator[](size_t Index)
 {
 	if (Index >= m_DataLength)
 		throw OUTPUT_DATA_INFO_EXCEPTION("OutpuData: Out of bounds buffer access.");
@@ -21,12 +28,24 @@ unsigned char& OUTPUT_DATA_INFO::CIRCULAR_BUFFER::operator[](size_t Index)
 	return m_Array[Index];
 }
 
-void OUTPUT_DATA_INFO::CIRCULAR_BUFFER::Empty()
+unsigned char CIRCULAR_BUFFER::operator[](size_t Index) const
+{
+	if (Index >= m_DataLength)
+		throw OUTPUT_DATA_INFO_EXCEPTION("OutpuData: Out of bounds buffer access.");
+
+	Index += m_DataStart;
+	if (Index >= m_ArraySize)
+		Index -= m_ArraySize;
+
+	return m_Array[Index];
+}
+
+void CIRCULAR_BUFFER::Empty()
 {
 	m_DataStart = m_DataLength = 0;
 }
 
-unsigned char OUTPUT_DATA_INFO::CIRCULAR_BUFFER::Front() const
+unsigned char CIRCULAR_BUFFER::Front() const
 {
 	if (m_DataLength == 0)
 		throw OUTPUT_DATA_INFO_EXCEPTION("OutpuData: Accessing an empty buffer.");
@@ -34,7 +53,7 @@ unsigned char OUTPUT_DATA_INFO::CIRCULAR_BUFFER::Front() const
 	return m_Array[m_DataStart];
 }
 
-unsigned char OUTPUT_DATA_INFO::CIRCULAR_BUFFER::PopFront()
+unsigned char CIRCULAR_BUFFER::PopFront()
 {
 	const unsigned char ret{ Front() };
 
@@ -45,17 +64,17 @@ unsigned char OUTPUT_DATA_INFO::CIRCULAR_BUFFER::PopFront()
 	return ret;
 }
 
-size_t OUTPUT_DATA_INFO::CIRCULAR_BUFFER::Length() const
+size_t CIRCULAR_BUFFER::Length() const
 {
 	return m_DataLength;
 }
 
-bool OUTPUT_DATA_INFO::CIRCULAR_BUFFER::IsFull() const
+bool CIRCULAR_BUFFER::IsFull() const
 {
 	return m_DataLength == m_ArraySize;
 }
 
-void OUTPUT_DATA_INFO::CIRCULAR_BUFFER::Add(unsigned char Element)
+void CIRCULAR_BUFFER::Add(unsigned char Element)
 {
 	size_t InsertPosition{ m_DataStart + m_DataLength };
 	if (InsertPosition >= m_ArraySize)
@@ -72,13 +91,50 @@ void OUTPUT_DATA_INFO::CIRCULAR_BUFFER::Add(unsigned char Element)
 		++m_DataLength;
 }
 
-void OUTPUT_DATA_INFO::CIRCULAR_BUFFER::Add(const unsigned char* Elements, size_t ElementCount)
+// Only the last elements that fit are kept, so only those are copied, in at most two pieces.
+void CIRCULAR_BUFFER::Add(const unsigned char* Elements, size_t ElementCount)
+{
+	if (ElementCount >= m_ArraySize)
+	{
+		std::memcpy(m_Array, Elements + (ElementCount - m_ArraySize), m_ArraySize);
+		m_DataStart = 0;
+		m_DataLength = m_ArraySize;
+
+		return;
+	}
+
+	size_t InsertPosition{ m_DataStart + m_DataLength };
+	if (InsertPosition >= m_ArraySize)
+		InsertPosition -= m_ArraySize;
+
+	const size_t FirstPart{ std::min(ElementCount, m_ArraySize - InsertPosition) };
+	std::memcpy(m_Array + InsertPosition, Elements, FirstPart);
+	std::memcpy(m_Array, Elements + FirstPart, ElementCount - FirstPart);
+
+	// Elements past the capacity took the place of the oldest ones.
+	const size_t Overwritten{ (m_DataLength + ElementCount > m_ArraySize) ? (m_DataLength + ElementCount - m_ArraySize) : 0 };
+	m_DataLength += ElementCount - Overwritten;
+	m_DataStart += Overwritten;
+	if (m_DataStart >= m_ArraySize)
+		m_DataStart -= m_ArraySize;
+}
+
+// In at most two pieces, as the elements may wrap around the end of the array.
+void CIRCULAR_BUFFER::CopyOut(size_t Index, const size_t Count, unsigned char* const Destination) const
 {
-	while (ElementCount-- > 0)
-		Add(*Elements);
+	if ((Index > m_DataLength) || (Count > m_DataLength - Index))
+		throw OUTPUT_DATA_INFO_EXCEPTION("OutpuData: Out of bounds buffer access.");
+
+	Index += m_DataStart;
+	if (Index >= m_ArraySize)
+		Index -= m_ArraySize;
+
+	const size_t FirstPart{ std::min(Count, m_ArraySize - Index) };
+	std::memcpy(Destination, m_Array + Index, FirstPart);
+	std::memcpy(Destination + FirstPart, m_Array, Count - FirstPart);
 }
 
-bool OUTPUT_DATA_INFO::CIRCULAR_BUFFER::CheckIfBufferContains(const std::vector<unsigned char>& Data) const
+bool CIRCULAR_BUFFER::CheckIfBufferContains(const std::vector<unsigned char>& Data) const
 {
 	const size_t l_Data_size{ Data.size() };
 	if (l_Data_size > 0 && m_DataLength >= l_Data_size)
@@ -101,7 +157,7 @@ bool OUTPUT_DATA_INFO::CIRCULAR_BUFFER::CheckIfBufferContains(const std::vector<
 	return false;
 }
 
-bool OUTPUT_DATA_INFO::CIRCULAR_BUFFER::CheckIfBufferStarts(const std::vector<unsigned char>& Data) const
+bool CIRCULAR_BUFFER::CheckIfBufferStarts(const std::vector<unsigned char>& Data) const
 {
 	const size_t l_Data_size{ Data.size() };
 	if (l_Data_size > 0 && m_DataLength >= l_Data_size)
@@ -122,48 +178,525 @@ bool OUTPUT_DATA_INFO::CIRCULAR_BUFFER::CheckIfBufferStarts(const std::vector<un
 	return false;
 }
 
-OUTPUT_DATA_INFO::OUTPUT_DATA_INFO(const size_t BufferSize) : m_CRC32{}, m_TotalAddedBytes{}, m_LimitedSizeBuffer{ BufferSize }
+template <typename CHECKSUM>
+OUTPUT_DATA_INFO<CHECKSUM>::OUTPUT_DATA_INFO(const size_t BufferSize) : m_Checksum{}, m_TotalAddedBytes{}, m_LimitedSizeBuffer{ BufferSize }
 {
 	Reset();
 }
 
-void OUTPUT_DATA_INFO::Reset()
+template <typename CHECKSUM>
+void OUTPUT_DATA_INFO<CHECKSUM>::Reset()
 {
 	m_TotalAddedBytes = 0;
-	m_CRC32.Reset();
+	m_Checksum.Reset();
 	NewDataSegment();
 }
 
-void OUTPUT_DATA_INFO::NewDataSegment()
+template <typename CHECKSUM>
+void OUTPUT_DATA_INFO<CHECKSUM>::Reset(const std::vector<unsigned char>& PrecedingData)
+{
+	Reset();
+
+	for (const auto Byte : PrecedingData)
+		m_LimitedSizeBuffer.Add(Byte);
+}
+
+template <typename CHECKSUM>
+void OUTPUT_DATA_INFO<CHECKSUM>::NewDataSegment()
 {
 	m_LimitedSizeBuffer.Empty();
 }
 
-void OUTPUT_DATA_INFO::AddByte(const unsigned char Byte)
+template <typename CHECKSUM>
+void OUTPUT_DATA_INFO<CHECKSUM>::AddByte(const unsigned char Byte)
 {
 	m_LimitedSizeBuffer.Add(Byte);
-	m_CRC32.AddByte(Byte);
+	m_Checksum.AddByte(Byte);
 
 	++m_TotalAddedBytes;
 }
 
-void OUTPUT_DATA_INFO::RepeatFragment(const int Fragment_Backposition, int Fragment_Length)
+template <typename CHECKSUM>
+void OUTPUT_DATA_INFO<CHECKSUM>::AddBytes(const unsigned char* const Data, const size_t Length)
 {
-	for(; Fragment_Length > 0; --Fragment_Length)
-		AddByte(m_LimitedSizeBuffer[m_LimitedSizeBuffer.Length() - 1 - Fragment_Backposition]);
+	m_LimitedSizeBuffer.Add(Data, Length);
+	m_Checksum.AddBytes(Data, Length);
+
+	m_TotalAddedBytes += Length;
 }
 
-unsigned long long OUTPUT_DATA_INFO::GetSegmentLength() const
+static void CopyMatch_Generic(unsigned char* const Destination, const unsigned char* const Source, const size_t Length)
+{
+	for (size_t i{ 0 }; i < Length; ++i)
+		Destination[i] = Source[i];
+}
+
+#ifdef CPU_DISPATCH_X86
+// Matches are short, mostly shorter than 64 bytes, so wider chunks only add to the bytes copied past the end; there is no variant for AVX2.
+// Until Destination is at least 16 bytes past Source, the bytes between them are doubled, each copy landing right after the last one; a pattern repeated a whole number of times is still the same pattern. The rest is then copied 16 bytes at a time, each chunk read only once it has been written.
+static void CopyMatch_SSE2(unsigned char* Destination, const unsigned char* Source, size_t Length)
+{
+	for (size_t Distance{ static_cast<size_t>(Destination - Source) }; (Distance < 16) && (Length > 0); Distance <<= 1)
+	{
+		const size_t Count{ std::min(Distance, Length) };
+		std::memcpy(Destination, Source, Count);
+
+		Destination += Count;
+		Length -= Count;
+	}
+
+	for (size_t Copied{ 0 }; Copied < Length; Copied += 16)
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(Destination + Copied), _mm_loadu_si128(reinterpret_cast<const __m128i*>(Source + Copied)));
+}
+#endif
+
+static constexpr KERNEL_VARIANT<MATCH_COPY_KERNEL> CopyMatchVariants[]
+{
+	{ INSTRUCTION_SET::GENERIC, &CopyMatch_Generic, L"generic" },
+#ifdef CPU_DISPATCH_X86
+	{ INSTRUCTION_SET::SSE2, &CopyMatch_SSE2, L"sse2" }
+#endif
+};
+
+std::span<const KERNEL_VARIANT<MATCH_COPY_KERNEL>> GetMatchCopyVariants()
+{
+	return CopyMatchVariants;
+}
+
+// The fragment is put together in a buffer on the stack, and added to the window and the checksum in one go, rather than a byte at a time: as much of it as the window holds is copied out of the window, and the rest repeats it.
+// DEFLATE copies at most 258 bytes at once; longer fragments are copied in pieces of that length, each one repeating the window as left by the last.
+template <typename CHECKSUM>
+void OUTPUT_DATA_INFO<CHECKSUM>::RepeatFragment(const int Fragment_Backposition, const int Fragment_Length)
+{
+	static const auto CopyMatch{ PickKernelVariant(CopyMatchVariants, GetInstructionSet()).Function };
+
+	constexpr size_t MaximumPiece{ 258 };
+	unsigned char Fragment[MaximumPiece + MatchCopyOverrun];
+
+	const size_t Distance{ static_cast<size_t>(Fragment_Backposition) + 1 };
+	if (Distance > m_LimitedSizeBuffer.Length())
+		throw OUTPUT_DATA_INFO_EXCEPTION("OutpuData: Out of bounds buffer access.");
+
+	for (size_t Length{ static_cast<size_t>(std::max(Fragment_Length, 0)) }; Length > 0;)
+	{
+		const size_t Piece{ std::min(Length, MaximumPiece) };
+		const size_t FromWindow{ std::min(Distance, Piece) };
+
+		m_LimitedSizeBuffer.CopyOut(m_LimitedSizeBuffer.Length() - Distance, FromWindow, Fragment);
+		if (Piece > FromWindow)
+			CopyMatch(Fragment + Distance, Fragment, Piece - Distance);
+
+		AddBytes(Fragment, Piece);
+		Length -= Piece;
+	}
+}
+
+template <typename CHECKSUM>
+unsigned long long OUTPUT_DATA_INFO<CHECKSUM>::GetSegmentLength() const
 {
 	return m_LimitedSizeBuffer.Length();
 }
 
-unsigned long long OUTPUT_DATA_INFO::GetBytesTotalCount() const
+template <typename CHECKSUM>
+unsigned long long OUTPUT_DATA_INFO<CHECKSUM>::GetBytesTotalCount() const
+{
+	return m_TotalAddedBytes;
+}
+
+template <typename CHECKSUM>
+unsigned long long OUTPUT_DATA_INFO<CHECKSUM>::GetChecksum() const
+{
+	return m_Checksum.GetChecksum();
+}
+
+template <typename CHECKSUM>
+void OUTPUT_DATA_INFO<CHECKSUM>::GetWindow(std::vector<unsigned char>& out_Window) const
+{
+	out_Window.resize(m_LimitedSizeBuffer.Length());
+	for (size_t i{ 0 }; i < out_Window.size(); ++i)
+		out_Window[i] = m_LimitedSizeBuffer[i];
+}
+
+template class OUTPUT_DATA_INFO<CRC32>;
+template class OUTPUT_DATA_INFO<ADLER32>;
+
+OUTPUT_DATA_COUNTER::OUTPUT_DATA_COUNTER(const size_t WindowSize) : m_WindowSize{ WindowSize }, m_TotalAddedBytes{ 0 } {}
+
+void OUTPUT_DATA_COUNTER::Reset()
+{
+	m_TotalAddedBytes = 0;
+}
+
+void OUTPUT_DATA_COUNTER::AddByte(const unsigned char)
+{
+	++m_TotalAddedBytes;
+}
+
+void OUTPUT_DATA_COUNTER::AddBytes(const unsigned char*, const size_t Length)
+{
+	m_TotalAddedBytes += Length;
+}
+
+void OUTPUT_DATA_COUNTER::RepeatFragment(const int, const int Fragment_Length)
+{
+	m_TotalAddedBytes += Fragment_Length;
+}
+
+unsigned long long OUTPUT_DATA_COUNTER::GetSegmentLength() const
+{
+	return (m_TotalAddedBytes < m_WindowSize) ? m_TotalAddedBytes : m_WindowSize;
+}
+
+unsigned long long OUTPUT_DATA_COUNTER::GetBytesTotalCount() const
+{
+	return m_TotalAddedBytes;
+}
+
+OUTPUT_DATA_SPECULATIVE::OUTPUT_DATA_SPECULATIVE(const size_t WindowSize, const size_t MaximumSymbols) : m_WindowSize{ WindowSize }, m_MaximumSymbols{ MaximumSymbols }, m_SymbolsAfterLastMarker{ 0 }, m_Overflowed{ false }, m_WindowResolved{ false }, m_Window{ WindowSize }, m_Checksum{}, m_TotalAddedBytes{ 0 }
+{
+	Reset();
+}
+
+void OUTPUT_DATA_SPECULATIVE::Reset()
+{
+	m_Symbols.clear();
+	m_SymbolsAfterLastMarker = 0;
+	m_Overflowed = false;
+
+	m_WindowResolved = false;
+	m_Window.Empty();
+	m_Checksum.Reset();
+	m_TotalAddedBytes = 0;
+}
+
+void OUTPUT_DATA_SPECULATIVE::AddSymbol(const unsigned short Symbol)
+{
+	if (m_Symbols.size() == m_MaximumSymbols)
+	{
+		m_Overflowed = true;
+
+		return;
+	}
+
+	m_Symbols.push_back(Symbol);
+
+	if (Symbol >= MarkerBase)
+		m_SymbolsAfterLastMarker = 0;
+	else if (++m_SymbolsAfterLastMarker == m_WindowSize)
+	{
+		// The window is free of markers from now on.
+		for (size_t i{ m_Symbols.size() - m_WindowSize }; i < m_Symbols.size(); ++i)
+			m_Window.Add(static_cast<unsigned char>(m_Symbols[i]));
+
+		m_WindowResolved = true;
+	}
+}
+
+void OUTPUT_DATA_SPECULATIVE::AddByte(const unsigned char Byte)
+{
+	++m_TotalAddedBytes;
+
+	if (m_Overflowed)
+		return;
+
+	if (m_WindowResolved)
+	{
+		m_Window.Add(Byte);
+		m_Checksum.AddByte(Byte);
+	}
+	else
+		AddSymbol(Byte);
+}
+
+void OUTPUT_DATA_SPECULATIVE::AddBytes(const unsigned char* const Data, const size_t Length)
+{
+	// Until the window is free of markers, every byte is a symbol of its own.
+	if (m_WindowResolved && (m_Overflowed == false))
+	{
+		m_Window.Add(Data, Length);
+		m_Checksum.AddBytes(Data, Length);
+		m_TotalAddedBytes += Length;
+	}
+	else
+		for (size_t i{ 0 }; i < Length; ++i)
+			AddByte(Data[i]);
+}
+
+void OUTPUT_DATA_SPECULATIVE::RepeatFragment(const int Fragment_Backposition, int Fragment_Length)
+{
+	for (; Fragment_Length > 0; --Fragment_Length)
+	{
+		if (m_Overflowed)
+		{
+			m_TotalAddedBytes += Fragment_Length;
+
+			return;
+		}
+
+		if (m_WindowResolved)
+			AddByte(m_Window[m_Window.Length() - 1 - Fragment_Backposition]);
+		else
+		{
+			++m_TotalAddedBytes;
+
+			// A back-reference reaching past the start of the data refers to the unknown window, and the window ends right before the data.
+			const auto SourcePosition{ static_cast<long long>(m_Symbols.size()) - 1 - Fragment_Backposition };
+			if (SourcePosition >= 0)
+				AddSymbol(m_Symbols[static_cast<size_t>(SourcePosition)]);
+			else
+				AddSymbol(static_cast<unsigned short>(MarkerBase + static_cast<long long>(m_WindowSize) + SourcePosition));
+		}
+	}
+}
+
+unsigned long long OUTPUT_DATA_SPECULATIVE::GetSegmentLength() const
+{
+	return m_WindowSize;
+}
+
+unsigned long long OUTPUT_DATA_SPECULATIVE::GetBytesTotalCount() const
+{
+	return m_TotalAddedBytes;
+}
+
+bool OUTPUT_DATA_SPECULATIVE::Resolve(std::vector<unsigned char>& io_Window, unsigned long long& io_Checksum) const
+{
+	if (m_Overflowed)
+		return false;
+
+	// The window may be shorter than WindowSize only at the start of the stream; the markers pointing before its start are invalid.
+	const size_t MissingWindowBytes{ m_WindowSize - io_Window.size() };
+
+	std::vector<unsigned char> ResolvedData;
+	ResolvedData.reserve(m_Symbols.size());
+
+	CRC32 Checksum;
+	for (const auto Symbol : m_Symbols)
+	{
+		unsigned char Byte;
+		if (Symbol < MarkerBase)
+			Byte = static_cast<unsigned char>(Symbol);
+		else
+		{
+			const size_t WindowPosition{ static_cast<size_t>(Symbol - MarkerBase) };
+			if (WindowPosition < MissingWindowBytes)
+				return false;
+
+			Byte = io_Window[WindowPosition - MissingWindowBytes];
+		}
+
+		ResolvedData.push_back(Byte);
+		Checksum.AddByte(Byte);
+	}
+
+	io_Checksum = CRC32::Combine(io_Checksum, Checksum.GetChecksum(), ResolvedData.size());
+
+	if (m_WindowResolved)
+	{
+		io_Checksum = CRC32::Combine(io_Checksum, m_Checksum.GetChecksum(), m_TotalAddedBytes - m_Symbols.size());
+
+		io_Window.resize(m_Window.Length());
+		for (size_t i{ 0 }; i < io_Window.size(); ++i)
+			io_Window[i] = m_Window[i];
+	}
+	else
+	{
+		io_Window.insert(io_Window.end(), ResolvedData.begin(), ResolvedData.end());
+		if (io_Window.size() > m_WindowSize)
+			io_Window.erase(io_Window.begin(), io_Window.end() - m_WindowSize);
+	}
+
+	return true;
+}
+
+OUTPUT_DATA_RECOVERY::OUTPUT_DATA_RECOVERY(const size_t WindowSize) : m_Window(WindowSize), m_WindowEnd{ 0 }, m_WindowLength{ 0 }, m_PendingUnknownBytes{ 0 }, m_TotalAddedBytes{ 0 }, m_UnknownBytes{ 0 }
+{
+	Reset();
+}
+
+void OUTPUT_DATA_RECOVERY::Reset()
+{
+	ForgetWindow();
+	DiscardBlock();
+
+	m_TotalAddedBytes = 0;
+	m_UnknownBytes = 0;
+}
+
+void OUTPUT_DATA_RECOVERY::ForgetWindow()
+{
+	m_WindowEnd = 0;
+	m_WindowLength = 0;
+}
+
+void OUTPUT_DATA_RECOVERY::AddSymbol(const unsigned short Symbol)
+{
+	m_Window[m_WindowEnd] = Symbol;
+	if (++m_WindowEnd == m_Window.size())
+		m_WindowEnd = 0;
+
+	if (m_WindowLength < m_Window.size())
+		++m_WindowLength;
+
+	if (Symbol == UnknownSymbol)
+	{
+		m_PendingBlock.push_back(UnknownByte);
+		++m_PendingUnknownBytes;
+	}
+	else
+		m_PendingBlock.push_back(static_cast<unsigned char>(Symbol));
+}
+
+void OUTPUT_DATA_RECOVERY::AddByte(const unsigned char Byte)
+{
+	AddSymbol(Byte);
+}
+
+void OUTPUT_DATA_RECOVERY::AddBytes(const unsigned char* const Data, const size_t Length)
+{
+	for (size_t i{ 0 }; i < Length; ++i)
+		AddSymbol(Data[i]);
+}
+
+void OUTPUT_DATA_RECOVERY::RepeatFragment(const int Fragment_Backposition, int Fragment_Length)
+{
+	for (; Fragment_Length > 0; --Fragment_Length)
+	{
+		if (static_cast<size_t>(Fragment_Backposition) >= m_WindowLength)
+			AddSymbol(UnknownSymbol);
+		else
+		{
+			const size_t SourcePosition{ (m_WindowEnd + m_Window.size() - 1 - Fragment_Backposition) % m_Window.size() };
+			AddSymbol(m_Window[SourcePosition]);
+		}
+	}
+}
+
+unsigned long long OUTPUT_DATA_RECOVERY::GetSegmentLength() const
+{
+	return m_Window.size();
+}
+
+unsigned long long OUTPUT_DATA_RECOVERY::GetBytesTotalCount() const
 {
 	return m_TotalAddedBytes;
 }
 
-unsigned long long OUTPUT_DATA_INFO::GetCRC32() const
+unsigned long long OUTPUT_DATA_RECOVERY::GetUnknownBytesCount() const
+{
+	return m_UnknownBytes;
+}
+
+void OUTPUT_DATA_RECOVERY::WriteBlock(std::ostream& Output)
+{
+	Output.write(reinterpret_cast<const char*>(m_PendingBlock.data()), m_PendingBlock.size());
+
+	m_TotalAddedBytes += m_PendingBlock.size();
+	m_UnknownBytes += m_PendingUnknownBytes;
+
+	m_PendingBlock.clear();
+	m_PendingUnknownBytes = 0;
+}
+
+void OUTPUT_DATA_RECOVERY::DiscardBlock()
+{
+	m_PendingBlock.clear();
+	m_PendingUnknownBytes = 0;
+}
+
+OUTPUT_DATA_BUFFER::OUTPUT_DATA_BUFFER(const size_t WindowSize, std::vector<unsigned char>& Data) : m_WindowSize{ WindowSize }, m_Data{ Data }, m_DataStart{ Data.size() }
+{
+}
+
+void OUTPUT_DATA_BUFFER::Reset()
+{
+	m_DataStart = m_Data.size();
+}
+
+void OUTPUT_DATA_BUFFER::AddByte(const unsigned char Byte)
+{
+	m_Data.push_back(Byte);
+}
+
+void OUTPUT_DATA_BUFFER::AddBytes(const unsigned char* const Data, const size_t Length)
+{
+	m_Data.insert(m_Data.end(), Data, Data + Length);
+}
+
+void OUTPUT_DATA_BUFFER::RepeatFragment(const int Fragment_Backposition, int Fragment_Length)
+{
+	// The fragment may overlap the bytes it adds, so they are copied one at a time.
+	for (; Fragment_Length > 0; --Fragment_Length)
+		m_Data.push_back(m_Data[m_Data.size() - 1 - Fragment_Backposition]);
+}
+
+unsigned long long OUTPUT_DATA_BUFFER::GetSegmentLength() const
+{
+	return std::min(m_Data.size() - m_DataStart, m_WindowSize);
+}
+
+unsigned long long OUTPUT_DATA_BUFFER::GetBytesTotalCount() const
+{
+	return m_Data.size() - m_DataStart;
+}
+
+OUTPUT_DATA_STREAM::OUTPUT_DATA_STREAM(const size_t WindowSize, std::ostream& Output) : m_WindowSize{ WindowSize }, m_Output{ Output }, m_WrittenBytes{ 0 }
+{
+	m_Data.reserve(m_FlushSize + m_WindowSize);
+}
+
+void OUTPUT_DATA_STREAM::Flush(const size_t KeptBytes)
+{
+	const auto WrittenBytes{ m_Data.size() - KeptBytes };
+	m_Output.write(reinterpret_cast<const char*>(m_Data.data()), WrittenBytes);
+	m_Data.erase(m_Data.begin(), m_Data.begin() + WrittenBytes);
+
+	m_WrittenBytes += WrittenBytes;
+}
+
+void OUTPUT_DATA_STREAM::Reset()
+{
+	m_Data.clear();
+	m_WrittenBytes = 0;
+}
+
+void OUTPUT_DATA_STREAM::AddByte(const unsigned char Byte)
+{
+	m_Data.push_back(Byte);
+
+	if (m_Data.size() >= m_FlushSize + m_WindowSize)
+		Flush(m_WindowSize);
+}
+
+void OUTPUT_DATA_STREAM::AddBytes(const unsigned char* const Data, const size_t Length)
+{
+	m_Data.insert(m_Data.end(), Data, Data + Length);
+
+	if (m_Data.size() >= m_FlushSize + m_WindowSize)
+		Flush(m_WindowSize);
+}
+
+void OUTPUT_DATA_STREAM::RepeatFragment(const int Fragment_Backposition, int Fragment_Length)
+{
+	// The fragment may overlap the bytes it adds, so they are copied one at a time.
+	for (; Fragment_Length > 0; --Fragment_Length)
+		m_Data.push_back(m_Data[m_Data.size() - 1 - Fragment_Backposition]);
+
+	if (m_Data.size() >= m_FlushSize + m_WindowSize)
+		Flush(m_WindowSize);
+}
+
+unsigned long long OUTPUT_DATA_STREAM::GetSegmentLength() const
+{
+	return std::min<unsigned long long>(m_WrittenBytes + m_Data.size(), m_WindowSize);
+}
+
+unsigned long long OUTPUT_DATA_STREAM::GetBytesTotalCount() const
+{
+	return m_WrittenBytes + m_Data.size();
+}
+
+void OUTPUT_DATA_STREAM::Finish()
 {
-	return m_CRC32.GetCRC();
+	Flush(0);
 }
\ No newline at end of file
@@ -1,7 +1,11 @@
 #pragma once
 
 #include "CRC.h"
+#include "Adler32.h"
+#include "CPUDispatch.h"
 
+#include <ostream>
+#include <span>
 #include <vector>
 #include <stdexcept>
 
@@ -11,54 +15,235 @@ public:
 	explicit OUTPUT_DATA_INFO_EXCEPTION(const char*);
 };
 
-class OUTPUT_DATA_INFO
+class CIRCULAR_BUFFER
 {
-	CRC32 m_CRC32;
-	unsigned long long m_TotalAddedBytes;
+	unsigned char* const m_Array;
+	const size_t m_ArraySize;
+
+	size_t m_DataStart;
+	size_t m_DataLength;
+
+public:
+	CIRCULAR_BUFFER() = delete;
+	explicit CIRCULAR_BUFFER(size_t);
+
+	~CIRCULAR_BUFFER();
 
-	class CIRCULAR_BUFFER
-	{
-		unsigned char* const m_Array;
-		const size_t m_ArraySize;
+	unsigned char& operator[](size_t);
+	unsigned char operator[](size_t) const;
 
-		size_t m_DataStart;
-		size_t m_DataLength;
+	void Empty();
 
-	public:
-		CIRCULAR_BUFFER() = delete;
-		explicit CIRCULAR_BUFFER(size_t);
+	unsigned char Front() const;
 
-		~CIRCULAR_BUFFER();
+	void Add(unsigned char);
+	void Add(const unsigned char*, size_t);
 
-		unsigned char& operator[](size_t);
+	// Copies Count elements, from the Index-th one on, to Destination.
+	void CopyOut(size_t Index, size_t Count, unsigned char* Destination) const;
 
-		void Empty();
+	unsigned char PopFront();
 
-		unsigned char Front() const;
+	size_t Length() const;
+	bool IsFull() const;
 
-		void Add(unsigned char);
-		void Add(const unsigned char*, size_t);
+	bool CheckIfBufferContains(const std::vector<unsigned char>&) const;
+	bool CheckIfBufferStarts(const std::vector<unsigned char>&) const;
+};
+
+// Copies Length bytes from Source to Destination, which comes after it, one after the other, as a DEFLATE back-reference does: where the two overlap, the bytes just copied are copied again, repeating the bytes between them.
+// The variants that copy several bytes at once may write up to MatchCopyOverrun bytes past the end of Destination.
+using MATCH_COPY_KERNEL = void (*)(unsigned char* Destination, const unsigned char* Source, size_t Length);
+
+constexpr size_t MatchCopyOverrun{ 32 };
 
-		unsigned char PopFront();
+// Every variant of the match copy kernel, from the generic one up, whether the processor supports it or not; for comparing them.
+std::span<const KERNEL_VARIANT<MATCH_COPY_KERNEL>> GetMatchCopyVariants();
 
-		size_t Length() const;
-		bool IsFull() const;
+// CHECKSUM is the checksum computed over the decompressed data: CRC32 for GZIP, ADLER32 for ZLIB.
+template <typename CHECKSUM>
+class OUTPUT_DATA_INFO
+{
+	CHECKSUM m_Checksum;
+	unsigned long long m_TotalAddedBytes;
 
-		bool CheckIfBufferContains(const std::vector<unsigned char>&) const;
-		bool CheckIfBufferStarts(const std::vector<unsigned char>&) const;
-	} m_LimitedSizeBuffer;
+	CIRCULAR_BUFFER m_LimitedSizeBuffer;
 
 public:
 	OUTPUT_DATA_INFO() = delete;
 	explicit OUTPUT_DATA_INFO(size_t BufferSize);
 
 	void Reset();
+	// Resets, and then puts the data that came before into the window, without counting it or adding it to the checksum; used to carry on decoding a stream from the middle.
+	void Reset(const std::vector<unsigned char>& PrecedingData);
 	void NewDataSegment();
 
 	void AddByte(unsigned char Byte);
+	void AddBytes(const unsigned char* Data, size_t Length);
+	void RepeatFragment(int Fragment_Backposition, int Fragment_Length);
+
+	unsigned long long GetSegmentLength() const;
+	unsigned long long GetBytesTotalCount() const;
+	unsigned long long GetChecksum() const;
+	void GetWindow(std::vector<unsigned char>& out_Window) const;
+};
+
+extern template class OUTPUT_DATA_INFO<CRC32>;
+extern template class OUTPUT_DATA_INFO<ADLER32>;
+
+// Stands in for OUTPUT_DATA_INFO when only the structure of the data is validated: it keeps no window and computes no CRC, it only counts the bytes.
+class OUTPUT_DATA_COUNTER
+{
+	const unsigned long long m_WindowSize;
+	unsigned long long m_TotalAddedBytes;
+
+public:
+	OUTPUT_DATA_COUNTER() = delete;
+	explicit OUTPUT_DATA_COUNTER(size_t WindowSize);
+
+	void Reset();
+
+	void AddByte(unsigned char Byte);
+	void AddBytes(const unsigned char* Data, size_t Length);
+	void RepeatFragment(int Fragment_Backposition, int Fragment_Length);
+
+	unsigned long long GetSegmentLength() const;
+	unsigned long long GetBytesTotalCount() const;
+};
+
+// Stands in for OUTPUT_DATA_INFO when decoding starts at a block in the middle of a stream, before the data that came before it is known.
+// Bytes copied from that unknown window are recorded as markers, to be resolved once the window is known. As soon as the last WindowSize symbols hold no markers, no later byte can depend on the window, and it falls back to keeping only a window and a CRC32.
+class OUTPUT_DATA_SPECULATIVE
+{
+	const size_t m_WindowSize;
+	const size_t m_MaximumSymbols;
+
+	// Literal bytes, or markers: MarkerBase plus the position of the byte in the unknown window.
+	std::vector<unsigned short> m_Symbols;
+	size_t m_SymbolsAfterLastMarker;
+	bool m_Overflowed;
+
+	bool m_WindowResolved;
+	CIRCULAR_BUFFER m_Window;
+	CRC32 m_Checksum;
+	unsigned long long m_TotalAddedBytes;
+
+	void AddSymbol(unsigned short Symbol);
+
+public:
+	static constexpr unsigned short MarkerBase{ 256 };
+
+	OUTPUT_DATA_SPECULATIVE() = delete;
+	// Once more than MaximumSymbols would have to be kept, the data is given up on as a whole, and Resolve() fails.
+	OUTPUT_DATA_SPECULATIVE(size_t WindowSize, size_t MaximumSymbols);
+
+	void Reset();
+
+	void AddByte(unsigned char Byte);
+	void AddBytes(const unsigned char* Data, size_t Length);
 	void RepeatFragment(int Fragment_Backposition, int Fragment_Length);
 
+	// Any back-reference within a window's reach is accepted, as the data before the start is unknown; Resolve() checks them against the actual window.
 	unsigned long long GetSegmentLength() const;
 	unsigned long long GetBytesTotalCount() const;
-	unsigned long long GetCRC32() const;
+
+	// Replaces the markers with bytes from io_Window, which has to hold the last bytes decoded before this data. Fails if a marker points to before the start of the stream, that is, before the start of a window shorter than WindowSize.
+	// On success, io_Checksum is extended with the CRC32 of this data, and io_Window is replaced by the last bytes of this data.
+	bool Resolve(std::vector<unsigned char>& io_Window, unsigned long long& io_Checksum) const;
+};
+
+// Collects the data decoded from a damaged stream, one block at a time: the data of a block is only written out once the whole block has been decoded.
+// Decoding can resume after damaged data, with the window it refers to unknown; the bytes copied from that window are written as UnknownByte, and counted.
+class OUTPUT_DATA_RECOVERY
+{
+	static constexpr unsigned short UnknownSymbol{ 256 };
+
+	// The last decoded bytes, or UnknownSymbol for the ones that are unknown.
+	std::vector<unsigned short> m_Window;
+	size_t m_WindowEnd;
+	size_t m_WindowLength;
+
+	std::vector<unsigned char> m_PendingBlock;
+	unsigned long long m_PendingUnknownBytes;
+
+	unsigned long long m_TotalAddedBytes;
+	unsigned long long m_UnknownBytes;
+
+	void AddSymbol(unsigned short Symbol);
+
+public:
+	static constexpr unsigned char UnknownByte{ '?' };
+
+	OUTPUT_DATA_RECOVERY() = delete;
+	explicit OUTPUT_DATA_RECOVERY(size_t WindowSize);
+
+	void Reset();
+	// Forgets the window, as the data before the next block has been lost.
+	void ForgetWindow();
+
+	void AddByte(unsigned char Byte);
+	void AddBytes(const unsigned char* Data, size_t Length);
+	void RepeatFragment(int Fragment_Backposition, int Fragment_Length);
+
+	// Any back-reference within a window's reach is accepted; the bytes it reaches past the known data are unknown.
+	unsigned long long GetSegmentLength() const;
+	// The number of bytes written out, and how many of those are unknown.
+	unsigned long long GetBytesTotalCount() const;
+	unsigned long long GetUnknownBytesCount() const;
+
+	void WriteBlock(std::ostream& Output);
+	void DiscardBlock();
+};
+
+// Stands in for OUTPUT_DATA_INFO when the decompressed data itself is wanted: all of it is appended to a vector, which serves as the window as well.
+class OUTPUT_DATA_BUFFER
+{
+	const size_t m_WindowSize;
+	std::vector<unsigned char>& m_Data;
+	size_t m_DataStart;
+
+public:
+	OUTPUT_DATA_BUFFER() = delete;
+	OUTPUT_DATA_BUFFER(size_t WindowSize, std::vector<unsigned char>& Data);
+
+	// Starts a new stream at the current end of the data.
+	void Reset();
+
+	void AddByte(unsigned char Byte);
+	void AddBytes(const unsigned char* Data, size_t Length);
+	void RepeatFragment(int Fragment_Backposition, int Fragment_Length);
+
+	unsigned long long GetSegmentLength() const;
+	unsigned long long GetBytesTotalCount() const;
+};
+
+// Stands in for OUTPUT_DATA_INFO when the decompressed data is to be written out as it is decoded: the data is collected in a buffer, which serves as the window as well, and all but the last window of it is written out whenever the buffer fills up.
+class OUTPUT_DATA_STREAM
+{
+	static constexpr size_t m_FlushSize{ 1 << 20 };
+
+	const size_t m_WindowSize;
+	std::ostream& m_Output;
+	std::vector<unsigned char> m_Data;
+	// The number of bytes of the current stream written out, and dropped from the buffer.
+	unsigned long long m_WrittenBytes;
+
+	void Flush(size_t KeptBytes);
+
+public:
+	OUTPUT_DATA_STREAM() = delete;
+	OUTPUT_DATA_STREAM(size_t WindowSize, std::ostream& Output);
+
+	// Starts a new stream; the data of the previous one must have been written out with Finish.
+	void Reset();
+
+	void AddByte(unsigned char Byte);
+	void AddBytes(const unsigned char* Data, size_t Length);
+	void RepeatFragment(int Fragment_Backposition, int Fragment_Length);
+
+	unsigned long long GetSegmentLength() const;
+	unsigned long long GetBytesTotalCount() const;
+
+	// Writes out the rest of the data.
+	void Finish();
 };
\ No newline at end of file
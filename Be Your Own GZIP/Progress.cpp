@@ -0,0 +1,93 @@
+#include "Progress.h"
+
+#include "Carving.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+PROGRESS_REPORTER::PROGRESS_REPORTER(const SCAN_PROGRESS& Progress, const unsigned int IntervalSeconds, const std::filesystem::path& StatusFilePath) :
+	m_Progress{ Progress },
+	m_Interval{ std::max(IntervalSeconds, 1u) },
+	m_StatusFilePath{ StatusFilePath },
+	m_StartTime{ std::chrono::steady_clock::now() },
+	m_Stopping{ false }
+{
+	m_Thread = std::thread{ &PROGRESS_REPORTER::Run, this };
+}
+
+PROGRESS_REPORTER::~PROGRESS_REPORTER()
+{
+	{
+		std::lock_guard Lock{ m_Mutex };
+		m_Stopping = true;
+	}
+	m_StopRequest.notify_one();
+
+	m_Thread.join();
+
+	try
+	{
+		Report();
+	}
+	catch (...) {}
+}
+
+void PROGRESS_REPORTER::Run()
+{
+	std::unique_lock Lock{ m_Mutex };
+	while (m_StopRequest.wait_for(Lock, m_Interval, [this] { return m_Stopping; }) == false)
+	{
+		try
+		{
+			Report();
+		}
+		catch (...) {}
+	}
+}
+
+// Rates are averaged over the whole scan so far, which keeps the estimate steady while large members are being validated.
+std::wstring PROGRESS_REPORTER::FormatReport() const
+{
+	const auto TotalSize{ m_Progress.TotalSize.load(std::memory_order_relaxed) };
+	const auto Offset{ m_Progress.Offset.load(std::memory_order_relaxed) };
+	const auto StartOffset{ m_Progress.StartOffset.load(std::memory_order_relaxed) };
+	const auto Candidates{ m_Progress.Candidates.load(std::memory_order_relaxed) };
+	const auto FilesFound{ m_Progress.FilesFound.load(std::memory_order_relaxed) };
+
+	const auto Elapsed{ std::chrono::duration<double>(std::chrono::steady_clock::now() - m_StartTime).count() };
+	const auto BytesPerSecond{ ((Elapsed > 0) && (Offset > StartOffset)) ? ((Offset - StartOffset) / Elapsed) : 0.0 };
+
+	std::wostringstream Text;
+	Text << std::fixed << std::setprecision(1) <<
+		L"Offset " << Offset <<
+		L" (" << ((TotalSize > 0) ? (100.0 * Offset / TotalSize) : 100.0) << L"%), " <<
+		(BytesPerSecond / (1 << 20)) << L" MB/s, " <<
+		((Elapsed > 0) ? (Candidates / Elapsed) : 0.0) << L" candidates/s, " <<
+		FilesFound << L" files found, ETA ";
+
+	if ((BytesPerSecond > 0) && (TotalSize >= Offset))
+	{
+		const auto RemainingSeconds{ static_cast<unsigned long long>((TotalSize - Offset) / BytesPerSecond) };
+		Text << (RemainingSeconds / 3600) << L':' << std::setfill(L'0') << std::setw(2) << ((RemainingSeconds / 60) % 60) << L':' << std::setw(2) << (RemainingSeconds % 60);
+	}
+	else
+		Text << L"unknown";
+
+	return Text.str();
+}
+
+void PROGRESS_REPORTER::Report() const
+{
+	const auto Text{ FormatReport() };
+
+	if (m_StatusFilePath.empty())
+	{
+		std::wcerr << Text << std::endl;
+
+		return;
+	}
+
+	ReplaceFile(m_StatusFilePath, ConvertToUTF8(Text) + '\n');
+}
\ No newline at end of file
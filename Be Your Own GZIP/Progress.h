@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Counters updated by the scanner as it goes, and read by a PROGRESS_REPORTER from another thread.
+// Each counter is only ever read on its own, to be displayed, so relaxed atomics are enough; updating one costs no more than a plain store.
+struct SCAN_PROGRESS
+{
+	std::atomic<unsigned long long> TotalSize{ 0 };
+	std::atomic<unsigned long long> Offset{ 0 };
+	// Where the scan started; past 0 if it was resumed from a checkpoint.
+	std::atomic<unsigned long long> StartOffset{ 0 };
+	std::atomic<unsigned long long> Candidates{ 0 };
+	std::atomic<unsigned long long> FilesFound{ 0 };
+
+	// Only the scanner updates the counters, so they can be incremented without a read-modify-write instruction.
+	static void Increment(std::atomic<unsigned long long>& Counter)
+	{
+		Counter.store(Counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+};
+
+// Reports the progress of a scan at a fixed interval, from a thread of its own, until it is destroyed; a final report is made then.
+// Each report is a line written to the standard error stream, or, if a status file is given, the whole content of that file, replaced at once.
+class PROGRESS_REPORTER
+{
+	const SCAN_PROGRESS& m_Progress;
+	const std::chrono::seconds m_Interval;
+	const std::filesystem::path m_StatusFilePath;
+	const std::chrono::steady_clock::time_point m_StartTime;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_StopRequest;
+	bool m_Stopping;
+	std::thread m_Thread;
+
+	std::wstring FormatReport() const;
+	void Report() const;
+	void Run();
+
+public:
+	PROGRESS_REPORTER() = delete;
+	PROGRESS_REPORTER(const SCAN_PROGRESS& Progress, unsigned int IntervalSeconds, const std::filesystem::path& StatusFilePath);
+
+	~PROGRESS_REPORTER();
+
+	PROGRESS_REPORTER(const PROGRESS_REPORTER&) = delete;
+	PROGRESS_REPORTER& operator=(const PROGRESS_REPORTER&) = delete;
+};
\ No newline at end of file
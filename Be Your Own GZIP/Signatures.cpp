@@ -0,0 +1,254 @@
+#include "Signatures.h"
+
+#include <bit>
+
+#ifdef CPU_DISPATCH_X86
+#include <immintrin.h>
+#endif
+
+constexpr unsigned char GZIP_ID1{ 0x1F };
+constexpr unsigned char GZIP_ID2{ 0x8B };
+
+// CMF of a ZLIB stream that uses DEFLATE with a 32 KiB window.
+constexpr unsigned char ZLIB_CMF{ 0x78 };
+// For that CMF, these are the only FLG values that have a valid FCHECK and do not ask for a preset dictionary.
+constexpr unsigned char ZLIB_FLG[]{ 0x01, 0x5E, 0x9C, 0xDA };
+
+constexpr unsigned char ZIP_SIGNATURE[]{ 0x50, 0x4B, 0x03, 0x04 };
+
+// 0x1F 8B 08, encoded in base64.
+constexpr unsigned char BASE64_SIGNATURE[]{ 'H', '4', 's', 'I' };
+
+const wchar_t* GetSignatureFormatName(const SIGNATURE_FORMAT Format)
+{
+	switch (Format)
+	{
+		case SIGNATURE_FORMAT::ZLIB:
+			return L"ZLIB";
+		case SIGNATURE_FORMAT::ZIP:
+			return L"ZIP";
+		case SIGNATURE_FORMAT::BASE64:
+			return L"BASE64";
+		case SIGNATURE_FORMAT::GZIP:
+		default:
+			return L"GZIP";
+	}
+}
+
+// Checks whether a signature starts at Data, reading no more than Available bytes.
+static bool MatchSignature(const unsigned char* const Data, const size_t Available, const unsigned int FormatMask, SIGNATURE_FORMAT& out_Format)
+{
+	if (Available < 2)
+		return false;
+
+	if ((Data[0] == GZIP_ID1) && (Data[1] == GZIP_ID2) && (FormatMask & SignatureFormatBit(SIGNATURE_FORMAT::GZIP)))
+	{
+		out_Format = SIGNATURE_FORMAT::GZIP;
+
+		return true;
+	}
+
+	if ((Data[0] == ZLIB_CMF) && (FormatMask & SignatureFormatBit(SIGNATURE_FORMAT::ZLIB)))
+		for (const auto FLG : ZLIB_FLG)
+			if (Data[1] == FLG)
+			{
+				out_Format = SIGNATURE_FORMAT::ZLIB;
+
+				return true;
+			}
+
+	if ((Data[0] == ZIP_SIGNATURE[0]) && (Data[1] == ZIP_SIGNATURE[1]) && (FormatMask & SignatureFormatBit(SIGNATURE_FORMAT::ZIP)))
+		if ((Available >= 4) && (Data[2] == ZIP_SIGNATURE[2]) && (Data[3] == ZIP_SIGNATURE[3]))
+		{
+			out_Format = SIGNATURE_FORMAT::ZIP;
+
+			return true;
+		}
+
+	if ((Data[0] == BASE64_SIGNATURE[0]) && (Data[1] == BASE64_SIGNATURE[1]) && (FormatMask & SignatureFormatBit(SIGNATURE_FORMAT::BASE64)))
+		if ((Available >= 4) && (Data[2] == BASE64_SIGNATURE[2]) && (Data[3] == BASE64_SIGNATURE[3]))
+		{
+			out_Format = SIGNATURE_FORMAT::BASE64;
+
+			return true;
+		}
+
+	return false;
+}
+
+// Looks at one position at a time, from Position on; the variants that look at several positions at once leave the last few to this.
+static void FindSignaturesFrom(const unsigned char* const Data, const size_t Length, const size_t ScanLength, const unsigned int FormatMask, size_t Position, std::vector<SIGNATURE_CANDIDATE>& out_Candidates)
+{
+	SIGNATURE_FORMAT Format;
+	for (; (Position < ScanLength) && (Position < Length); ++Position)
+		if (MatchSignature(Data + Position, Length - Position, FormatMask, Format))
+			out_Candidates.push_back({ Position, Format });
+}
+
+// Looks at the positions set in Matches, counted from Position, one by one.
+template <typename MASK>
+static void CheckMatches(const unsigned char* const Data, const size_t Length, const unsigned int FormatMask, const size_t Position, MASK Matches, std::vector<SIGNATURE_CANDIDATE>& out_Candidates)
+{
+	SIGNATURE_FORMAT Format;
+	while (Matches != 0)
+	{
+		const size_t MatchPosition{ Position + std::countr_zero(Matches) };
+		Matches &= Matches - 1;
+
+		if (MatchSignature(Data + MatchPosition, Length - MatchPosition, FormatMask, Format))
+			out_Candidates.push_back({ MatchPosition, Format });
+	}
+}
+
+static void FindSignatures_Generic(const unsigned char* const Data, const size_t Length, const size_t ScanLength, const unsigned int FormatMask, std::vector<SIGNATURE_CANDIDATE>& out_Candidates)
+{
+	FindSignaturesFrom(Data, Length, ScanLength, FormatMask, 0, out_Candidates);
+}
+
+#ifdef CPU_DISPATCH_X86
+// Compares 16 positions at a time: the bytes at those positions against the first bytes of the signatures, and the bytes following them against the second bytes.
+// Only the positions where the first two bytes of some signature matched are then looked at one by one.
+static void FindSignatures_SSE2(const unsigned char* const Data, const size_t Length, const size_t ScanLength, const unsigned int FormatMask, std::vector<SIGNATURE_CANDIDATE>& out_Candidates)
+{
+	size_t Position{ 0 };
+
+	const __m128i GZIP_Enabled{ _mm_set1_epi8((FormatMask & SignatureFormatBit(SIGNATURE_FORMAT::GZIP)) ? -1 : 0) };
+	const __m128i ZLIB_Enabled{ _mm_set1_epi8((FormatMask & SignatureFormatBit(SIGNATURE_FORMAT::ZLIB)) ? -1 : 0) };
+	const __m128i ZIP_Enabled{ _mm_set1_epi8((FormatMask & SignatureFormatBit(SIGNATURE_FORMAT::ZIP)) ? -1 : 0) };
+	const __m128i BASE64_Enabled{ _mm_set1_epi8((FormatMask & SignatureFormatBit(SIGNATURE_FORMAT::BASE64)) ? -1 : 0) };
+
+	const __m128i GZIP_First{ _mm_set1_epi8(static_cast<char>(GZIP_ID1)) };
+	const __m128i GZIP_Second{ _mm_set1_epi8(static_cast<char>(GZIP_ID2)) };
+	const __m128i ZLIB_First{ _mm_set1_epi8(static_cast<char>(ZLIB_CMF)) };
+	const __m128i ZLIB_Second_0{ _mm_set1_epi8(static_cast<char>(ZLIB_FLG[0])) };
+	const __m128i ZLIB_Second_1{ _mm_set1_epi8(static_cast<char>(ZLIB_FLG[1])) };
+	const __m128i ZLIB_Second_2{ _mm_set1_epi8(static_cast<char>(ZLIB_FLG[2])) };
+	const __m128i ZLIB_Second_3{ _mm_set1_epi8(static_cast<char>(ZLIB_FLG[3])) };
+	const __m128i ZIP_First{ _mm_set1_epi8(static_cast<char>(ZIP_SIGNATURE[0])) };
+	const __m128i ZIP_Second{ _mm_set1_epi8(static_cast<char>(ZIP_SIGNATURE[1])) };
+	const __m128i BASE64_First{ _mm_set1_epi8(static_cast<char>(BASE64_SIGNATURE[0])) };
+	const __m128i BASE64_Second{ _mm_set1_epi8(static_cast<char>(BASE64_SIGNATURE[1])) };
+
+	for (; (Position + 16 <= ScanLength) && (Position + 16 < Length); Position += 16)
+	{
+		const __m128i First{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(Data + Position)) };
+		const __m128i Second{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(Data + Position + 1)) };
+
+		const __m128i GZIP_Matches{ _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(First, GZIP_First), _mm_cmpeq_epi8(Second, GZIP_Second)), GZIP_Enabled) };
+
+		const __m128i ZLIB_SecondMatches{ _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(Second, ZLIB_Second_0), _mm_cmpeq_epi8(Second, ZLIB_Second_1)), _mm_or_si128(_mm_cmpeq_epi8(Second, ZLIB_Second_2), _mm_cmpeq_epi8(Second, ZLIB_Second_3))) };
+		const __m128i ZLIB_Matches{ _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(First, ZLIB_First), ZLIB_SecondMatches), ZLIB_Enabled) };
+
+		const __m128i ZIP_Matches{ _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(First, ZIP_First), _mm_cmpeq_epi8(Second, ZIP_Second)), ZIP_Enabled) };
+		const __m128i BASE64_Matches{ _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(First, BASE64_First), _mm_cmpeq_epi8(Second, BASE64_Second)), BASE64_Enabled) };
+
+		CheckMatches(Data, Length, FormatMask, Position, static_cast<unsigned int>(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(GZIP_Matches, ZLIB_Matches), _mm_or_si128(ZIP_Matches, BASE64_Matches)))), out_Candidates);
+	}
+
+	FindSignaturesFrom(Data, Length, ScanLength, FormatMask, Position, out_Candidates);
+}
+
+// The same comparisons as FindSignatures_SSE2, 32 positions at a time.
+static void FindSignatures_AVX2(const unsigned char* const Data, const size_t Length, const size_t ScanLength, const unsigned int FormatMask, std::vector<SIGNATURE_CANDIDATE>& out_Candidates)
+{
+	size_t Position{ 0 };
+
+	const __m256i GZIP_Enabled{ _mm256_set1_epi8((FormatMask & SignatureFormatBit(SIGNATURE_FORMAT::GZIP)) ? -1 : 0) };
+	const __m256i ZLIB_Enabled{ _mm256_set1_epi8((FormatMask & SignatureFormatBit(SIGNATURE_FORMAT::ZLIB)) ? -1 : 0) };
+	const __m256i ZIP_Enabled{ _mm256_set1_epi8((FormatMask & SignatureFormatBit(SIGNATURE_FORMAT::ZIP)) ? -1 : 0) };
+	const __m256i BASE64_Enabled{ _mm256_set1_epi8((FormatMask & SignatureFormatBit(SIGNATURE_FORMAT::BASE64)) ? -1 : 0) };
+
+	const __m256i GZIP_First{ _mm256_set1_epi8(static_cast<char>(GZIP_ID1)) };
+	const __m256i GZIP_Second{ _mm256_set1_epi8(static_cast<char>(GZIP_ID2)) };
+	const __m256i ZLIB_First{ _mm256_set1_epi8(static_cast<char>(ZLIB_CMF)) };
+	const __m256i ZLIB_Second_0{ _mm256_set1_epi8(static_cast<char>(ZLIB_FLG[0])) };
+	const __m256i ZLIB_Second_1{ _mm256_set1_epi8(static_cast<char>(ZLIB_FLG[1])) };
+	const __m256i ZLIB_Second_2{ _mm256_set1_epi8(static_cast<char>(ZLIB_FLG[2])) };
+	const __m256i ZLIB_Second_3{ _mm256_set1_epi8(static_cast<char>(ZLIB_FLG[3])) };
+	const __m256i ZIP_First{ _mm256_set1_epi8(static_cast<char>(ZIP_SIGNATURE[0])) };
+	const __m256i ZIP_Second{ _mm256_set1_epi8(static_cast<char>(ZIP_SIGNATURE[1])) };
+	const __m256i BASE64_First{ _mm256_set1_epi8(static_cast<char>(BASE64_SIGNATURE[0])) };
+	const __m256i BASE64_Second{ _mm256_set1_epi8(static_cast<char>(BASE64_SIGNATURE[1])) };
+
+	for (; (Position + 32 <= ScanLength) && (Position + 32 < Length); Position += 32)
+	{
+		const __m256i First{ _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Data + Position)) };
+		const __m256i Second{ _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Data + Position + 1)) };
+
+		const __m256i GZIP_Matches{ _mm256_and_si256(_mm256_and_si256(_mm256_cmpeq_epi8(First, GZIP_First), _mm256_cmpeq_epi8(Second, GZIP_Second)), GZIP_Enabled) };
+
+		const __m256i ZLIB_SecondMatches{ _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(Second, ZLIB_Second_0), _mm256_cmpeq_epi8(Second, ZLIB_Second_1)), _mm256_or_si256(_mm256_cmpeq_epi8(Second, ZLIB_Second_2), _mm256_cmpeq_epi8(Second, ZLIB_Second_3))) };
+		const __m256i ZLIB_Matches{ _mm256_and_si256(_mm256_and_si256(_mm256_cmpeq_epi8(First, ZLIB_First), ZLIB_SecondMatches), ZLIB_Enabled) };
+
+		const __m256i ZIP_Matches{ _mm256_and_si256(_mm256_and_si256(_mm256_cmpeq_epi8(First, ZIP_First), _mm256_cmpeq_epi8(Second, ZIP_Second)), ZIP_Enabled) };
+		const __m256i BASE64_Matches{ _mm256_and_si256(_mm256_and_si256(_mm256_cmpeq_epi8(First, BASE64_First), _mm256_cmpeq_epi8(Second, BASE64_Second)), BASE64_Enabled) };
+
+		CheckMatches(Data, Length, FormatMask, Position, static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(GZIP_Matches, ZLIB_Matches), _mm256_or_si256(ZIP_Matches, BASE64_Matches)))), out_Candidates);
+	}
+
+	FindSignaturesFrom(Data, Length, ScanLength, FormatMask, Position, out_Candidates);
+}
+
+// The same comparisons, 64 positions at a time; AVX-512 compares straight into bit masks.
+static void FindSignatures_AVX512(const unsigned char* const Data, const size_t Length, const size_t ScanLength, const unsigned int FormatMask, std::vector<SIGNATURE_CANDIDATE>& out_Candidates)
+{
+	size_t Position{ 0 };
+
+	const __mmask64 GZIP_Enabled{ (FormatMask & SignatureFormatBit(SIGNATURE_FORMAT::GZIP)) ? ~0ull : 0ull };
+	const __mmask64 ZLIB_Enabled{ (FormatMask & SignatureFormatBit(SIGNATURE_FORMAT::ZLIB)) ? ~0ull : 0ull };
+	const __mmask64 ZIP_Enabled{ (FormatMask & SignatureFormatBit(SIGNATURE_FORMAT::ZIP)) ? ~0ull : 0ull };
+	const __mmask64 BASE64_Enabled{ (FormatMask & SignatureFormatBit(SIGNATURE_FORMAT::BASE64)) ? ~0ull : 0ull };
+
+	const __m512i GZIP_First{ _mm512_set1_epi8(static_cast<char>(GZIP_ID1)) };
+	const __m512i GZIP_Second{ _mm512_set1_epi8(static_cast<char>(GZIP_ID2)) };
+	const __m512i ZLIB_First{ _mm512_set1_epi8(static_cast<char>(ZLIB_CMF)) };
+	const __m512i ZLIB_Second_0{ _mm512_set1_epi8(static_cast<char>(ZLIB_FLG[0])) };
+	const __m512i ZLIB_Second_1{ _mm512_set1_epi8(static_cast<char>(ZLIB_FLG[1])) };
+	const __m512i ZLIB_Second_2{ _mm512_set1_epi8(static_cast<char>(ZLIB_FLG[2])) };
+	const __m512i ZLIB_Second_3{ _mm512_set1_epi8(static_cast<char>(ZLIB_FLG[3])) };
+	const __m512i ZIP_First{ _mm512_set1_epi8(static_cast<char>(ZIP_SIGNATURE[0])) };
+	const __m512i ZIP_Second{ _mm512_set1_epi8(static_cast<char>(ZIP_SIGNATURE[1])) };
+	const __m512i BASE64_First{ _mm512_set1_epi8(static_cast<char>(BASE64_SIGNATURE[0])) };
+	const __m512i BASE64_Second{ _mm512_set1_epi8(static_cast<char>(BASE64_SIGNATURE[1])) };
+
+	for (; (Position + 64 <= ScanLength) && (Position + 64 < Length); Position += 64)
+	{
+		const __m512i First{ _mm512_loadu_si512(Data + Position) };
+		const __m512i Second{ _mm512_loadu_si512(Data + Position + 1) };
+
+		const __mmask64 GZIP_Matches{ _mm512_cmpeq_epi8_mask(First, GZIP_First) & _mm512_cmpeq_epi8_mask(Second, GZIP_Second) & GZIP_Enabled };
+
+		const __mmask64 ZLIB_SecondMatches{ _mm512_cmpeq_epi8_mask(Second, ZLIB_Second_0) | _mm512_cmpeq_epi8_mask(Second, ZLIB_Second_1) | _mm512_cmpeq_epi8_mask(Second, ZLIB_Second_2) | _mm512_cmpeq_epi8_mask(Second, ZLIB_Second_3) };
+		const __mmask64 ZLIB_Matches{ _mm512_cmpeq_epi8_mask(First, ZLIB_First) & ZLIB_SecondMatches & ZLIB_Enabled };
+
+		const __mmask64 ZIP_Matches{ _mm512_cmpeq_epi8_mask(First, ZIP_First) & _mm512_cmpeq_epi8_mask(Second, ZIP_Second) & ZIP_Enabled };
+		const __mmask64 BASE64_Matches{ _mm512_cmpeq_epi8_mask(First, BASE64_First) & _mm512_cmpeq_epi8_mask(Second, BASE64_Second) & BASE64_Enabled };
+
+		CheckMatches(Data, Length, FormatMask, Position, static_cast<unsigned long long>(GZIP_Matches | ZLIB_Matches | ZIP_Matches | BASE64_Matches), out_Candidates);
+	}
+
+	FindSignaturesFrom(Data, Length, ScanLength, FormatMask, Position, out_Candidates);
+}
+#endif
+
+static constexpr KERNEL_VARIANT<FIND_SIGNATURES_KERNEL> FindSignaturesVariants[]
+{
+	{ INSTRUCTION_SET::GENERIC, &FindSignatures_Generic, L"generic" },
+#ifdef CPU_DISPATCH_X86
+	{ INSTRUCTION_SET::SSE2, &FindSignatures_SSE2, L"sse2" },
+	{ INSTRUCTION_SET::AVX2, &FindSignatures_AVX2, L"avx2" },
+	{ INSTRUCTION_SET::AVX512, &FindSignatures_AVX512, L"avx512" }
+#endif
+};
+
+void FindSignatures(const unsigned char* const Data, const size_t Length, const size_t ScanLength, const unsigned int FormatMask, std::vector<SIGNATURE_CANDIDATE>& out_Candidates)
+{
+	static const auto Kernel{ PickKernelVariant(FindSignaturesVariants, GetInstructionSet()).Function };
+
+	Kernel(Data, Length, ScanLength, FormatMask, out_Candidates);
+}
+
+std::span<const KERNEL_VARIANT<FIND_SIGNATURES_KERNEL>> GetFindSignaturesVariants()
+{
+	return FindSignaturesVariants;
+}
\ No newline at end of file
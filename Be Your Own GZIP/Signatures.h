@@ -0,0 +1,48 @@
+#pragma once
+
+#include "CPUDispatch.h"
+
+#include <span>
+#include <vector>
+
+// The formats whose signatures the scanner looks for.
+enum class SIGNATURE_FORMAT
+{
+	GZIP,// 0x1F 8B
+	ZLIB,// 0x78 01, 0x78 5E, 0x78 9C or 0x78 DA
+	ZIP,// 0x50 4B 03 04 ("PK\3\4"), the signature of a local file header
+	BASE64// "H4sI", the start of a GZIP encoded in base64 text, as the magic word and the CM byte of DEFLATE come out
+};
+
+constexpr unsigned int SIGNATURE_FORMAT_COUNT{ 4 };
+
+// The length of the longest signature.
+constexpr size_t SIGNATURE_MAXIMUM_LENGTH{ 4 };
+
+constexpr unsigned int SignatureFormatBit(const SIGNATURE_FORMAT Format)
+{
+	return 1u << static_cast<unsigned int>(Format);
+}
+
+constexpr unsigned int ALL_SIGNATURE_FORMATS{ (1u << SIGNATURE_FORMAT_COUNT) - 1 };
+// GZIPs in base64 text are only looked for on demand, as only text holds them.
+constexpr unsigned int DEFAULT_SIGNATURE_FORMATS{ ALL_SIGNATURE_FORMATS & ~SignatureFormatBit(SIGNATURE_FORMAT::BASE64) };
+
+// The name of the format, as used in options and reports, such as L"GZIP".
+const wchar_t* GetSignatureFormatName(SIGNATURE_FORMAT Format);
+
+struct SIGNATURE_CANDIDATE
+{
+	size_t Position;
+	SIGNATURE_FORMAT Format;
+};
+
+// Looks for the signatures of the formats selected by FormatMask in a single pass over the data, and appends every match to out_Candidates, in order of position.
+// Only signatures starting in the first ScanLength bytes are looked for, but all Length bytes may be read to match them; a match is only reported if all of its bytes are within the data.
+// The variant used is the one picked for the instruction set of the processor, the first time it is called.
+void FindSignatures(const unsigned char* Data, size_t Length, size_t ScanLength, unsigned int FormatMask, std::vector<SIGNATURE_CANDIDATE>& out_Candidates);
+
+using FIND_SIGNATURES_KERNEL = void (*)(const unsigned char* Data, size_t Length, size_t ScanLength, unsigned int FormatMask, std::vector<SIGNATURE_CANDIDATE>& out_Candidates);
+
+// Every variant of FindSignatures, from the generic one up, whether the processor supports it or not; for comparing them.
+std::span<const KERNEL_VARIANT<FIND_SIGNATURES_KERNEL>> GetFindSignaturesVariants();
\ No newline at end of file
@@ -0,0 +1,70 @@
+#include "StandardOutput.h"
+
+#include "Carving.h"
+#include "DEFLATE.h"
+#include "Tracing.h"
+
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <io.h>
+
+// The path of a file is made of offsets, slashes and an extension, so it needs no conversion beyond narrowing.
+static void WriteFrameHeader(const std::wstring& Name, const unsigned long long Size)
+{
+	std::cout << std::string(Name.begin(), Name.end()) << ' ' << Size << '\n';
+}
+
+void PrepareStandardOutput()
+{
+	std::fflush(stdout);
+	if (_setmode(_fileno(stdout), _O_BINARY) == -1)
+		throw std::runtime_error("Could not switch the standard output to binary mode.");
+}
+
+void WriteCarvedDataToStandardOutput(std::istream& InputStream, const std::streampos StartPosition, const unsigned long long Size, const std::wstring& Name, const std::vector<unsigned char>& Trailer)
+{
+	TRACE_SPAN(WriteSpan, "write");
+	TRACE_ARGUMENT(WriteSpan, "size", Size + Trailer.size());
+
+	if (Name.empty() == false)
+		WriteFrameHeader(Name, Size + Trailer.size());
+
+	CopyCarvedData(InputStream, StartPosition, Size, std::cout);
+	std::cout.write(reinterpret_cast<const char*>(Trailer.data()), Trailer.size());
+
+	if (std::cout.good() == false)
+		throw std::runtime_error("An error occured while writing to the standard output.");
+}
+
+void InflateToStandardOutput(INFLATE_CONTEXT& Context, std::istream& InputStream, const std::vector<std::streampos>& DataPositions, const unsigned long long Size, const std::wstring& Name)
+{
+	TRACE_SPAN(WriteSpan, "inflated write");
+	TRACE_ARGUMENT(WriteSpan, "size", Size);
+
+	WriteFrameHeader(Name, Size);
+
+	// The frame has been announced with its size, so data that does not decompress to that size, as validated, leaves the output unusable.
+	unsigned long long l_Size{ 0 };
+	for (const auto& DataPosition : DataPositions)
+	{
+		InputStream.clear();
+		InputStream.seekg(DataPosition);
+		if (InputStream.good() == false)
+			throw std::runtime_error("An error occured while reading the binary.");
+
+		unsigned long long SizeOfDecompressedData;
+		if (InflateDEFLATEdata(Context, InputStream, std::cout, SizeOfDecompressedData) == false)
+			throw std::runtime_error("Validated data could not be decompressed again.");
+
+		l_Size += SizeOfDecompressedData;
+	}
+
+	if (l_Size != Size)
+		throw std::runtime_error("Validated data decompressed to a different size than before.");
+
+	if (std::cout.good() == false)
+		throw std::runtime_error("An error occured while writing to the standard output.");
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "InflateContext.h"
+
+#include <istream>
+#include <string>
+#include <vector>
+
+// How the files found are written to the standard output, instead of to files of their own in the output folder.
+// Every frame starts with a line holding the path the file would have had in the output folder, such as "1000/52.gz", and the number of bytes that follow the line, separated by a space.
+enum class STANDARD_OUTPUT_MODE
+{
+	// Nothing is written to the standard output; the files are written to the output folder.
+	NONE,
+	// Every file as it was found, in a frame of its own.
+	FRAMED,
+	// Every GZIP member, or BGZF chain, as it was found, one right after the other, without frames; together, they make up a valid multi-member GZIP file. Files of the other formats are not written.
+	CONCATENATED,
+	// The decompressed data of every file, in a frame of its own.
+	INFLATED
+};
+
+// Switches the standard output to binary mode, so that the bytes written to it are not translated; to be called before anything is written to it.
+void PrepareStandardOutput();
+
+// Copies Size bytes, starting at StartPosition, from the input stream to the standard output, followed by the bytes of Trailer; in a frame named Name, unless Name is empty.
+void WriteCarvedDataToStandardOutput(std::istream& InputStream, std::streampos StartPosition, unsigned long long Size, const std::wstring& Name, const std::vector<unsigned char>& Trailer = {});
+
+// Decompresses the DEFLATE streams starting at DataPositions, one after the other, to the standard output, in a single frame named Name. Size is the number of bytes they were validated to decompress to, in all.
+void InflateToStandardOutput(INFLATE_CONTEXT& Context, std::istream& InputStream, const std::vector<std::streampos>& DataPositions, unsigned long long Size, const std::wstring& Name);
\ No newline at end of file
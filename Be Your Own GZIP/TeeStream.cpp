@@ -0,0 +1,178 @@
+#include "TeeStream.h"
+
+#include <algorithm>
+#include <cstring>
+
+TEE_STREAM_BUFFER::TEE_STREAM_BUFFER(std::streambuf& Source) : m_Source{ Source }, m_Buffer(m_BufferSize), m_BufferPosition{ 0 }, m_RecordedPosition{ 0 }, m_Recording{ false }
+{
+	// The source may have been read from already.
+	const auto Position{ m_Source.pubseekoff(0, std::ios_base::cur, std::ios_base::in) };
+	if (Position != pos_type(off_type(-1)))
+		m_BufferPosition = static_cast<unsigned long long>(static_cast<off_type>(Position));
+
+	setg(m_Buffer.data(), m_Buffer.data(), m_Buffer.data());
+}
+
+void TEE_STREAM_BUFFER::Record(const unsigned long long Position, const char* const Data, const size_t Length)
+{
+	if ((m_Recording == false) || (Length == 0))
+		return;
+
+	// Bytes past a gap cannot be added to the copy, and bytes already in it need not be.
+	const unsigned long long RecordedEnd{ m_RecordedPosition + m_Recorded.size() };
+	if (Position > RecordedEnd)
+	{
+		m_Recording = false;
+
+		return;
+	}
+	if (Position + Length <= RecordedEnd)
+		return;
+
+	const auto Skipped{ static_cast<size_t>(RecordedEnd - Position) };
+	const auto Count{ std::min(Length - Skipped, m_MaximumRecordedSize - m_Recorded.size()) };
+	const auto* const Begin{ reinterpret_cast<const unsigned char*>(Data) + Skipped };
+	m_Recorded.insert(m_Recorded.end(), Begin, Begin + Count);
+
+	if (m_Recorded.size() == m_MaximumRecordedSize)
+		m_Recording = false;
+}
+
+void TEE_STREAM_BUFFER::RecordBuffer()
+{
+	Record(m_BufferPosition, eback(), static_cast<size_t>(gptr() - eback()));
+}
+
+void TEE_STREAM_BUFFER::StartRecording()
+{
+	m_Recorded.clear();
+	m_RecordedPosition = m_BufferPosition + static_cast<unsigned long long>(gptr() - eback());
+	m_Recording = true;
+}
+
+const unsigned char* TEE_STREAM_BUFFER::GetRecorded(const unsigned long long Position, const unsigned long long Size)
+{
+	RecordBuffer();
+
+	if ((Position < m_RecordedPosition) || (Position - m_RecordedPosition + Size > m_Recorded.size()))
+		return nullptr;
+
+	return m_Recorded.data() + (Position - m_RecordedPosition);
+}
+
+TEE_STREAM_BUFFER::int_type TEE_STREAM_BUFFER::underflow()
+{
+	if (gptr() < egptr())
+		return traits_type::to_int_type(*gptr());
+
+	RecordBuffer();
+
+	const unsigned long long Position{ m_BufferPosition + static_cast<unsigned long long>(egptr() - eback()) };
+	const auto Length{ std::max<std::streamsize>(m_Source.sgetn(m_Buffer.data(), m_BufferSize), 0) };
+
+	m_BufferPosition = Position;
+	setg(m_Buffer.data(), m_Buffer.data(), m_Buffer.data() + Length);
+	if (Length == 0)
+		return traits_type::eof();
+
+	return traits_type::to_int_type(*gptr());
+}
+
+std::streamsize TEE_STREAM_BUFFER::xsgetn(char* const Data, const std::streamsize Count)
+{
+	std::streamsize Copied{ 0 };
+	while (Copied < Count)
+	{
+		if (gptr() == egptr())
+		{
+			// A large read, such as a chunk of the scan, goes straight from the source, rather than through the buffer.
+			if (Count - Copied >= static_cast<std::streamsize>(m_BufferSize))
+			{
+				RecordBuffer();
+
+				const unsigned long long Position{ m_BufferPosition + static_cast<unsigned long long>(egptr() - eback()) };
+				const auto Length{ m_Source.sgetn(Data + Copied, Count - Copied) };
+				if (Length <= 0)
+					break;
+
+				Record(Position, Data + Copied, static_cast<size_t>(Length));
+
+				m_BufferPosition = Position + static_cast<unsigned long long>(Length);
+				setg(m_Buffer.data(), m_Buffer.data(), m_Buffer.data());
+				Copied += Length;
+
+				continue;
+			}
+
+			if (traits_type::eq_int_type(underflow(), traits_type::eof()))
+				break;
+		}
+
+		const auto Length{ std::min<std::streamsize>(Count - Copied, egptr() - gptr()) };
+		std::memcpy(Data + Copied, gptr(), static_cast<size_t>(Length));
+		gbump(static_cast<int>(Length));
+		Copied += Length;
+	}
+
+	return Copied;
+}
+
+TEE_STREAM_BUFFER::pos_type TEE_STREAM_BUFFER::seekoff(const off_type Offset, const std::ios_base::seekdir Direction, const std::ios_base::openmode Which)
+{
+	if ((Which & std::ios_base::in) == 0)
+		return pos_type(off_type(-1));
+
+	switch (Direction)
+	{
+		case std::ios_base::beg:
+			return seekpos(pos_type(Offset), Which);
+		case std::ios_base::cur:
+			return seekpos(pos_type(static_cast<off_type>(m_BufferPosition) + (gptr() - eback()) + Offset), Which);
+		case std::ios_base::end:
+		default:
+		{
+			RecordBuffer();
+
+			const auto Position{ m_Source.pubseekoff(Offset, std::ios_base::end, std::ios_base::in) };
+			if (Position == pos_type(off_type(-1)))
+				return Position;
+
+			m_BufferPosition = static_cast<unsigned long long>(static_cast<off_type>(Position));
+			setg(m_Buffer.data(), m_Buffer.data(), m_Buffer.data());
+
+			return Position;
+		}
+	}
+}
+
+// A position within the buffer is served from it, without seeking in the source.
+TEE_STREAM_BUFFER::pos_type TEE_STREAM_BUFFER::seekpos(const pos_type Position, const std::ios_base::openmode Which)
+{
+	const auto Target{ static_cast<off_type>(Position) };
+	if (((Which & std::ios_base::in) == 0) || (Target < 0))
+		return pos_type(off_type(-1));
+
+	// Whatever was read up to here is kept, before the position moves away from it.
+	RecordBuffer();
+
+	const auto BufferedLength{ static_cast<unsigned long long>(egptr() - eback()) };
+	if ((static_cast<unsigned long long>(Target) >= m_BufferPosition) && (static_cast<unsigned long long>(Target) <= m_BufferPosition + BufferedLength))
+		setg(eback(), eback() + (static_cast<unsigned long long>(Target) - m_BufferPosition), egptr());
+	else
+	{
+		if (m_Source.pubseekpos(Position, std::ios_base::in) == pos_type(off_type(-1)))
+			return pos_type(off_type(-1));
+
+		m_BufferPosition = static_cast<unsigned long long>(Target);
+		setg(m_Buffer.data(), m_Buffer.data(), m_Buffer.data());
+	}
+
+	return Position;
+}
+
+const unsigned char* GetRecordedData(std::istream& InputStream, const unsigned long long Position, const unsigned long long Size)
+{
+	auto* const ptr_Tee{ dynamic_cast<TEE_STREAM_BUFFER*>(InputStream.rdbuf()) };
+
+	return (ptr_Tee != nullptr) ? ptr_Tee->GetRecorded(Position, Size) : nullptr;
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <istream>
+#include <streambuf>
+#include <vector>
+
+// A read-only stream buffer over another, which can keep a copy of the bytes read through it, so that a file that validates can be written out from memory, without reading it from the source a second time.
+// A copy is kept from the position recording starts at, for as long as the bytes are read without gaps, and up to m_MaximumRecordedSize bytes; a larger file is read again from the source, as ever.
+// Bytes are only added to the copy once they have been read, or the buffer holding them is about to be refilled, so that a candidate that is soon rejected costs next to nothing.
+class TEE_STREAM_BUFFER : public std::streambuf
+{
+	static constexpr size_t m_BufferSize{ 1 << 16 };
+	static constexpr size_t m_MaximumRecordedSize{ 1 << 26 };
+
+	std::streambuf& m_Source;
+	std::vector<char> m_Buffer;
+	// Where the data in the buffer starts in the source; the source itself is always right past the end of that data.
+	unsigned long long m_BufferPosition;
+
+	// The copy is kept in the same buffer from one file to the next, so that it is only allocated again for a larger file.
+	std::vector<unsigned char> m_Recorded;
+	unsigned long long m_RecordedPosition;
+	bool m_Recording;
+
+	void Record(unsigned long long Position, const char* Data, size_t Length);
+	// Adds the bytes of the buffer read so far to the copy.
+	void RecordBuffer();
+
+public:
+	TEE_STREAM_BUFFER() = delete;
+	explicit TEE_STREAM_BUFFER(std::streambuf& Source);
+
+	// Drops the copy kept so far, and starts keeping one from the current position.
+	void StartRecording();
+	// The copy of the Size bytes from Position on, if one was kept; nullptr otherwise.
+	const unsigned char* GetRecorded(unsigned long long Position, unsigned long long Size);
+
+protected:
+	int_type underflow() override;
+	std::streamsize xsgetn(char* Data, std::streamsize Count) override;
+	pos_type seekoff(off_type Offset, std::ios_base::seekdir Direction, std::ios_base::openmode Which = std::ios_base::in) override;
+	pos_type seekpos(pos_type Position, std::ios_base::openmode Which = std::ios_base::in) override;
+};
+
+// The copy of the Size bytes from Position on, if the stream reads through a TEE_STREAM_BUFFER that kept one; nullptr otherwise.
+const unsigned char* GetRecordedData(std::istream& InputStream, unsigned long long Position, unsigned long long Size);
\ No newline at end of file
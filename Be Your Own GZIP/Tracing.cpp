@@ -0,0 +1,175 @@
+#include "Tracing.h"
+
+#ifdef TRACING
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <stdexcept>
+
+static std::atomic<bool> TracingStarted{ false };
+static std::chrono::steady_clock::time_point TracingStartTime;
+static std::filesystem::path TracingFilePath;
+
+// Every buffer ever handed out, in the order they were created; the index of a buffer is the thread id it is written with.
+// A buffer goes back to the registry when its thread ends, so the short-lived threads of the parallel validator take turns with a few buffers, rather than each leaving one behind.
+static std::mutex RegistryMutex;
+static std::vector<std::unique_ptr<TRACING_BUFFER>> Buffers;
+
+class TRACING_BUFFER_LEASE
+{
+	TRACING_BUFFER* m_ptr_Buffer{ nullptr };
+
+public:
+	~TRACING_BUFFER_LEASE()
+	{
+		if (m_ptr_Buffer == nullptr)
+			return;
+
+		std::lock_guard Lock{ RegistryMutex };
+		m_ptr_Buffer->InUse = false;
+	}
+
+	TRACING_BUFFER& Get()
+	{
+		if (m_ptr_Buffer != nullptr)
+			return *m_ptr_Buffer;
+
+		std::lock_guard Lock{ RegistryMutex };
+		for (const auto& Buffer : Buffers)
+			if (Buffer->InUse == false)
+			{
+				m_ptr_Buffer = Buffer.get();
+
+				break;
+			}
+		if (m_ptr_Buffer == nullptr)
+			m_ptr_Buffer = Buffers.emplace_back(std::make_unique<TRACING_BUFFER>()).get();
+
+		m_ptr_Buffer->InUse = true;
+
+		return *m_ptr_Buffer;
+	}
+};
+
+static thread_local TRACING_BUFFER_LEASE ThreadBuffer;
+
+static unsigned long long GetTracingTime()
+{
+	return static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - TracingStartTime).count());
+}
+
+TRACING_BUFFER::TRACING_BUFFER() : Events(Capacity)
+{
+}
+
+void TRACING_BUFFER::Record(const TRACING_EVENT& Event)
+{
+	const auto l_Count{ Count.load(std::memory_order_relaxed) };
+	Events[l_Count % Capacity] = Event;
+	Count.store(l_Count + 1, std::memory_order_release);
+}
+
+TRACING_SPAN::TRACING_SPAN(const char* const Name) : m_Event{ Name, 0, 0, { nullptr, nullptr, nullptr }, { 0, 0, 0 } }, m_ArgumentCount{ 0 }, m_Recording{ TracingStarted.load(std::memory_order_relaxed) }
+{
+	if (m_Recording)
+		m_Event.Start = GetTracingTime();
+}
+
+TRACING_SPAN::~TRACING_SPAN()
+{
+	End();
+}
+
+void TRACING_SPAN::SetArgument(const char* const Name, const unsigned long long Value)
+{
+	if ((m_Recording == false) || (m_ArgumentCount == 3))
+		return;
+
+	m_Event.ArgumentNames[m_ArgumentCount] = Name;
+	m_Event.ArgumentValues[m_ArgumentCount] = Value;
+	++m_ArgumentCount;
+}
+
+void TRACING_SPAN::End()
+{
+	if (m_Recording == false)
+		return;
+
+	m_Recording = false;
+	m_Event.Duration = GetTracingTime() - m_Event.Start;
+	ThreadBuffer.Get().Record(m_Event);
+}
+
+void StartTracing(const std::filesystem::path& TraceFilePath)
+{
+	TracingFilePath = TraceFilePath;
+	TracingStartTime = std::chrono::steady_clock::now();
+	TracingStarted.store(true, std::memory_order_relaxed);
+}
+
+// Times are written in microseconds, as the format expects, down to the nanosecond.
+static void WriteTime(std::ostream& Stream, const unsigned long long Nanoseconds)
+{
+	Stream << (Nanoseconds / 1000) << '.' << std::setw(3) << std::setfill('0') << (Nanoseconds % 1000);
+}
+
+static void WriteTrace()
+{
+	std::ofstream Stream{ TracingFilePath, std::ios::binary | std::ios::trunc };
+	if (Stream.good() == false)
+		throw std::runtime_error("Could not create the trace file.");
+
+	Stream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+	std::lock_guard Lock{ RegistryMutex };
+	bool First{ true };
+	for (size_t ThreadId{ 0 }; ThreadId < Buffers.size(); ++ThreadId)
+	{
+		const auto& Buffer{ *Buffers[ThreadId] };
+		const auto Count{ Buffer.Count.load(std::memory_order_acquire) };
+		const auto Kept{ std::min<unsigned long long>(Count, TRACING_BUFFER::Capacity) };
+
+		// A thread whose oldest spans were overwritten says so in its name.
+		Stream << (First ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ThreadId << ",\"args\":{\"name\":\"thread " << ThreadId;
+		if (Count > Kept)
+			Stream << " (" << (Count - Kept) << " earlier spans dropped)";
+		Stream << "\"}}";
+		First = false;
+
+		for (auto Index{ Count - Kept }; Index < Count; ++Index)
+		{
+			const auto& Event{ Buffer.Events[Index % TRACING_BUFFER::Capacity] };
+
+			Stream << ",\n{\"name\":\"" << Event.Name << "\",\"cat\":\"scan\",\"ph\":\"X\",\"pid\":1,\"tid\":" << ThreadId << ",\"ts\":";
+			WriteTime(Stream, Event.Start);
+			Stream << ",\"dur\":";
+			WriteTime(Stream, Event.Duration);
+			Stream << ",\"args\":{";
+			for (int Argument{ 0 }; (Argument < 3) && (Event.ArgumentNames[Argument] != nullptr); ++Argument)
+				Stream << ((Argument > 0) ? "," : "") << '"' << Event.ArgumentNames[Argument] << "\":" << Event.ArgumentValues[Argument];
+			Stream << "}}";
+		}
+	}
+
+	Stream << "\n]}\n";
+
+	if (Stream.good() == false)
+		throw std::runtime_error("An error occured while writing the trace file.");
+}
+
+TRACING_SESSION::~TRACING_SESSION()
+{
+	if (TracingStarted.exchange(false) == false)
+		return;
+
+	// A destructor must not throw; a trace that could not be written is simply lost.
+	try
+	{
+		WriteTrace();
+	}
+	catch (...) {}
+}
+
+#endif
\ No newline at end of file
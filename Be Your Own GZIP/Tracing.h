@@ -0,0 +1,89 @@
+#pragma once
+
+// Tracing is compiled in only when TRACING is defined, as building with /p:Tracing=true does. Otherwise, the macros at the end expand to nothing, and their arguments are not evaluated, so tracing costs nothing at all.
+// A traced build records a span, with its start, duration and up to three numbers, for every piece of work marked with TRACE_SPAN, once --trace=PATH has been given; the spans are written to PATH at the end of the run, in the Trace Event Format that Perfetto and chrome://tracing load.
+#ifdef TRACING
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+struct TRACING_EVENT
+{
+	const char* Name;
+	// In nanoseconds, from the start of tracing.
+	unsigned long long Start;
+	unsigned long long Duration;
+	const char* ArgumentNames[3];
+	unsigned long long ArgumentValues[3];
+};
+
+// The spans recorded by one thread at a time, in a ring that keeps only the most recent ones once it is full.
+// Only the thread that holds the buffer writes to it, and it publishes each span by bumping the count, so recording a span takes no lock; the spans are only read once the threads have stopped recording.
+struct TRACING_BUFFER
+{
+	static constexpr size_t Capacity{ 1 << 16 };
+
+	std::vector<TRACING_EVENT> Events;
+	std::atomic<unsigned long long> Count{ 0 };
+	// Guarded by the mutex of the registry of buffers.
+	bool InUse{ false };
+
+	TRACING_BUFFER();
+
+	void Record(const TRACING_EVENT& Event);
+};
+
+// Marks the span of a piece of work, from its construction until it is ended, or destroyed; numbers describing the work can be attached to it until then.
+// The name and argument names must outlive the trace, as only pointers to them are kept: they are meant to be string literals.
+class TRACING_SPAN
+{
+	TRACING_EVENT m_Event;
+	int m_ArgumentCount;
+	bool m_Recording;
+
+public:
+	TRACING_SPAN() = delete;
+	explicit TRACING_SPAN(const char* Name);
+
+	~TRACING_SPAN();
+
+	TRACING_SPAN(const TRACING_SPAN&) = delete;
+	TRACING_SPAN& operator=(const TRACING_SPAN&) = delete;
+
+	// Arguments past the third are dropped.
+	void SetArgument(const char* Name, unsigned long long Value);
+	// Records the span, unless it has been recorded already.
+	void End();
+};
+
+// Writes the spans recorded during its lifetime to the path given to StartTracing, if any, when it is destroyed; meant to live as long as wmain.
+class TRACING_SESSION
+{
+public:
+	TRACING_SESSION() = default;
+
+	~TRACING_SESSION();
+
+	TRACING_SESSION(const TRACING_SESSION&) = delete;
+	TRACING_SESSION& operator=(const TRACING_SESSION&) = delete;
+};
+
+// Starts recording spans, to be written to TraceFilePath.
+void StartTracing(const std::filesystem::path& TraceFilePath);
+
+#define TRACE_SESSION(Session) TRACING_SESSION Session
+#define TRACE_SPAN(Span, Name) TRACING_SPAN Span{ Name }
+#define TRACE_ARGUMENT(Span, Name, Value) Span.SetArgument(Name, static_cast<unsigned long long>(Value))
+#define TRACE_END(Span) Span.End()
+
+#else
+
+#define TRACE_SESSION(Session)
+#define TRACE_SPAN(Span, Name)
+#define TRACE_ARGUMENT(Span, Name, Value)
+#define TRACE_END(Span)
+
+#endif
\ No newline at end of file
@@ -0,0 +1,95 @@
+#include "Verify.h"
+
+#include "Carving.h"
+#include "InflateContext.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Adds the files to check for a path: the path itself, or, for a folder, every file in it, subfolders included.
+static void CollectFiles(const std::filesystem::path& Path, std::vector<std::filesystem::path>& io_Files)
+{
+	std::error_code Error;
+	if (std::filesystem::is_directory(Path, Error) == false)
+	{
+		// A path that is neither a folder nor a file is reported as a file that failed, as it cannot be read.
+		io_Files.push_back(Path);
+
+		return;
+	}
+
+	for (const auto& Entry : std::filesystem::recursive_directory_iterator{ Path, std::filesystem::directory_options::skip_permission_denied, Error })
+		if (Entry.is_regular_file(Error))
+			io_Files.push_back(Entry.path());
+}
+
+unsigned long long VerifyFiles(const std::vector<std::filesystem::path>& Paths, const SCAN_OPTIONS& Options, const unsigned int Workers, std::wostream& Console, FINDINGS_REPORT& Report, const REPORT_FORMAT Format, const bool Quiet)
+{
+	std::vector<std::filesystem::path> Files;
+	for (const auto& Path : Paths)
+		CollectFiles(Path, Files);
+
+	const auto Processors{ std::max(1u, std::thread::hardware_concurrency()) };
+	const auto WorkerCount{ static_cast<unsigned int>(std::max<size_t>(1, std::min<size_t>((Workers > 0) ? Workers : Processors, Files.size()))) };
+
+	SCAN_OPTIONS FileOptions{ Options };
+	if (WorkerCount > 1)
+		FileOptions.Threads = 1;
+
+	std::atomic<size_t> NextFile{ 0 };
+	std::mutex OutputMutex;
+	unsigned long long FailedFiles{ 0 };
+
+	const auto RunWorker{ [&]()
+	{
+		INFLATE_CONTEXT Context;
+
+		for (auto Index{ NextFile.fetch_add(1) }; Index < Files.size(); Index = NextFile.fetch_add(1))
+		{
+			const auto& FilePath{ Files[Index] };
+
+			VERIFY_RESULT Result;
+			try
+			{
+				Result = VerifyGZIPFile(Context, FilePath, FileOptions);
+			}
+			catch (const std::exception& ex)
+			{
+				Result = {};
+				Result.Reason = GetExceptionMessage(ex);
+			}
+
+			std::lock_guard Lock{ OutputMutex };
+			if (Result.Valid == false)
+				++FailedFiles;
+
+			if (Format != REPORT_FORMAT::HUMAN)
+				Report.AddVerification(FilePath, Result);
+			else if (Result.Valid)
+			{
+				if (Quiet == false)
+					Console << L"OK       " << FilePath.wstring() << L"   (" << std::to_wstring(Result.Members) << ((Result.Members == 1) ? L" member)\n" : L" members)\n");
+			}
+			else
+				Console << L"FAILED   " << FilePath.wstring() << L"   at offset " << std::to_wstring(Result.FailedOffset) << L": " << Result.Reason << L"\n";
+		}
+	} };
+
+	std::vector<std::thread> Threads;
+	for (unsigned int i{ 1 }; i < WorkerCount; ++i)
+		Threads.emplace_back(RunWorker);
+	RunWorker();
+
+	for (auto& Thread : Threads)
+		Thread.join();
+
+	Report.Flush();
+
+	if (Format == REPORT_FORMAT::HUMAN)
+		Console << std::endl << L"Files checked: " << std::to_wstring(Files.size()) << L", of which valid: " << std::to_wstring(Files.size() - FailedFiles) << L", failed: " << std::to_wstring(FailedFiles) << std::endl;
+
+	return FailedFiles;
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "FindingsReport.h"
+#include "GZIP.h"
+
+#include <filesystem>
+#include <ostream>
+#include <vector>
+
+// Checks every file as GZIP members one right after the other, as gzip -t does, and reports whether each is valid, and if not, where and why it failed; nothing is written but the report. A folder stands for every file in it, subfolders included.
+// Up to Workers files are checked at the same time; 0 means one per processor. SCAN_OPTIONS::Threads only applies when a single file is checked at a time; otherwise, every member is validated with a single thread, as the files already keep the processors busy.
+// With REPORT_FORMAT::HUMAN, a line is written to the Console for every file, or, if Quiet is true, only for those that failed; otherwise, a record is added to the Report for every file. Returns the number of files that failed.
+unsigned long long VerifyFiles(const std::vector<std::filesystem::path>& Paths, const SCAN_OPTIONS& Options, unsigned int Workers, std::wostream& Console, FINDINGS_REPORT& Report, REPORT_FORMAT Format, bool Quiet);
\ No newline at end of file
@@ -0,0 +1,427 @@
+#include "Watch.h"
+
+#include "Carving.h"
+#include "FindingsReport.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#define NOMINMAX
+#include <Windows.h>
+
+// What is known of a watched file from its scans so far.
+struct WATCHED_FILE
+{
+	// The size of the file when it was last scanned, and the offset the next scan starts from.
+	unsigned long long ScannedSize{ 0 };
+	unsigned long long NextOffset{ 0 };
+	// The candidates that ran into the end of the file in the last scan; they are scanned, and reported, again once the file has grown.
+	std::set<unsigned long long> TruncatedPositions;
+	// The other candidates found in the file itself past the offset the next scan starts from; they are not reported again.
+	std::set<unsigned long long> ReportedPositions;
+	bool Scanning{ false };
+	// Set if the file was removed while it was being scanned, so that what the scan found is not kept.
+	bool Removed{ false };
+};
+
+// The files waiting to be scanned, and what is known of every file scanned so far. A file is only scanned by one worker at a time; if it changes while it is being scanned, it is scanned again afterwards.
+// Once every folder has stopped being watched, nothing more can be queued; the files already waiting are still handed out, and then the workers are let go.
+class WATCH_QUEUE
+{
+	const std::chrono::milliseconds m_Settle;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_Changed;
+	// The files waiting to be scanned, with when each of them last changed.
+	std::map<std::filesystem::path, std::chrono::steady_clock::time_point> m_Pending;
+	std::map<std::filesystem::path, WATCHED_FILE> m_Files;
+	// The number of folders still being watched.
+	size_t m_Watchers;
+
+public:
+	WATCH_QUEUE() = delete;
+	WATCH_QUEUE(const std::chrono::milliseconds Settle, const size_t Watchers) : m_Settle{ Settle }, m_Watchers{ Watchers } {}
+
+	// Called by every folder watcher as it stops.
+	void RemoveWatcher()
+	{
+		{
+			std::lock_guard Lock{ m_Mutex };
+			--m_Watchers;
+		}
+
+		m_Changed.notify_all();
+	}
+
+	void Push(const std::filesystem::path& FilePath)
+	{
+		{
+			std::lock_guard Lock{ m_Mutex };
+			m_Pending[FilePath] = std::chrono::steady_clock::now();
+		}
+
+		m_Changed.notify_one();
+	}
+
+	// Forgets a file that was removed or renamed, so that a new file by the same name is scanned in full.
+	void Forget(const std::filesystem::path& FilePath)
+	{
+		std::lock_guard Lock{ m_Mutex };
+		m_Pending.erase(FilePath);
+
+		const auto File{ m_Files.find(FilePath) };
+		if (File == m_Files.end())
+			return;
+
+		if (File->second.Scanning)
+			File->second.Removed = true;
+		else
+			m_Files.erase(File);
+	}
+
+	// Waits for a file that has gone unchanged for long enough, and is not being scanned already, and marks it as being scanned until it is handed back to Done.
+	// Returns false once no folder is watched any longer, and no file is waiting.
+	bool Pop(std::filesystem::path& out_FilePath, WATCHED_FILE& out_State)
+	{
+		std::unique_lock Lock{ m_Mutex };
+		for (;;)
+		{
+			if ((m_Watchers == 0) && m_Pending.empty())
+				return false;
+
+			const auto Now{ std::chrono::steady_clock::now() };
+			auto Earliest{ std::chrono::steady_clock::time_point::max() };
+			for (auto Pending{ m_Pending.begin() }; Pending != m_Pending.end(); ++Pending)
+			{
+				auto& State{ m_Files[Pending->first] };
+				if (State.Scanning)
+					continue;
+
+				const auto Ready{ Pending->second + m_Settle };
+				if (Ready <= Now)
+				{
+					out_FilePath = Pending->first;
+					m_Pending.erase(Pending);
+
+					State.Scanning = true;
+					out_State = State;
+
+					return true;
+				}
+
+				Earliest = std::min(Earliest, Ready);
+			}
+
+			if (Earliest == std::chrono::steady_clock::time_point::max())
+				m_Changed.wait(Lock);
+			else
+				m_Changed.wait_until(Lock, Earliest);
+		}
+	}
+
+	void Done(const std::filesystem::path& FilePath, const WATCHED_FILE& State)
+	{
+		{
+			std::lock_guard Lock{ m_Mutex };
+			auto& l_State{ m_Files[FilePath] };
+			if (l_State.Removed)
+				m_Files.erase(FilePath);
+			else
+			{
+				l_State = State;
+				l_State.Scanning = false;
+			}
+		}
+
+		// Another change to the file may have been waiting for this scan to end.
+		m_Changed.notify_all();
+	}
+};
+
+// Where the records of the scans go: to the standard output, shared by every worker, or to a spool folder, in a file for every scan that found anything.
+class RECORD_OUTPUT
+{
+	const std::filesystem::path m_SpoolFolder_Path;
+	std::mutex m_Mutex;
+
+public:
+	RECORD_OUTPUT() = delete;
+	explicit RECORD_OUTPUT(const std::filesystem::path& SpoolFolder_Path) : m_SpoolFolder_Path{ SpoolFolder_Path } {}
+
+	// Writes the records of the scan of the bytes from Start to End of a file.
+	void Write(const std::filesystem::path& FilePath, const unsigned long long Start, const unsigned long long End, const std::wstring& Records)
+	{
+		if (Records.empty())
+			return;
+
+		if (m_SpoolFolder_Path.empty())
+		{
+			std::lock_guard Lock{ m_Mutex };
+			std::wcout << Records;
+			std::wcout.flush();
+
+			return;
+		}
+
+		// Whatever picks up the spool files never sees one half-written.
+		ReplaceFile(m_SpoolFolder_Path / (FilePath.filename().wstring() + L"." + std::to_wstring(Start) + L"-" + std::to_wstring(End) + L".ndjson"), ConvertToUTF8(Records));
+	}
+
+	void Log(const std::wstring& Text)
+	{
+		std::lock_guard Lock{ m_Mutex };
+		std::wcerr << Text << std::endl;
+	}
+};
+
+// Writes the records of a scan of a watched file, but for those already written by its previous scan, and notes the candidates that ran into the end of the file.
+class WATCHED_FILE_SINK : public FINDINGS_SINK
+{
+	const std::filesystem::path& m_FilePath;
+	const WATCHED_FILE& m_Previous;
+	FINDINGS_REPORT m_Report;
+	// Whether the last candidate found in the file itself was reported by the previous scan, along with the files nested in it.
+	bool m_ReportedBefore;
+
+public:
+	std::set<unsigned long long> TruncatedPositions;
+	std::set<unsigned long long> ReportedPositions;
+
+	WATCHED_FILE_SINK() = delete;
+	WATCHED_FILE_SINK(const std::filesystem::path& FilePath, const WATCHED_FILE& Previous, std::wostream& Records) : m_FilePath{ FilePath }, m_Previous{ Previous }, m_Report{ Records, REPORT_FORMAT::NDJSON }, m_ReportedBefore{ false } {}
+
+	void AddFinding(const FINDINGS& Finding) override
+	{
+		// The files nested in a candidate are found right after it, and only a candidate in the file itself can run into its end.
+		if (Finding.Container.empty())
+		{
+			if (Finding.Truncated)
+				TruncatedPositions.insert(Finding.Position);
+			else
+				ReportedPositions.insert(Finding.Position);
+
+			// Only what the previous scan reported is left out.
+			m_ReportedBefore = m_Previous.ReportedPositions.contains(Finding.Position);
+		}
+
+		if (m_ReportedBefore == false)
+			m_Report.AddFinding(m_FilePath, Finding, GetSignatureFormatName(Finding.Format));
+	}
+
+	void Flush()
+	{
+		m_Report.Flush();
+	}
+};
+
+// Scans what was written to a file since its previous scan, if anything, and updates what is known of it.
+static void ScanChanges(INFLATE_CONTEXT& Context, const std::filesystem::path& FilePath, WATCHED_FILE& io_State, const SCAN_OPTIONS& Options, const WATCH_OPTIONS& WatchOptions, RECORD_OUTPUT& Output)
+{
+	std::error_code Error;
+	if (std::filesystem::is_regular_file(FilePath, Error) == false)
+		return;
+
+	// The records written to the spool folder are not scanned themselves.
+	if ((WatchOptions.SpoolFolder_Path.empty() == false) && std::filesystem::equivalent(FilePath.parent_path(), WatchOptions.SpoolFolder_Path, Error))
+		return;
+
+	const auto FileSize{ std::filesystem::file_size(FilePath, Error) };
+	if (Error)
+		return;
+
+	// A file that got smaller was replaced, rather than appended to; and a file that was only written to in place is not scanned again.
+	if (FileSize < io_State.ScannedSize)
+		io_State = {};
+	if (FileSize == io_State.ScannedSize)
+		return;
+
+	const auto OutputFolder_Path{ (WatchOptions.SpoolFolder_Path.empty() ? FilePath.parent_path() : WatchOptions.SpoolFolder_Path) / (FilePath.filename().wstring() + L"_GZIP") };
+	// Whatever was extracted past the start of this scan, by the previous scan or before the watch started, is extracted again.
+	DiscardOutput(OutputFolder_Path, io_State.NextOffset);
+
+	SCAN_OPTIONS ScanOptions{ Options };
+	ScanOptions.Offset = io_State.NextOffset;
+	ScanOptions.Length = FileSize - io_State.NextOffset;
+	ScanOptions.ProgressInterval = 0;
+	ScanOptions.CheckpointInterval = 0;
+	ScanOptions.Resume = false;
+
+	std::wostringstream Records;
+	WATCHED_FILE_SINK Sink{ FilePath, io_State, Records };
+	ExtractGZIPs(Context, FilePath, OutputFolder_Path, Sink, ScanOptions);
+	Sink.Flush();
+
+	Output.Write(FilePath, io_State.NextOffset, FileSize, Records.str());
+
+	// The next scan starts early enough to find a signature that was only partly written, and any candidate that ran into the end of the file.
+	io_State.ScannedSize = FileSize;
+	io_State.NextOffset = FileSize - std::min<unsigned long long>(FileSize, SIGNATURE_MAXIMUM_LENGTH - 1);
+	if (Sink.TruncatedPositions.empty() == false)
+		io_State.NextOffset = std::min(io_State.NextOffset, *Sink.TruncatedPositions.begin());
+	io_State.TruncatedPositions = std::move(Sink.TruncatedPositions);
+	Sink.ReportedPositions.erase(Sink.ReportedPositions.begin(), Sink.ReportedPositions.lower_bound(io_State.NextOffset));
+	io_State.ReportedPositions = std::move(Sink.ReportedPositions);
+}
+
+static void RunWorker(WATCH_QUEUE& Queue, const SCAN_OPTIONS& Options, const WATCH_OPTIONS& WatchOptions, RECORD_OUTPUT& Output)
+{
+	// A worker keeps its decoder context from one scan to the next.
+	INFLATE_CONTEXT Context;
+
+	for (;;)
+	{
+		std::filesystem::path FilePath;
+		WATCHED_FILE State;
+		if (Queue.Pop(FilePath, State) == false)
+			return;
+
+		try
+		{
+			ScanChanges(Context, FilePath, State, Options, WatchOptions, Output);
+		}
+		catch (const std::exception& ex)
+		{
+			Output.Log(L"An error occured while scanning a file:\n   " + FilePath.wstring() + L"\n" + GetExceptionMessage(ex));
+		}
+
+		Queue.Done(FilePath, State);
+	}
+}
+
+// Queues every file already in the folder.
+static void QueueFolder(const std::filesystem::path& Folder_Path, WATCH_QUEUE& Queue)
+{
+	std::error_code Error;
+	for (const auto& Entry : std::filesystem::directory_iterator{ Folder_Path, Error })
+		if (Entry.is_regular_file(Error))
+			Queue.Push(Entry.path());
+}
+
+// A folder being watched.
+struct FOLDER_WATCH
+{
+	HANDLE Handle{ INVALID_HANDLE_VALUE };
+	OVERLAPPED Overlapped{};
+	// The notifications are DWORD-aligned.
+	std::vector<DWORD> Buffer;
+};
+
+static bool ReadChanges(FOLDER_WATCH& Watch)
+{
+	return ReadDirectoryChangesW(Watch.Handle, Watch.Buffer.data(), static_cast<DWORD>(Watch.Buffer.size() * sizeof(DWORD)), FALSE, FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE, nullptr, &Watch.Overlapped, nullptr) != FALSE;
+}
+
+// Issues the first read of the changes to the folder, from which on every change is collected.
+static bool StartWatch(const std::filesystem::path& Folder_Path, FOLDER_WATCH& out_Watch)
+{
+	out_Watch.Handle = CreateFileW(Folder_Path.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+	if (out_Watch.Handle == INVALID_HANDLE_VALUE)
+		return false;
+
+	out_Watch.Overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+	out_Watch.Buffer.resize(1 << 14);
+	if ((out_Watch.Overlapped.hEvent != nullptr) && ReadChanges(out_Watch))
+		return true;
+
+	if (out_Watch.Overlapped.hEvent != nullptr)
+		CloseHandle(out_Watch.Overlapped.hEvent);
+	CloseHandle(out_Watch.Handle);
+
+	return false;
+}
+
+// Queues every file of the folder that is added, renamed or written to, for as long as the folder can be watched.
+static void WatchFolder(const std::filesystem::path& Folder_Path, FOLDER_WATCH& Watch, WATCH_QUEUE& Queue, RECORD_OUTPUT& Output)
+{
+	for (;;)
+	{
+		DWORD BytesReturned{ 0 };
+		if (GetOverlappedResult(Watch.Handle, &Watch.Overlapped, &BytesReturned, TRUE) == FALSE)
+			break;
+
+		// If more changes came than the buffer could hold, there is no telling which files they were to; every file is looked at again, which only costs a scan of those that grew.
+		if (BytesReturned == 0)
+			QueueFolder(Folder_Path, Queue);
+		else
+		{
+			auto ptr_Notification{ reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(Watch.Buffer.data()) };
+			for (;;)
+			{
+				const auto FilePath{ Folder_Path / std::wstring{ ptr_Notification->FileName, ptr_Notification->FileNameLength / sizeof(wchar_t) } };
+				if ((ptr_Notification->Action == FILE_ACTION_REMOVED) || (ptr_Notification->Action == FILE_ACTION_RENAMED_OLD_NAME))
+					Queue.Forget(FilePath);
+				else
+					Queue.Push(FilePath);
+
+				if (ptr_Notification->NextEntryOffset == 0)
+					break;
+
+				ptr_Notification = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(reinterpret_cast<const unsigned char*>(ptr_Notification) + ptr_Notification->NextEntryOffset);
+			}
+		}
+
+		if (ReadChanges(Watch) == false)
+			break;
+	}
+
+	Output.Log(L"Stopped watching a folder:\n   " + Folder_Path.wstring());
+
+	CloseHandle(Watch.Overlapped.hEvent);
+	CloseHandle(Watch.Handle);
+}
+
+static void RunWatcher(const std::filesystem::path& Folder_Path, FOLDER_WATCH& Watch, WATCH_QUEUE& Queue, RECORD_OUTPUT& Output)
+{
+	WatchFolder(Folder_Path, Watch, Queue, Output);
+	Queue.RemoveWatcher();
+}
+
+void WatchFolders(const std::vector<std::filesystem::path>& Folders, const SCAN_OPTIONS& Options, const WATCH_OPTIONS& WatchOptions)
+{
+	WATCH_QUEUE Queue{ std::chrono::milliseconds{ WatchOptions.SettleMilliseconds }, Folders.size() };
+	RECORD_OUTPUT Output{ WatchOptions.SpoolFolder_Path };
+
+	if (WatchOptions.SpoolFolder_Path.empty() == false)
+		std::filesystem::create_directories(WatchOptions.SpoolFolder_Path);
+
+	// The folders are watched before the files already in them are queued, so that no file written in between is missed.
+	std::vector<FOLDER_WATCH> Watches(Folders.size());
+	std::vector<std::thread> Threads;
+	for (size_t i{ 0 }; i < Folders.size(); ++i)
+	{
+		if (StartWatch(Folders[i], Watches[i]))
+			Threads.emplace_back(RunWatcher, std::cref(Folders[i]), std::ref(Watches[i]), std::ref(Queue), std::ref(Output));
+		else
+		{
+			Output.Log(L"Could not watch a folder:\n   " + Folders[i].wstring());
+			Queue.RemoveWatcher();
+		}
+	}
+
+	for (const auto& Folder_Path : Folders)
+		QueueFolder(Folder_Path, Queue);
+
+	const auto WorkerCount{ (WatchOptions.Workers > 0) ? WatchOptions.Workers : std::max(1u, std::thread::hardware_concurrency()) };
+
+	// Members are not validated in parallel within files that are themselves scanned in parallel.
+	SCAN_OPTIONS WorkerOptions{ Options };
+	if (WorkerCount > 1)
+		WorkerOptions.Threads = 1;
+
+	for (unsigned int i{ 0 }; i < WorkerCount; ++i)
+		Threads.emplace_back(RunWorker, std::ref(Queue), std::cref(WorkerOptions), std::cref(WatchOptions), std::ref(Output));
+
+	for (auto& Thread : Threads)
+		Thread.join();
+
+	// The workers only return once every folder has stopped being watched.
+	throw PrepareException(L"None of the folders can be watched any longer.");
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "GZIP.h"
+
+#include <filesystem>
+#include <vector>
+
+struct WATCH_OPTIONS
+{
+	// If Watch is true, the paths given are folders to watch, rather than files to scan.
+	bool Watch = false;
+	// The number of files scanned at the same time; 0 means one per processor.
+	unsigned int Workers = 0;
+	// How long a file has to go unchanged before it is scanned, so that a file being written to is not scanned again after every write.
+	unsigned int SettleMilliseconds = 500;
+	// If SpoolFolder_Path is not empty, the records of every scan are written to a file of their own in that folder, and the files found are extracted there; otherwise, the records are written to the standard output, and the files are extracted next to the files scanned, as ever.
+	std::filesystem::path SpoolFolder_Path;
+};
+
+// Scans every file in the folders, and then watches them for files being added or written to, scanning each as it changes, until the process is ended. Subfolders are not watched.
+// If every folder stops being watched, such as when they are all removed, the files already waiting are scanned, and then it throws.
+// A file is only scanned past where its previous scan ended, less any candidate that ran into the end of the file back then, so that a file that is being appended to is not scanned in full every time; a file that gets smaller is taken to have been replaced, and is scanned in full again.
+// The findings are written as NDJSON records, as they are with --output=ndjson.
+void WatchFolders(const std::vector<std::filesystem::path>& Folders, const SCAN_OPTIONS& Options, const WATCH_OPTIONS& WatchOptions);
\ No newline at end of file
@@ -0,0 +1,65 @@
+#include "WorkerThreads.h"
+
+WORKER_THREADS::WORKER_THREADS() : m_ptr_Task{ nullptr }, m_Count{ 0 }, m_Pending{ 0 }, m_Round{ 0 }, m_Stopping{ false }
+{
+}
+
+WORKER_THREADS::~WORKER_THREADS()
+{
+	{
+		std::lock_guard Lock{ m_Mutex };
+		m_Stopping = true;
+	}
+	m_WorkReady.notify_all();
+
+	for (auto& Thread : m_Threads)
+		Thread.join();
+}
+
+// A thread is given the round that was current when it was started, so that it waits for the next one, even if it only gets to wait after that one was posted.
+void WORKER_THREADS::RunThread(const unsigned int Index, unsigned long long Round)
+{
+	std::unique_lock Lock{ m_Mutex };
+	for (;;)
+	{
+		m_WorkReady.wait(Lock, [&] { return m_Stopping || (m_Round != Round); });
+		if (m_Stopping)
+			return;
+
+		Round = m_Round;
+		if (Index >= m_Count)
+			continue;
+
+		const auto& Task{ *m_ptr_Task };
+		Lock.unlock();
+		Task(Index);
+		Lock.lock();
+
+		if (--m_Pending == 0)
+			m_WorkDone.notify_one();
+	}
+}
+
+void WORKER_THREADS::Run(const unsigned int Count, const std::function<void(unsigned int)>& Task)
+{
+	if (Count == 0)
+		return;
+
+	{
+		std::lock_guard Lock{ m_Mutex };
+
+		while (m_Threads.size() + 1 < Count)
+			m_Threads.emplace_back(&WORKER_THREADS::RunThread, this, static_cast<unsigned int>(m_Threads.size() + 1), m_Round);
+
+		m_ptr_Task = &Task;
+		m_Count = Count;
+		m_Pending = Count - 1;
+		++m_Round;
+	}
+	m_WorkReady.notify_all();
+
+	Task(0);
+
+	std::unique_lock Lock{ m_Mutex };
+	m_WorkDone.wait(Lock, [this] { return m_Pending == 0; });
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Threads that are started once, and then kept waiting for work, so that work split into many short rounds does not start and join threads for every round. They are stopped when the object is destroyed.
+class WORKER_THREADS
+{
+	std::mutex m_Mutex;
+	std::condition_variable m_WorkReady;
+	std::condition_variable m_WorkDone;
+	std::vector<std::thread> m_Threads;
+
+	// The work of the current round, and the number of threads that have yet to finish their share of it.
+	const std::function<void(unsigned int)>* m_ptr_Task;
+	unsigned int m_Count;
+	unsigned int m_Pending;
+	unsigned long long m_Round;
+	bool m_Stopping;
+
+	void RunThread(unsigned int Index, unsigned long long Round);
+
+public:
+	WORKER_THREADS();
+	~WORKER_THREADS();
+
+	WORKER_THREADS(const WORKER_THREADS&) = delete;
+	WORKER_THREADS& operator=(const WORKER_THREADS&) = delete;
+
+	// Calls Task with every index from 0 to Count - 1 at the same time, each from a thread of its own, and returns once all the calls have returned; the calling thread takes index 0. Threads are only started when more are needed than were before.
+	// Task must not throw.
+	void Run(unsigned int Count, const std::function<void(unsigned int)>& Task);
+};
\ No newline at end of file
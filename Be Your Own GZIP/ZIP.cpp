@@ -0,0 +1,470 @@
+#include "ZIP.h"
+
+#include "Carving.h"
+#include "CRC.h"
+#include "DEFLATE.h"
+#include "Tracing.h"
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+constexpr unsigned long long ZIP_DataDescriptorSignature{ 0x08074B50 };
+constexpr unsigned long long ZIP_CentralDirectorySignature{ 0x02014B50 };
+constexpr unsigned long long ZIP_EndOfCentralDirectorySignature{ 0x06054B50 };
+constexpr unsigned long long ZIP64_EndOfCentralDirectorySignature{ 0x06064B50 };
+constexpr unsigned long long ZIP64_EndOfCentralDirectoryLocatorSignature{ 0x07064B50 };
+
+// The ID of the extra field holding the 64-bit sizes and offsets of a ZIP64 entry.
+constexpr unsigned long long ZIP64_ExtraFieldID{ 0x0001 };
+// A 32-bit size or offset holding this value is recorded in the ZIP64 extra field instead.
+constexpr unsigned long long ZIP64_Placeholder{ 0xFFFFFFFF };
+// Version 4.5 of the specification introduced ZIP64.
+constexpr unsigned long long ZIP64_VersionNeeded{ 45 };
+
+// General purpose flags.
+constexpr unsigned long long ZIP_FlagEncrypted{ 1 << 0 };
+constexpr unsigned long long ZIP_FlagDataDescriptor{ 1 << 3 };
+constexpr unsigned long long ZIP_FlagStrongEncryption{ 1 << 6 };
+constexpr unsigned long long ZIP_FlagMaskedLocalHeader{ 1 << 13 };
+
+struct ZIP_ENTRY
+{
+	unsigned long long VersionNeeded{ 0 };
+	unsigned long long Flags{ 0 };
+	unsigned long long CompressionMethod{ 0 };
+	unsigned long long LastModifiedTime{ 0 };
+	unsigned long long LastModifiedDate{ 0 };
+	unsigned long long CRC32{ 0 };
+	unsigned long long CompressedSize{ 0 };
+	unsigned long long UncompressedSize{ 0 };
+	std::vector<unsigned char> FileName;
+	std::vector<unsigned char> ExtraField;
+	// Set if the extra field holds a ZIP64 subfield, in which case the sizes in a data descriptor are 8 bytes long.
+	bool ZIP64{ false };
+};
+
+static unsigned long long GetLittleEndianValue(const unsigned char* const Data, const int ByteCount)
+{
+	unsigned long long Value{ 0 };
+	for (int i{ 0 }; i < ByteCount; ++i)
+		Value |= static_cast<unsigned long long>(Data[i]) << (8 * i);
+
+	return Value;
+}
+
+static void AppendLittleEndianValue(std::vector<unsigned char>& Data, const unsigned long long Value, const int ByteCount)
+{
+	for (int i{ 0 }; i < ByteCount; ++i)
+		Data.push_back(static_cast<unsigned char>(Value >> (8 * i)));
+}
+
+// Reads the local file header, starting right after the first two bytes of its signature.
+static bool ReadLocalFileHeader(std::istream& InputStream, unsigned long long& io_Size, ZIP_ENTRY& out_Entry)
+{
+	// The rest of the signature, followed by the fixed-size fields.
+	std::array<unsigned char, 28> Header;
+	InputStream.read(reinterpret_cast<char*>(Header.data()), Header.size());
+	if (InputStream.gcount() != static_cast<std::streamsize>(Header.size()))
+		return false;
+
+	io_Size += Header.size();
+
+	out_Entry.VersionNeeded = GetLittleEndianValue(&Header[2], 2);
+	out_Entry.Flags = GetLittleEndianValue(&Header[4], 2);
+	out_Entry.CompressionMethod = GetLittleEndianValue(&Header[6], 2);
+	out_Entry.LastModifiedTime = GetLittleEndianValue(&Header[8], 2);
+	out_Entry.LastModifiedDate = GetLittleEndianValue(&Header[10], 2);
+	out_Entry.CRC32 = GetLittleEndianValue(&Header[12], 4);
+	out_Entry.CompressedSize = GetLittleEndianValue(&Header[16], 4);
+	out_Entry.UncompressedSize = GetLittleEndianValue(&Header[20], 4);
+	const auto FileNameLength{ static_cast<size_t>(GetLittleEndianValue(&Header[24], 2)) };
+	const auto ExtraFieldLength{ static_cast<size_t>(GetLittleEndianValue(&Header[26], 2)) };
+
+	// The data of encrypted entries cannot be validated, and neither can entries compressed with anything but DEFLATE.
+	if (out_Entry.Flags & (ZIP_FlagEncrypted | ZIP_FlagStrongEncryption | ZIP_FlagMaskedLocalHeader))
+		return false;
+
+	switch (out_Entry.CompressionMethod)
+	{
+		case 0:// Stored
+		case 8:// DEFLATE
+			break;
+		default:
+			return false;
+	}
+
+	// Read the file name and the extra field.
+	out_Entry.FileName.resize(FileNameLength);
+	out_Entry.ExtraField.resize(ExtraFieldLength);
+	for (auto* Field : { &out_Entry.FileName, &out_Entry.ExtraField })
+		if (Field->empty() == false)
+		{
+			InputStream.read(reinterpret_cast<char*>(Field->data()), Field->size());
+			if (InputStream.gcount() != static_cast<std::streamsize>(Field->size()))
+				return false;
+
+			io_Size += Field->size();
+		}
+
+	// Walk the subfields, looking for the ZIP64 one. It holds, in this order, the uncompressed and the compressed size, each only if the header field holds the placeholder instead.
+	for (size_t SubfieldStart{ 0 }; SubfieldStart < ExtraFieldLength; )
+	{
+		if (ExtraFieldLength - SubfieldStart < 4)
+			return false;
+
+		const auto ID{ GetLittleEndianValue(&out_Entry.ExtraField[SubfieldStart], 2) };
+		const auto SubfieldLength{ static_cast<size_t>(GetLittleEndianValue(&out_Entry.ExtraField[SubfieldStart + 2], 2)) };
+		SubfieldStart += 4;
+
+		if (SubfieldLength > ExtraFieldLength - SubfieldStart)
+			return false;
+
+		if (ID == ZIP64_ExtraFieldID)
+		{
+			out_Entry.ZIP64 = true;
+
+			size_t ValueStart{ SubfieldStart };
+			for (auto* Size : { &out_Entry.UncompressedSize, &out_Entry.CompressedSize })
+				if (*Size == ZIP64_Placeholder)
+				{
+					if (SubfieldStart + SubfieldLength - ValueStart < 8)
+						return false;
+
+					*Size = GetLittleEndianValue(&out_Entry.ExtraField[ValueStart], 8);
+					ValueStart += 8;
+				}
+		}
+
+		SubfieldStart += SubfieldLength;
+	}
+
+	return true;
+}
+
+// Reads the data descriptor that follows the data of an entry. It may or may not start with a signature, and its sizes may be 4 or 8 bytes long; the first layout whose values match the data is the one used.
+static bool ReadDataDescriptor(std::istream& InputStream, const SCAN_OPTIONS& Options, unsigned long long& io_Size, const ZIP_ENTRY& Entry, const unsigned long long CRC32ofData, const unsigned long long SizeOfData, const unsigned long long SizeOfDecompressedData)
+{
+	const auto DescriptorPosition{ InputStream.tellg() };
+
+	// The longest layout: signature, CRC32, and two 8-byte sizes.
+	std::array<unsigned char, 24> Descriptor{};
+	InputStream.read(reinterpret_cast<char*>(Descriptor.data()), Descriptor.size());
+	const auto Available{ static_cast<size_t>(InputStream.gcount()) };
+
+	for (const bool WithSignature : { true, false })
+		for (const int SizeLength : { Entry.ZIP64 ? 8 : 4, Entry.ZIP64 ? 4 : 8 })
+		{
+			const size_t SignatureLength{ WithSignature ? size_t{ 4 } : size_t{ 0 } };
+			const size_t DescriptorLength{ SignatureLength + 4 + 2 * SizeLength };
+			if (DescriptorLength > Available)
+				continue;
+
+			if (WithSignature && (GetLittleEndianValue(&Descriptor[0], 4) != ZIP_DataDescriptorSignature))
+				continue;
+
+			const auto RecordedCRC32{ GetLittleEndianValue(&Descriptor[SignatureLength], 4) };
+			const auto RecordedCompressedSize{ GetLittleEndianValue(&Descriptor[SignatureLength + 4], SizeLength) };
+			const auto RecordedUncompressedSize{ GetLittleEndianValue(&Descriptor[SignatureLength + 4 + SizeLength], SizeLength) };
+
+			if ((Options.ValidationLevel == VALIDATION_LEVEL::FULL) && (RecordedCRC32 != CRC32ofData))
+				continue;
+
+			if ((RecordedCompressedSize != SizeOfData) || (RecordedUncompressedSize != SizeOfDecompressedData))
+				continue;
+
+			// Leave the stream right after the descriptor.
+			InputStream.clear();
+			InputStream.seekg(DescriptorPosition + static_cast<std::streamoff>(DescriptorLength));
+			if (InputStream.good() == false)
+				throw std::runtime_error("An error occured while reading the binary.");
+
+			io_Size += DescriptorLength;
+
+			return true;
+		}
+
+	return false;
+}
+
+// Amount of stored data read at a time.
+constexpr size_t StoredDataBlockSize{ 1 << 16 };
+
+// Stored data is its own decompressed data, so only its size counts against the budget.
+static void CheckStoredDataBudget(const SCAN_OPTIONS& Options, const unsigned long long SizeOfData)
+{
+	if (Options.Budget.IsExceeded(SizeOfData, SizeOfData))
+		throw VALIDATION_BUDGET_EXCEPTION("The stored data went past the validation budget.");
+}
+
+// Stored data followed by a data descriptor has no recorded size, so its end can only be found by looking for the signature of the descriptor, and checking that the sizes and CRC32 recorded after it match the data before it.
+// The data is read a block at a time; each block starts with the last three bytes of the one before, so that a signature split between two blocks is still found.
+static bool FindStoredDataEnd(std::istream& InputStream, const SCAN_OPTIONS& Options, unsigned long long& io_Size, const ZIP_ENTRY& Entry, unsigned long long& out_SizeOfData, unsigned long long& out_CRC32ofData)
+{
+	const auto DataPosition{ InputStream.tellg() };
+
+	CRC32 Checksum;
+	// How much of the data has been added to the checksum so far.
+	unsigned long long ChecksumLength{ 0 };
+
+	std::vector<unsigned char> Block(StoredDataBlockSize);
+	unsigned long long BlockPosition{ 0 };
+	for (;;)
+	{
+		InputStream.clear();
+		InputStream.seekg(DataPosition + static_cast<std::streamoff>(BlockPosition));
+		if (InputStream.good() == false)
+			throw std::runtime_error("An error occured while reading the binary.");
+
+		InputStream.read(reinterpret_cast<char*>(Block.data()), Block.size());
+		const auto BlockLength{ static_cast<size_t>(InputStream.gcount()) };
+		const bool LastBlock{ BlockLength < Block.size() };
+
+		for (size_t i{ 0 }; i + 4 <= BlockLength; ++i)
+		{
+			if ((Block[i] != 0x50) || (GetLittleEndianValue(&Block[i], 4) != ZIP_DataDescriptorSignature))
+				continue;
+
+			const auto SizeOfData{ BlockPosition + i };
+			CheckStoredDataBudget(Options, SizeOfData);
+
+			Checksum.AddBytes(&Block[static_cast<size_t>(ChecksumLength - BlockPosition)], static_cast<size_t>(SizeOfData - ChecksumLength));
+			ChecksumLength = SizeOfData;
+
+			InputStream.clear();
+			InputStream.seekg(DataPosition + static_cast<std::streamoff>(SizeOfData));
+			if (InputStream.good() == false)
+				throw std::runtime_error("An error occured while reading the binary.");
+
+			unsigned long long DescriptorSize{ 0 };
+			if (ReadDataDescriptor(InputStream, Options, DescriptorSize, Entry, Checksum.GetChecksum(), SizeOfData, SizeOfData))
+			{
+				io_Size += SizeOfData + DescriptorSize;
+				out_SizeOfData = SizeOfData;
+				out_CRC32ofData = Checksum.GetChecksum();
+
+				return true;
+			}
+		}
+
+		if (LastBlock)
+		{
+			// The data ran out before a descriptor was found; the repositioning above cleared the end-of-file state the read left.
+			InputStream.setstate(std::ios::eofbit);
+
+			return false;
+		}
+
+		const auto NextBlockPosition{ BlockPosition + BlockLength - 3 };
+		Checksum.AddBytes(&Block[static_cast<size_t>(ChecksumLength - BlockPosition)], static_cast<size_t>(NextBlockPosition - ChecksumLength));
+		ChecksumLength = NextBlockPosition;
+		BlockPosition = NextBlockPosition;
+
+		CheckStoredDataBudget(Options, BlockPosition);
+	}
+}
+
+// Builds the central directory and the end of central directory record of an archive holding only the given entry, which starts at the beginning of the archive and is EntrySize bytes long.
+static std::vector<unsigned char> BuildCentralDirectory(const ZIP_ENTRY& Entry, const unsigned long long EntrySize)
+{
+	const bool ZIP64Sizes{ (Entry.CompressedSize >= ZIP64_Placeholder) || (Entry.UncompressedSize >= ZIP64_Placeholder) };
+	const bool ZIP64Offset{ EntrySize >= ZIP64_Placeholder };
+
+	// The extra field of the local header, minus its ZIP64 subfield; a new one is added if the sizes need it.
+	std::vector<unsigned char> ExtraField;
+	for (size_t SubfieldStart{ 0 }; SubfieldStart + 4 <= Entry.ExtraField.size(); )
+	{
+		const auto SubfieldEnd{ SubfieldStart + 4 + static_cast<size_t>(GetLittleEndianValue(&Entry.ExtraField[SubfieldStart + 2], 2)) };
+		if (GetLittleEndianValue(&Entry.ExtraField[SubfieldStart], 2) != ZIP64_ExtraFieldID)
+			ExtraField.insert(ExtraField.end(), Entry.ExtraField.begin() + SubfieldStart, Entry.ExtraField.begin() + SubfieldEnd);
+
+		SubfieldStart = SubfieldEnd;
+	}
+
+	if (ZIP64Sizes)
+	{
+		AppendLittleEndianValue(ExtraField, ZIP64_ExtraFieldID, 2);
+		AppendLittleEndianValue(ExtraField, 16, 2);
+		AppendLittleEndianValue(ExtraField, Entry.UncompressedSize, 8);
+		AppendLittleEndianValue(ExtraField, Entry.CompressedSize, 8);
+	}
+
+	const unsigned long long VersionNeeded{ ZIP64Sizes ? std::max(Entry.VersionNeeded, ZIP64_VersionNeeded) : Entry.VersionNeeded };
+
+	std::vector<unsigned char> CentralDirectory;
+	AppendLittleEndianValue(CentralDirectory, ZIP_CentralDirectorySignature, 4);
+	AppendLittleEndianValue(CentralDirectory, VersionNeeded, 2);// Version made by
+	AppendLittleEndianValue(CentralDirectory, VersionNeeded, 2);
+	AppendLittleEndianValue(CentralDirectory, Entry.Flags, 2);
+	AppendLittleEndianValue(CentralDirectory, Entry.CompressionMethod, 2);
+	AppendLittleEndianValue(CentralDirectory, Entry.LastModifiedTime, 2);
+	AppendLittleEndianValue(CentralDirectory, Entry.LastModifiedDate, 2);
+	AppendLittleEndianValue(CentralDirectory, Entry.CRC32, 4);
+	AppendLittleEndianValue(CentralDirectory, ZIP64Sizes ? ZIP64_Placeholder : Entry.CompressedSize, 4);
+	AppendLittleEndianValue(CentralDirectory, ZIP64Sizes ? ZIP64_Placeholder : Entry.UncompressedSize, 4);
+	AppendLittleEndianValue(CentralDirectory, Entry.FileName.size(), 2);
+	AppendLittleEndianValue(CentralDirectory, ExtraField.size(), 2);
+	AppendLittleEndianValue(CentralDirectory, 0, 2);// File comment length
+	AppendLittleEndianValue(CentralDirectory, 0, 2);// Disk number start
+	AppendLittleEndianValue(CentralDirectory, 0, 2);// Internal file attributes
+	AppendLittleEndianValue(CentralDirectory, 0, 4);// External file attributes
+	AppendLittleEndianValue(CentralDirectory, 0, 4);// Offset of the local header
+	CentralDirectory.insert(CentralDirectory.end(), Entry.FileName.begin(), Entry.FileName.end());
+	CentralDirectory.insert(CentralDirectory.end(), ExtraField.begin(), ExtraField.end());
+
+	const unsigned long long CentralDirectorySize{ CentralDirectory.size() };
+
+	// If the central directory starts too far into the archive for a 32-bit offset, the offset goes in a ZIP64 end of central directory record instead.
+	if (ZIP64Offset)
+	{
+		const unsigned long long RecordOffset{ EntrySize + CentralDirectorySize };
+
+		AppendLittleEndianValue(CentralDirectory, ZIP64_EndOfCentralDirectorySignature, 4);
+		AppendLittleEndianValue(CentralDirectory, 44, 8);// Size of the rest of the record
+		AppendLittleEndianValue(CentralDirectory, ZIP64_VersionNeeded, 2);// Version made by
+		AppendLittleEndianValue(CentralDirectory, ZIP64_VersionNeeded, 2);
+		AppendLittleEndianValue(CentralDirectory, 0, 4);// Number of this disk
+		AppendLittleEndianValue(CentralDirectory, 0, 4);// Disk where the central directory starts
+		AppendLittleEndianValue(CentralDirectory, 1, 8);// Entries on this disk
+		AppendLittleEndianValue(CentralDirectory, 1, 8);// Total entries
+		AppendLittleEndianValue(CentralDirectory, CentralDirectorySize, 8);
+		AppendLittleEndianValue(CentralDirectory, EntrySize, 8);
+
+		AppendLittleEndianValue(CentralDirectory, ZIP64_EndOfCentralDirectoryLocatorSignature, 4);
+		AppendLittleEndianValue(CentralDirectory, 0, 4);// Disk where the ZIP64 record is
+		AppendLittleEndianValue(CentralDirectory, RecordOffset, 8);
+		AppendLittleEndianValue(CentralDirectory, 1, 4);// Total number of disks
+	}
+
+	AppendLittleEndianValue(CentralDirectory, ZIP_EndOfCentralDirectorySignature, 4);
+	AppendLittleEndianValue(CentralDirectory, 0, 2);// Number of this disk
+	AppendLittleEndianValue(CentralDirectory, 0, 2);// Disk where the central directory starts
+	AppendLittleEndianValue(CentralDirectory, 1, 2);// Entries on this disk
+	AppendLittleEndianValue(CentralDirectory, 1, 2);// Total entries
+	AppendLittleEndianValue(CentralDirectory, CentralDirectorySize, 4);
+	AppendLittleEndianValue(CentralDirectory, ZIP64Offset ? ZIP64_Placeholder : EntrySize, 4);
+	AppendLittleEndianValue(CentralDirectory, 0, 2);// Comment length
+
+	return CentralDirectory;
+}
+
+bool ExtractZIPEntry(INFLATE_CONTEXT& Context, std::istream& InputStream, const std::filesystem::path& OutputFilePath, const SCAN_OPTIONS& Options, unsigned long long& out_Size, FINDINGS& Findings)
+{
+	const auto StartPosition{ InputStream.tellg() - std::streamoff{ 2 } };
+	unsigned long long l_Size{ 0 };
+
+	ZIP_ENTRY Entry;
+	{
+		TRACE_SPAN(HeaderSpan, "ZIP local header");
+		if (ReadLocalFileHeader(InputStream, l_Size, Entry) == false)
+			return false;
+	}
+
+	const bool DataDescriptor{ (Entry.Flags & ZIP_FlagDataDescriptor) != 0 };
+
+	// Header has now been confirmed to be valid.
+	Findings.ValidHeader = true;
+	const auto DataPosition{ InputStream.tellg() };
+
+	// Validate the data, and the sizes and CRC32 recorded for it, either in the header or in the data descriptor that follows the data.
+	switch (Entry.CompressionMethod)
+	{
+		case 8:
+		{
+			if (InputStream.peek() == std::char_traits<char>::eof())
+				return false;
+
+			unsigned long long SizeOfData{ 0 };
+			unsigned long long SizeOfDecompressedData;
+			unsigned long long CRC32ofDecompressedData;
+			if (ValidateDEFLATEdata(Context, InputStream, SizeOfData, SizeOfDecompressedData, CRC32ofDecompressedData, Options.ValidationLevel, CHECKSUM_TYPE::CRC32, Options.Threads, Options.Budget) == false)
+				return false;
+
+			l_Size += SizeOfData;
+
+			if (DataDescriptor)
+			{
+				if (ReadDataDescriptor(InputStream, Options, l_Size, Entry, CRC32ofDecompressedData, SizeOfData, SizeOfDecompressedData) == false)
+					return false;
+
+				Entry.CRC32 = CRC32ofDecompressedData;
+				Entry.CompressedSize = SizeOfData;
+				Entry.UncompressedSize = SizeOfDecompressedData;
+			}
+			else
+			{
+				if ((Options.ValidationLevel == VALIDATION_LEVEL::FULL) && (Entry.CRC32 != CRC32ofDecompressedData))
+					return false;
+
+				if ((Entry.CompressedSize != SizeOfData) || (Entry.UncompressedSize != SizeOfDecompressedData))
+					return false;
+			}
+
+			break;
+		}
+		case 0:
+		default:
+		{
+			if (DataDescriptor)
+			{
+				unsigned long long SizeOfData, CRC32ofData;
+				if (FindStoredDataEnd(InputStream, Options, l_Size, Entry, SizeOfData, CRC32ofData) == false)
+					return false;
+
+				Entry.CRC32 = CRC32ofData;
+				Entry.CompressedSize = SizeOfData;
+				Entry.UncompressedSize = SizeOfData;
+			}
+			else
+			{
+				if (Entry.CompressedSize != Entry.UncompressedSize)
+					return false;
+
+				CheckStoredDataBudget(Options, Entry.CompressedSize);
+
+				CRC32 Checksum;
+				std::vector<unsigned char> Block(static_cast<size_t>(std::min<unsigned long long>(Entry.CompressedSize, StoredDataBlockSize)));
+				for (unsigned long long Remaining{ Entry.CompressedSize }; Remaining > 0;)
+				{
+					const auto BlockLength{ static_cast<size_t>(std::min<unsigned long long>(Remaining, Block.size())) };
+					InputStream.read(reinterpret_cast<char*>(Block.data()), BlockLength);
+					if (static_cast<size_t>(InputStream.gcount()) != BlockLength)
+						return false;
+
+					Checksum.AddBytes(Block.data(), BlockLength);
+					Remaining -= BlockLength;
+				}
+
+				if ((Options.ValidationLevel == VALIDATION_LEVEL::FULL) && (Entry.CRC32 != Checksum.GetChecksum()))
+					return false;
+
+				l_Size += Entry.CompressedSize;
+			}
+		}
+	}
+
+	// The entire entry has now been validated.
+	Findings.ValidFile = true;
+
+	// Ouput the found entry to a file, or to the standard output, followed by a central directory listing only that entry; a ZIP entry has no place among concatenated GZIP members.
+	out_Size = l_Size;
+	switch (Options.StandardOutput)
+	{
+		case STANDARD_OUTPUT_MODE::NONE:
+			WriteCarvedData(InputStream, StartPosition, 2 + l_Size, OutputFilePath, BuildCentralDirectory(Entry, 2 + l_Size));
+			break;
+		case STANDARD_OUTPUT_MODE::FRAMED:
+			WriteCarvedDataToStandardOutput(InputStream, StartPosition, 2 + l_Size, Findings.GetPath() + OutputFilePath.extension().wstring(), BuildCentralDirectory(Entry, 2 + l_Size));
+			break;
+		case STANDARD_OUTPUT_MODE::CONCATENATED:
+			break;
+		case STANDARD_OUTPUT_MODE::INFLATED:
+			// The data of a stored entry is its decompressed data.
+			if (Entry.CompressionMethod == 8)
+				InflateToStandardOutput(Context, InputStream, { DataPosition }, Entry.UncompressedSize, Findings.GetPath() + OutputFilePath.extension().wstring());
+			else
+				WriteCarvedDataToStandardOutput(InputStream, DataPosition, Entry.CompressedSize, Findings.GetPath() + OutputFilePath.extension().wstring());
+	}
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "GZIP.h"
+#include "InflateContext.h"
+
+#include <istream>
+
+// Validates a ZIP entry whose local file header signature has been matched by the signature scan, with the stream positioned right after the first two bytes of that signature, and extracts it to a file, as an archive holding only that entry.
+// On success, out_Size is the size of the entry, data descriptor included, not counting the first two bytes of the signature.
+bool ExtractZIPEntry(INFLATE_CONTEXT& Context, std::istream& InputStream, const std::filesystem::path& OutputFilePath, const SCAN_OPTIONS& Options, unsigned long long& out_Size, FINDINGS& Findings);
\ No newline at end of file
@@ -0,0 +1,54 @@
+#include "ZLIB.h"
+
+#include "Carving.h"
+#include "DEFLATE.h"
+
+bool ExtractZLIB(INFLATE_CONTEXT& Context, std::istream& InputStream, const std::filesystem::path& OutputFilePath, const SCAN_OPTIONS& Options, unsigned long long& out_Size, FINDINGS& Findings)
+{
+	const auto StartPosition{ InputStream.tellg() - std::streamoff{ 2 } };
+	unsigned long long l_Size{ 0 };
+
+	// The signature scan only matches CMF and FLG pairs that select DEFLATE with a 32 KiB window, have a valid FCHECK, and do not require a preset dictionary; so the header is valid.
+	Findings.ValidHeader = true;
+
+	// Make sure there is at least one byte of the compressed data.
+	if (InputStream.peek() == std::char_traits<char>::eof())
+		return false;
+
+	// Validate the compressed data, and the Adler-32 checksum that follows it.
+	unsigned long long SizeOfDecompressedData;
+	{
+		unsigned long long Adler32ofDecompressedData;
+
+		if (ValidateDEFLATEdata(Context, InputStream, l_Size, SizeOfDecompressedData, Adler32ofDecompressedData, Options.ValidationLevel, CHECKSUM_TYPE::ADLER32, 1, Options.Budget) == false)
+			return false;
+
+		unsigned long long RecordedAdler32;
+		if ((Read4BigEndianByteValue(InputStream, l_Size, RecordedAdler32)) == false)
+			return false;
+
+		if ((Options.ValidationLevel == VALIDATION_LEVEL::FULL) && (RecordedAdler32 != Adler32ofDecompressedData))
+			return false;
+	}
+
+	// The entire stream has now been validated.
+	Findings.ValidFile = true;
+
+	// Ouput the found ZLIB data to a file, or to the standard output; a ZLIB stream has no place among concatenated GZIP members.
+	out_Size = l_Size;
+	switch (Options.StandardOutput)
+	{
+		case STANDARD_OUTPUT_MODE::NONE:
+			WriteCarvedData(InputStream, StartPosition, 2 + l_Size, OutputFilePath);
+			break;
+		case STANDARD_OUTPUT_MODE::FRAMED:
+			WriteCarvedDataToStandardOutput(InputStream, StartPosition, 2 + l_Size, Findings.GetPath() + OutputFilePath.extension().wstring());
+			break;
+		case STANDARD_OUTPUT_MODE::CONCATENATED:
+			break;
+		case STANDARD_OUTPUT_MODE::INFLATED:
+			InflateToStandardOutput(Context, InputStream, { StartPosition + std::streamoff{ 2 } }, SizeOfDecompressedData, Findings.GetPath() + OutputFilePath.extension().wstring());
+	}
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "GZIP.h"
+#include "InflateContext.h"
+
+#include <istream>
+
+// Validates a ZLIB stream whose 2-byte header has already been matched by the signature scan, with the stream positioned right after that header, and extracts it to a file.
+// On success, out_Size is the size of the stream, not counting the header.
+bool ExtractZLIB(INFLATE_CONTEXT& Context, std::istream& InputStream, const std::filesystem::path& OutputFilePath, const SCAN_OPTIONS& Options, unsigned long long& out_Size, FINDINGS& Findings);
\ No newline at end of file
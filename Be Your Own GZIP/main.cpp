@@ -1,6 +1,18 @@
+#include "Benchmark.h"
+#include "Carving.h"
+#include "Checkpoint.h"
+#include "CPUDispatch.h"
+#include "FindingsReport.h"
+#include "FindingsSummary.h"
 #include "GZIP.h"
+#include "InputSource.h"
+#include "Tracing.h"
+#include "Verify.h"
+#include "Watch.h"
 
+#include <algorithm>
 #include <iostream>
+#include <string_view>
 
 #define WIN32_LEAN_AND_MEAN
 #define VC_EXTRALEAN
@@ -8,57 +20,527 @@
 
 const wchar_t* const APPLICATION_VERSION{ L"1.0" };
 
-void DisplayError(std::exception& ex) noexcept
+void DisplayError(std::wostream& Console, std::exception& ex) noexcept
 {
 	try
 	{
-		std::wstring wmsg;
-		wmsg.resize(MultiByteToWideChar(CP_UTF8, NULL, ex.what(), -1, NULL, 0));
-		MultiByteToWideChar(CP_UTF8, NULL, ex.what(), -1, wmsg.data(), static_cast<int>(wmsg.size()));
-		std::wcout << wmsg << std::endl << std::endl;
+		Console << GetExceptionMessage(ex) << std::endl << std::endl;
 	}
 	catch (...) {}
 }
 
+struct FORMAT_TEXT
+{
+	SIGNATURE_FORMAT Format;
+	const wchar_t* Occurrences;
+};
+
+constexpr FORMAT_TEXT FORMAT_TEXTS[SIGNATURE_FORMAT_COUNT]
+{
+	{ SIGNATURE_FORMAT::GZIP, L"Occurrences of the magic word 0x1F 8B found in the file: " },
+	{ SIGNATURE_FORMAT::ZLIB, L"Occurrences of a ZLIB header (0x78 01, 5E, 9C or DA) found in the file: " },
+	{ SIGNATURE_FORMAT::ZIP, L"Occurrences of a ZIP local file header (PK 0x03 04) found in the file: " },
+	{ SIGNATURE_FORMAT::BASE64, L"Occurrences of the start of a GZIP in base64 text (H4sI) found in the file: " }
+};
+
+// Displays the statistics and addresses for the findings of a single format; in quiet mode, only the statistics.
+static void DisplayFindings(std::wostream& Console, const FORMAT_SUMMARY& Summary, const FORMAT_TEXT& Text, const bool Quiet)
+{
+	const auto Name{ GetSignatureFormatName(Text.Format) };
+
+	Console << Text.Occurrences << std::to_wstring(Summary.Occurrences) << L"\n";
+	if (Summary.Occurrences > 0)
+	{
+		Console << L"   Of those, found to be part of a valid " << Name << L" header: " << std::to_wstring(Summary.HeadersFound) << L"\n";
+
+		if (Summary.HeadersFound > 0)
+		{
+			if (Quiet == false)
+			{
+				Console << L"      At these addresses:\n";
+
+				for (const auto Position : Summary.HeaderPositions)
+					Console << L"      " << std::setw(20) << std::dec << Position << std::hex << L"   (" << Position << L")\n";
+			}
+
+			if (Summary.CandidatesFiltered > 0)
+				Console << L"         Of those, passed over for not meeting the filters: " << std::to_wstring(Summary.CandidatesFiltered) << L"\n";
+
+			if (Summary.FilesFound > 0)
+			{
+				Console << L"         Of those, found to be part of a valid " << Name << L" file and extracted: " << std::to_wstring(Summary.FilesFound) << L"\n";
+				if (Summary.FilesDuplicated > 0)
+					Console << L"            Of those, identical to one extracted before, and only listed in the manifest of duplicates: " << std::to_wstring(Summary.FilesDuplicated) << L"\n";
+				if (Summary.BGZFChainsFound > 0)
+				{
+					Console << L"            Of those, BGZF files extracted as a whole: " << std::to_wstring(Summary.BGZFChainsFound) << L" (" << std::to_wstring(Summary.BGZFBlocksFound) << L" BGZF blocks)\n";
+					if (Summary.BGZFChainsTruncated > 0)
+						Console << L"               Of those, missing the BGZF end-of-file marker: " << std::to_wstring(Summary.BGZFChainsTruncated) << L"\n";
+				}
+			}
+			else
+				Console << L"         Of those, none were found to be part of a valid " << Name << L" file.\n";
+
+			if (Summary.FilesRecovered > 0)
+				Console << L"         Of those, found to be damaged, and partly recovered: " << std::to_wstring(Summary.FilesRecovered) << L"\n";
+		}
+
+		if (Summary.CandidatesAborted > 0)
+		{
+			Console << L"   Of those, abandoned for going past the validation budget, and worth revisiting with larger limits: " << std::to_wstring(Summary.CandidatesAborted) << L"\n";
+
+			if (Quiet == false)
+			{
+				Console << L"      At these addresses:\n";
+
+				for (const auto Position : Summary.AbortedPositions)
+					Console << L"      " << std::setw(20) << std::dec << Position << std::hex << L"   (" << Position << L")\n";
+			}
+		}
+	}
+
+	if (Summary.NestedFilesFound > 0)
+	{
+		Console << L"Valid " << Name << L" files found nested in the decompressed data of other files, and extracted: " << std::to_wstring(Summary.NestedFilesFound) << L"\n";
+
+		if (Quiet == false)
+		{
+			Console << L"   At these paths:\n";
+
+			for (const auto& Path : Summary.NestedFilePaths)
+				Console << L"      " << Path << L"\n";
+		}
+	}
+}
+
+// Sums up the findings for a file, and passes them on to the report as they come, if records are displayed.
+class DISPLAYED_FINDINGS : public FINDINGS_SINK
+{
+	const std::filesystem::path& m_FilePath;
+	FINDINGS_REPORT* const m_ptr_Report;
+
+public:
+	FINDINGS_SUMMARY Summary;
+
+	DISPLAYED_FINDINGS(const std::filesystem::path& FilePath, FINDINGS_REPORT* const ptr_Report, const bool KeepHeaderPositions) : m_FilePath{ FilePath }, m_ptr_Report{ ptr_Report }, Summary{ KeepHeaderPositions } {}
+
+	void AddFinding(const FINDINGS& Finding) override
+	{
+		Summary.AddFinding(Finding);
+
+		if (m_ptr_Report != nullptr)
+			m_ptr_Report->AddFinding(m_FilePath, Finding, GetSignatureFormatName(Finding.Format));
+	}
+
+	// Records already written cannot be taken back, so only the summary is saved.
+	void SaveState(std::ostream& Stream) const override
+	{
+		Summary.SaveState(Stream);
+	}
+
+	bool LoadState(std::istream& Stream) override
+	{
+		return Summary.LoadState(Stream);
+	}
+};
+
+// How the findings are displayed.
+struct DISPLAY_OPTIONS
+{
+	// With REPORT_FORMAT::CSV or NDJSON, a record for every finding is written to the standard output, and everything else goes to the standard error stream.
+	REPORT_FORMAT Format = REPORT_FORMAT::HUMAN;
+	// If Quiet is true, no addresses or records are displayed, only the statistics.
+	bool Quiet = false;
+};
+
+// Reads a size given in bytes, or in KiB, MiB or GiB with a K, M or G suffix. Returns false if the text is not such a size, or the size is 0.
+static bool ParseSize(std::wstring_view Text, unsigned long long& out_Size)
+{
+	unsigned int Shift{ 0 };
+	if (Text.empty() == false)
+	{
+		switch (Text.back())
+		{
+			case L'K':
+			{
+				Shift = 10;
+
+				break;
+			}
+			case L'M':
+			{
+				Shift = 20;
+
+				break;
+			}
+			case L'G':
+			{
+				Shift = 30;
+
+				break;
+			}
+		}
+	}
+
+	if (Shift > 0)
+		Text.remove_suffix(1);
+
+	if ((Text.empty()) || (Text.find_first_not_of(L"0123456789") != std::wstring_view::npos) || (Text.size() > 12))
+		return false;
+
+	out_Size = std::stoull(std::wstring{ Text }) << Shift;
+
+	return out_Size > 0;
+}
+
+// Applies a single command line option to the scan or display options. Returns false if the option is not recognized.
+static bool ParseOption(const std::wstring_view Option, SCAN_OPTIONS& Options, DISPLAY_OPTIONS& DisplayOptions, WATCH_OPTIONS& WatchOptions, bool& Verify, bool& Benchmark)
+{
+	if (Option == L"--validation=structural")
+		Options.ValidationLevel = VALIDATION_LEVEL::STRUCTURAL;
+	else if (Option == L"--validation=full")
+		Options.ValidationLevel = VALIDATION_LEVEL::FULL;
+	else if (Option.starts_with(L"--formats="))
+	{
+		// A comma-separated list of format names.
+		unsigned int Formats{ 0 };
+		for (auto List{ Option.substr(std::wstring_view{ L"--formats=" }.size()) }; List.empty() == false; )
+		{
+			const auto Separator{ List.find(L',') };
+			const auto Name{ List.substr(0, Separator) };
+
+			bool Known{ false };
+			for (const auto& Text : FORMAT_TEXTS)
+				if (_wcsicmp(std::wstring{ Name }.c_str(), GetSignatureFormatName(Text.Format)) == 0)
+				{
+					Formats |= SignatureFormatBit(Text.Format);
+					Known = true;
+				}
+
+			if (Known == false)
+				return false;
+
+			List = (Separator == std::wstring_view::npos) ? std::wstring_view{} : List.substr(Separator + 1);
+		}
+
+		if (Formats == 0)
+			return false;
+
+		Options.Formats = Formats;
+	}
+	else if (Option == L"--base64")
+		Options.Formats |= SignatureFormatBit(SIGNATURE_FORMAT::BASE64);
+	else if (Option == L"--recover")
+		Options.Recover = true;
+	else if (Option == L"--dedup")
+		Options.Deduplicate = true;
+	else if (Option == L"--output=human")
+		DisplayOptions.Format = REPORT_FORMAT::HUMAN;
+	else if (Option == L"--output=csv")
+		DisplayOptions.Format = REPORT_FORMAT::CSV;
+	else if (Option == L"--output=ndjson")
+		DisplayOptions.Format = REPORT_FORMAT::NDJSON;
+	else if (Option == L"--quiet")
+		DisplayOptions.Quiet = true;
+	else if ((Option == L"--stdout") || (Option == L"--stdout=framed"))
+		Options.StandardOutput = STANDARD_OUTPUT_MODE::FRAMED;
+	else if (Option == L"--stdout=concat")
+		Options.StandardOutput = STANDARD_OUTPUT_MODE::CONCATENATED;
+	else if (Option == L"--stdout=inflated")
+		Options.StandardOutput = STANDARD_OUTPUT_MODE::INFLATED;
+	else if (Option == L"--watch")
+		WatchOptions.Watch = true;
+	else if (Option == L"--verify")
+		Verify = true;
+	else if (Option == L"--benchmark")
+		Benchmark = true;
+	else if (Option.starts_with(L"--force-isa="))
+	{
+		// An instruction set the processor does not support is refused, rather than left to crash the first kernel that uses it.
+		INSTRUCTION_SET InstructionSet;
+		if (ParseInstructionSetName(Option.substr(std::wstring_view{ L"--force-isa=" }.size()), InstructionSet) == false)
+			return false;
+
+		return ForceInstructionSet(InstructionSet);
+	}
+	else if (Option.starts_with(L"--workers="))
+	{
+		const std::wstring Count{ Option.substr(std::wstring_view{ L"--workers=" }.size()) };
+		if ((Count.empty()) || (Count.find_first_not_of(L"0123456789") != std::wstring::npos) || (Count.size() > 4))
+			return false;
+
+		WatchOptions.Workers = static_cast<unsigned int>(std::stoul(Count));
+	}
+	else if (Option.starts_with(L"--spool="))
+	{
+		const auto Path{ Option.substr(std::wstring_view{ L"--spool=" }.size()) };
+		if (Path.empty())
+			return false;
+
+		WatchOptions.SpoolFolder_Path = Path;
+	}
+	else if (Option.starts_with(L"--threads="))
+	{
+		const std::wstring Count{ Option.substr(std::wstring_view{ L"--threads=" }.size()) };
+		if ((Count.empty()) || (Count.find_first_not_of(L"0123456789") != std::wstring::npos) || (Count.size() > 4))
+			return false;
+
+		Options.Threads = static_cast<unsigned int>(std::stoul(Count));
+	}
+	else if (Option.starts_with(L"--offset="))
+	{
+		// Unlike the other sizes, an offset may be 0.
+		const auto Offset{ Option.substr(std::wstring_view{ L"--offset=" }.size()) };
+		if (Offset == L"0")
+			Options.Offset = 0;
+		else
+			return ParseSize(Offset, Options.Offset);
+	}
+	else if (Option.starts_with(L"--length="))
+		return ParseSize(Option.substr(std::wstring_view{ L"--length=" }.size()), Options.Length);
+	else if (Option.starts_with(L"--max-compressed="))
+		return ParseSize(Option.substr(std::wstring_view{ L"--max-compressed=" }.size()), Options.Budget.MaximumCompressedSize);
+	else if (Option.starts_with(L"--max-decompressed="))
+		return ParseSize(Option.substr(std::wstring_view{ L"--max-decompressed=" }.size()), Options.Budget.MaximumDecompressedSize);
+	else if (Option.starts_with(L"--max-ratio="))
+		return ParseSize(Option.substr(std::wstring_view{ L"--max-ratio=" }.size()), Options.Budget.MaximumExpansionRatio);
+	else if (Option.starts_with(L"--max-header-string="))
+		return ParseSize(Option.substr(std::wstring_view{ L"--max-header-string=" }.size()), Options.Budget.MaximumHeaderStringLength);
+	else if (Option.starts_with(L"--name="))
+	{
+		// The file name in a GZIP header is in ISO 8859-1, whose characters are the first 256 of Unicode.
+		const auto Pattern{ Option.substr(std::wstring_view{ L"--name=" }.size()) };
+		if (Pattern.empty() || std::any_of(Pattern.begin(), Pattern.end(), [](const wchar_t Character) { return Character > 0xFF; }))
+			return false;
+
+		Options.Filter.NamePattern.assign(Pattern.begin(), Pattern.end());
+	}
+	else if (Option.starts_with(L"--mtime="))
+	{
+		// A range of times, in seconds since 1970, either end of which may be left out, such as 1700000000-.
+		const std::wstring Range{ Option.substr(std::wstring_view{ L"--mtime=" }.size()) };
+		const auto Separator{ Range.find(L'-') };
+		if ((Separator == std::wstring::npos) || (Range.size() == 1) || (Range.size() > 21) || (Range.find_first_not_of(L"0123456789-") != std::wstring::npos) || (Range.find(L'-', Separator + 1) != std::wstring::npos))
+			return false;
+
+		if (Separator > 0)
+			Options.Filter.MinimumTime = std::stoull(Range.substr(0, Separator));
+		if (Separator + 1 < Range.size())
+			Options.Filter.MaximumTime = std::stoull(Range.substr(Separator + 1));
+	}
+	else if (Option.starts_with(L"--os="))
+	{
+		const std::wstring Value{ Option.substr(std::wstring_view{ L"--os=" }.size()) };
+		if ((Value.empty()) || (Value.find_first_not_of(L"0123456789") != std::wstring::npos) || (Value.size() > 3) || (std::stoul(Value) > 255))
+			return false;
+
+		Options.Filter.OperatingSystem = static_cast<int>(std::stoul(Value));
+	}
+	else if (Option.starts_with(L"--min-size="))
+		return ParseSize(Option.substr(std::wstring_view{ L"--min-size=" }.size()), Options.Filter.MinimumSize);
+	else if (Option == L"--recursive")
+		Options.RecursionDepth = 3;
+	else if (Option.starts_with(L"--recursive="))
+	{
+		const std::wstring Depth{ Option.substr(std::wstring_view{ L"--recursive=" }.size()) };
+		if ((Depth.empty()) || (Depth.find_first_not_of(L"0123456789") != std::wstring::npos) || (Depth.size() > 2))
+			return false;
+
+		Options.RecursionDepth = static_cast<unsigned int>(std::stoul(Depth));
+	}
+	else if (Option.starts_with(L"--checkpoint="))
+	{
+		const std::wstring Interval{ Option.substr(std::wstring_view{ L"--checkpoint=" }.size()) };
+		if ((Interval.empty()) || (Interval.find_first_not_of(L"0123456789") != std::wstring::npos) || (Interval.size() > 5))
+			return false;
+
+		Options.CheckpointInterval = static_cast<unsigned int>(std::stoul(Interval));
+	}
+	else if (Option == L"--resume")
+		Options.Resume = true;
+	else if (Option == L"--progress")
+		Options.ProgressInterval = 5;
+	else if (Option.starts_with(L"--progress="))
+	{
+		const std::wstring Interval{ Option.substr(std::wstring_view{ L"--progress=" }.size()) };
+		if ((Interval.empty()) || (Interval.find_first_not_of(L"0123456789") != std::wstring::npos) || (Interval.size() > 5) || (std::stoul(Interval) == 0))
+			return false;
+
+		Options.ProgressInterval = static_cast<unsigned int>(std::stoul(Interval));
+	}
+	else if (Option.starts_with(L"--status-file="))
+	{
+		const auto Path{ Option.substr(std::wstring_view{ L"--status-file=" }.size()) };
+		if (Path.empty())
+			return false;
+
+		Options.StatusFilePath = Path;
+		if (Options.ProgressInterval == 0)
+			Options.ProgressInterval = 5;
+	}
+#ifdef TRACING
+	else if (Option.starts_with(L"--trace="))
+	{
+		const auto Path{ Option.substr(std::wstring_view{ L"--trace=" }.size()) };
+		if (Path.empty())
+			return false;
+
+		StartTracing(Path);
+	}
+#endif
+	else
+		return false;
+
+	return true;
+}
+
 int wmain(const int argc, const wchar_t* const* const argv)
 {
 	std::ios_base::sync_with_stdio(false);
 
+	// In a traced build, the spans recorded are written out on the way out, whichever way that is.
+	TRACE_SESSION(Session);
+
 	std::setlocale(LC_CTYPE, ".UTF8");
 	SetConsoleOutputCP(CP_UTF8);
 	SetConsoleCP(CP_UTF8);
 
-	std::hex(std::wcout);
-	std::showbase(std::wcout);
+	// Separate the options from the paths of the files to scan.
+	SCAN_OPTIONS Options;
+	DISPLAY_OPTIONS DisplayOptions;
+	WATCH_OPTIONS WatchOptions;
+	bool Verify{ false };
+	bool Benchmark{ false };
+	std::vector<std::filesystem::path> Binary_Filepaths;
+	std::vector<std::wstring_view> UnrecognizedOptions;
+	for (int ArgumentNumber{ 1 }; ArgumentNumber < argc; ++ArgumentNumber)
+	{
+		const std::wstring_view Argument{ argv[ArgumentNumber] };
+		if (Argument.starts_with(L"--"))
+		{
+			if (ParseOption(Argument, Options, DisplayOptions, WatchOptions, Verify, Benchmark) == false)
+				UnrecognizedOptions.push_back(Argument);
+		}
+		else
+			Binary_Filepaths.emplace_back(Argument);
+	}
+
+	// A watch goes on for as long as the process does, so its findings can only be written as records, which get the standard output to themselves.
+	if (WatchOptions.Watch)
+	{
+		DisplayOptions.Format = REPORT_FORMAT::NDJSON;
+		Options.StandardOutput = STANDARD_OUTPUT_MODE::NONE;
+	}
+
+	// Checking files writes nothing but the report.
+	if (Verify)
+		Options.StandardOutput = STANDARD_OUTPUT_MODE::NONE;
+
+	// Machine-readable records get the standard output to themselves, unless the files found are written to it; then everything else goes to the standard error stream.
+	const bool StandardOutput{ Options.StandardOutput != STANDARD_OUTPUT_MODE::NONE };
+	auto& Console{ ((DisplayOptions.Format == REPORT_FORMAT::HUMAN) && (StandardOutput == false)) ? std::wcout : std::wcerr };
+	FINDINGS_REPORT Report{ StandardOutput ? std::wcerr : std::wcout, DisplayOptions.Format };
+
+	if (StandardOutput)
+		PrepareStandardOutput();
+
+	std::hex(Console);
+	std::showbase(Console);
+
+	Console << L"" << std::endl << L"Be  Your  Own  GZIP" << std::endl << L"" << std::endl;
+
+	for (const auto& Option : UnrecognizedOptions)
+		Console << L"Unrecognized option, ignored:" << std::endl <<
+			L"   " << Option << std::endl;
+
+	if (Benchmark)
+	{
+		Console << L"Timing the variants of the kernels on this processor:" << std::endl << std::endl;
+
+		RunBenchmark(Console);
+
+		return 0;
+	}
+	else if (Verify && (Binary_Filepaths.size() > 0))
+	{
+		Console << L"Checking files as sequences of GZIP members:" << std::endl;
+		for (const auto& Binary_Filepath : Binary_Filepaths)
+			Console << L"   " << Binary_Filepath.wstring() << std::endl;
+		Console << std::endl;
+
+		// Like gzip -t, whose place it can take in scripts, the exit code tells whether every file was valid, and there is no prompt to wait for.
+		try
+		{
+			return (VerifyFiles(Binary_Filepaths, Options, WatchOptions.Workers, Console, Report, DisplayOptions.Format, DisplayOptions.Quiet) == 0) ? 0 : 1;
+		}
+		catch (std::exception ex)
+		{
+			Console << L"An error occured:" << std::endl <<
+				L"   ";
+			DisplayError(Console, ex);
 
-	std::wcout << L"" << std::endl << L"Be  Your  Own  GZIP" << std::endl << L"" << std::endl;
+			return 2;
+		}
+	}
+	else if (WatchOptions.Watch && (Binary_Filepaths.size() > 0))
+	{
+		for (const auto& Folder_Path : Binary_Filepaths)
+			if (std::filesystem::is_directory(Folder_Path) == false)
+			{
+				Console << L"Not a folder:" << std::endl <<
+					L"   " << Folder_Path.wstring() << std::endl;
+
+				return 1;
+			}
 
-	if (argc > 1)
+		Console << L"Watching folders for files to scan:" << std::endl;
+		for (const auto& Folder_Path : Binary_Filepaths)
+			Console << L"   " << Folder_Path.wstring() << std::endl;
+		Console << std::endl;
+
+		try
+		{
+			WatchFolders(Binary_Filepaths, Options, WatchOptions);
+		}
+		catch (std::exception ex)
+		{
+			Console << L"An error occured:" << std::endl <<
+				L"   ";
+			DisplayError(Console, ex);
+
+			return 1;
+		}
+
+		return 0;
+	}
+	else if (Binary_Filepaths.size() > 0)
 	{
-		for (int BinaryFileNumber{ 1 }; BinaryFileNumber < argc; ++BinaryFileNumber)
+		for (const auto& Binary_Filepath : Binary_Filepaths)
 		{
-			std::wcout << L"" << std::endl;
+			Console << L"" << std::endl;
 
-			const std::filesystem::path Binary_Filepath{ argv[BinaryFileNumber] };
-			if (std::filesystem::is_regular_file(Binary_Filepath))
+			const bool Device{ IsDevicePath(Binary_Filepath) };
+			if (Device || std::filesystem::is_regular_file(Binary_Filepath))
 			{
-				std::wcout << L"Scanning a file for GZIPs:" << std::endl <<
+				Console << L"Scanning a file for GZIPs:" << std::endl <<
 					L"   " << Binary_Filepath.wstring() << std::endl << std::endl;
 
 				const auto ParentDirectory{ Binary_Filepath.parent_path() };
-				const std::filesystem::path BaseFolderName{ Binary_Filepath.wstring() + L"_GZIP" };
+				// A device has no folder of its own to write to; its files are written to the current folder instead.
+				const std::filesystem::path BaseFolderName{ Device ? (std::filesystem::current_path() / (GetDeviceName(Binary_Filepath) + L"_GZIP")) : std::filesystem::path{ Binary_Filepath.wstring() + L"_GZIP" } };
 
 				auto FolderName{ BaseFolderName };
 				for (int Suffix{ 1 }; ; ++Suffix)
 					if (Suffix > 10)
 					{
-						std::wcout << L"Could not create a folder: " << std::endl <<
+						Console << L"Could not create a folder: " << std::endl <<
 							L"   " << BaseFolderName.wstring() << std::endl <<
 							L"Too many items with that name already exist." << std::endl;
 
 						break;
 					}
-					else if (std::filesystem::exists(FolderName))
+					// An interrupted scan is resumed in the folder it left its checkpoint in.
+					else if (std::filesystem::exists(FolderName) && ((Options.Resume == false) || (std::filesystem::exists(FolderName / CheckpointFileName) == false)))
 					{
 						FolderName = BaseFolderName.wstring() + L"(" + std::to_wstring(Suffix) + L")";
 
@@ -68,63 +550,40 @@ int wmain(const int argc, const wchar_t* const* const argv)
 					{ 
 						try
 						{
-							auto Findings{ ExtractGZIPs(Binary_Filepath, FolderName) };
-
-							std::wcout << L"Occurrences of the magic word 0x1F 8B found in the file: " << std::to_wstring(Findings.size()) << std::endl;
-							if (Findings.size() > 0)
-							{
-								size_t HeadersFound{ 0 }, FilesFound{ 0 };
-								for (const auto& e : Findings)
-									if (e.ValidHeader)
-									{
-										++HeadersFound;
-										if (e.ValidFile)
-											++FilesFound;
-									}
-
-								std::wcout << L"   Of those, found to be part of a valid GZIP header: " << std::to_wstring(HeadersFound) << std::endl;
-
-								if (HeadersFound > 0)
-								{
-									std::wcout << L"      At these addresses:" << std::endl;
-
-									auto it{ Findings.begin() };
-									do
-									{
-										while (it->ValidHeader == false)
-											++it;
-
-										std::wcout << L"      " << std::setw(20) << std::to_wstring(it->Position) << L"   (" << it->Position << L")" << std::endl;
-									} while (++it, --HeadersFound > 0);
-
-									if (FilesFound > 0)
-									{
-										std::wcout << L"         Of those, found to be part of a valid GZIP file and extracted: " << std::to_wstring(FilesFound) << std::endl;
-									}
-									else
-										std::wcout << L"         Of those, none were found to be part of a valid GZIP file." << std::endl;
-								}
-							}
+							// Only the addresses displayed in human-readable form are kept until the end of the scan; records are written as they come.
+							const bool HumanReadable{ DisplayOptions.Format == REPORT_FORMAT::HUMAN };
+							DISPLAYED_FINDINGS Findings{ Binary_Filepath, (HumanReadable || DisplayOptions.Quiet) ? nullptr : &Report, HumanReadable && (DisplayOptions.Quiet == false) };
+
+							ExtractGZIPs(Binary_Filepath, FolderName, Findings, Options);
+
+							Report.Flush();
+
+							for (const auto& Text : FORMAT_TEXTS)
+								if (Options.Formats & SignatureFormatBit(Text.Format))
+									DisplayFindings(Console, Findings.Summary.GetFormatSummary(Text.Format), Text, DisplayOptions.Quiet);
+
+							Console.flush();
 
 							break;
 						}
 						catch (std::exception ex)
 						{
-							std::wcout << L"An error occured:" << std::endl <<
+							Console << L"An error occured:" << std::endl <<
 								L"   ";
-							DisplayError(ex);
-							system("pause");
+							DisplayError(Console, ex);
+							if (StandardOutput == false)
+								system("pause");
 
 							return 1;
 						}
 					}
 			}
 			else
-				std::wcout << L"Not a file:" << std::endl <<
+				Console << L"Not a file:" << std::endl <<
 					L"   " << Binary_Filepath.wstring() << std::endl << std::endl;
 		}
 
-		std::wcout << L"" << std::endl;
+		Console << L"" << std::endl;
 	}
 	else
 	{
@@ -151,13 +610,54 @@ int wmain(const int argc, const wchar_t* const* const argv)
 			delete[] NameBuffer;
 		}
 
-		std::wcout << L"This application will scan given files for any GZIP files within, and extract them." << std::endl << std::endl <<
+		Console << L"This application will scan given files (or block devices, such as \\\\.\\PhysicalDrive0) for any GZIP files (and ZLIB streams and ZIP entries) within, and extract them." << std::endl << std::endl <<
 			L"To use, pass the paths to the files you wish to scan as arguments:" << std::endl <<
-			L"   " << ExecutableName << L" FILEPATH1 [FILEPATH2] [...]" << std::endl << std::endl <<
+			L"   " << ExecutableName << L" [OPTIONS] FILEPATH1 [FILEPATH2] [...]" << std::endl <<
+			L"   " << ExecutableName << L" [OPTIONS] --watch FOLDER1 [FOLDER2] [...]" << std::endl <<
+			L"   " << ExecutableName << L" [OPTIONS] --verify PATH1 [PATH2] [...]" << std::endl <<
+			L"   " << ExecutableName << L" [--force-isa=NAME] --benchmark" << std::endl << std::endl <<
+			L"Options:" << std::endl <<
+			L"   --validation=full         Inflate every candidate and check both the CRC32 and the size in its footer (default)." << std::endl <<
+			L"   --validation=structural   Check only the structure of the compressed data and the size in the footer; faster, but skips the CRC32." << std::endl <<
+			L"   --formats=LIST            Look only for the formats in the comma-separated LIST: GZIP, ZLIB, ZIP, BASE64 (default: GZIP, ZLIB and ZIP)." << std::endl <<
+			L"   --base64                  Also look for GZIPs encoded in base64 text, as in logs, JSON and e-mails, starting with H4sI; they are reported at the offset of the text, and extracted decoded." << std::endl <<
+			L"   --threads=N               Validate a large GZIP member or ZIP entry with up to N threads; 0 means one per processor (default: 1)." << std::endl <<
+			L"   --recover                 Decode as much as possible of damaged GZIP members, skipping over the damage, and write it with a report." << std::endl <<
+			L"   --dedup                   Write a GZIP member identical to one already extracted only once, listing the copies in duplicates.csv." << std::endl <<
+			L"   --offset=OFFSET           Start looking for signatures at OFFSET (K, M and G suffixes allowed)." << std::endl <<
+			L"   --length=SIZE             Look for signatures only within SIZE bytes from the offset; the files found are still followed past them." << std::endl <<
+			L"   --max-compressed=SIZE     Abandon a candidate once more than SIZE bytes of its compressed data have been read (K, M and G suffixes allowed)." << std::endl <<
+			L"   --max-decompressed=SIZE   Abandon a candidate once it has decompressed to more than SIZE bytes." << std::endl <<
+			L"   --max-ratio=N             Abandon a candidate once it has decompressed to more than N bytes per compressed byte." << std::endl <<
+			L"   --max-header-string=SIZE  Abandon a GZIP candidate whose file name or comment is longer than SIZE bytes." << std::endl <<
+			L"   --name=PATTERN            Extract only the GZIP members whose recorded file name matches PATTERN, in which * and ? are wildcards; checked before inflating." << std::endl <<
+			L"   --mtime=FROM-TO           Extract only the GZIP members whose recorded time is within FROM and TO, in seconds since 1970, either of which may be left out." << std::endl <<
+			L"   --os=N                    Extract only the GZIP members whose OS byte is N, such as 3 for Unix or 11 for NTFS; checked before inflating." << std::endl <<
+			L"   --min-size=SIZE           Extract only the GZIP members at least SIZE bytes long; as the header does not record it, checked after validating." << std::endl <<
+			L"   --recursive[=DEPTH]       Scan the decompressed data of every GZIP member found, in memory, for nested files, up to DEPTH levels deep (default: 3)." << std::endl <<
+			L"   --checkpoint=SECONDS      Write a checkpoint of the scan to its output folder every SECONDS seconds (default: 60); 0 turns checkpoints off." << std::endl <<
+			L"   --resume                  Carry on with an interrupted scan from the checkpoint it left in its output folder." << std::endl <<
+			L"   --progress[=SECONDS]      Report the offset, throughput, files found and time left every SECONDS seconds (default: 5) on stderr." << std::endl <<
+			L"   --status-file=PATH        Write the progress reports to PATH instead, replacing its content with every report." << std::endl <<
+			L"   --output=FORMAT           Display the findings as human (default), csv or ndjson; csv and ndjson records go to stdout as they are found, everything else to stderr." << std::endl <<
+			L"   --quiet                   Display only the statistics, not the address or record of every finding." << std::endl <<
+			L"   --stdout[=MODE]           Write the files found to stdout, and all else to stderr: framed (default), each after a line with its path and size; concat, GZIP members only, as one multi-member GZIP; or inflated, their decompressed data, framed." << std::endl <<
+			L"   --watch                   Treat the paths as folders to watch: scan the files in them, and then every file added or written to, as NDJSON records." << std::endl <<
+			L"   --workers=N               Scan up to N watched files, or check up to N files, at the same time (default: 0, one per processor)." << std::endl <<
+			L"   --spool=FOLDER            Write the records of every scan of a watched file to a file of their own in FOLDER, and extract the files there." << std::endl <<
+			L"   --verify                  Check that the files, or those in the folders, are made of valid GZIP members from start to end, as gzip -t does, writing nothing." << std::endl <<
+			L"   --force-isa=NAME          Use the variants of the scan, CRC32, copy and base64 kernels for the instruction set NAME: generic, sse2, sse4.2, avx2 or avx512, if supported (default: the best supported)." << std::endl <<
+			L"   --benchmark               Time every variant of those kernels that the processor supports, and display which ones are used." << std::endl <<
+#ifdef TRACING
+			L"   --trace=PATH              Record the time spent on every chunk, candidate, header, DEFLATE block, CRC32 check and write, and save it to PATH for Perfetto." << std::endl <<
+#endif
+			std::endl <<
 			L"Originally coded by MKCA in 2024." << std::endl << L"This is version " << APPLICATION_VERSION << L" of the application." << std::endl << std::endl;
 	}
 
-	system("pause");
+	// The prompt would end up among the files written to the standard output.
+	if (StandardOutput == false)
+		system("pause");
 
 	return 0;
 }
\ No newline at end of file